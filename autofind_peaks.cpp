@@ -0,0 +1,460 @@
+/*
+ *  autofind_peaks.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "autofind_peaks.h"
+#include "parallel_for.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+void FloatImg::Init(int w, int h)
+{
+    delete[] px;
+    width = w;
+    height = h;
+    NPixels = width * height;
+    px = new float[NPixels];
+}
+
+void FloatImg::Swap(FloatImg& other)
+{
+    std::swap(px, other.px);
+    std::swap(width, other.width);
+    std::swap(height, other.height);
+    std::swap(NPixels, other.NPixels);
+}
+
+// formats a diagnostic message for the caller's log
+static void Log(AutoFindLog log, const char *fmt, ...)
+{
+    if (!log)
+        return;
+
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+
+    log(buf);
+}
+
+static void GetStats(double *mean, double *stdev, const FloatImg& img, int left, int top, int w, int h)
+{
+    // Determine the mean and standard deviation
+    double sum = 0.0;
+    double a = 0.0;
+    double q = 0.0;
+    double k = 1.0;
+    double km1 = 0.0;
+
+    const int width = img.width;
+    const float *p0 = &img.px[top * width + left];
+    for (int y = 0; y < h; y++)
+    {
+        const float *end = p0 + w;
+        for (const float *p = p0; p < end; p++)
+        {
+            double const x = (double) *p;
+            sum += x;
+            double const a0 = a;
+            a += (x - a) / k;
+            q += (x - a0) * (x - a);
+            km1 = k;
+            k += 1.0;
+        }
+        p0 += width;
+    }
+
+    *mean = sum / km1;
+    *stdev = sqrt(q / km1);
+}
+
+static void psf_conv(FloatImg& dst, const FloatImg& src)
+{
+    dst.Init(src.width, src.height);
+
+    //                       A      B1     B2    C1     C2    C3     D1     D2     D3
+    const double PSF[] = { 0.906, 0.584, 0.365, .117, .049, -0.05, -.064, -.074, -.094 };
+
+    int const width = src.width;
+    int const height = src.height;
+
+    memset(dst.px, 0, src.NPixels * sizeof(float));
+
+    /* PSF Grid is:
+    D3 D3 D3 D3 D3 D3 D3 D3 D3
+    D3 D3 D3 D2 D1 D2 D3 D3 D3
+    D3 D3 C3 C2 C1 C2 C3 D3 D3
+    D3 D2 C2 B2 B1 B2 C2 D2 D3
+    D3 D1 C1 B1 A  B1 C1 D1 D3
+    D3 D2 C2 B2 B1 B2 C2 D2 D3
+    D3 D3 C3 C2 C1 C2 C3 D3 D3
+    D3 D3 D3 D2 D1 D2 D3 D3 D3
+    D3 D3 D3 D3 D3 D3 D3 D3 D3
+
+    1@A
+    4@B1, B2, C1, C3, D1
+    8@C2, D2
+    44 * D3
+    */
+
+    int psf_size = 4;
+
+    // rows are independent, so the convolution is split into stripes of rows, each
+    // run on its own core; the stripes read the rows above and below them from the
+    // shared source image
+    enum { MIN_STRIPE_ROWS = 32 };
+
+    ParallelFor(height - 2 * psf_size, MIN_STRIPE_ROWS, [&](int y0, int y1) {
+        for (int y = psf_size + y0; y < psf_size + y1; y++)
+        {
+            for (int x = psf_size; x < width - psf_size; x++)
+            {
+                float A, B1, B2, C1, C2, C3, D1, D2, D3;
+
+#define PX(dx, dy) *(src.px + width * (y + (dy)) + x + (dx))
+                A =  PX(+0, +0);
+                B1 = PX(+0, -1) + PX(+0, +1) + PX(+1, +0) + PX(-1, +0);
+                B2 = PX(-1, -1) + PX(+1, -1) + PX(-1, +1) + PX(+1, +1);
+                C1 = PX(+0, -2) + PX(-2, +0) + PX(+2, +0) + PX(+0, +2);
+                C2 = PX(-1, -2) + PX(+1, -2) + PX(-2, -1) + PX(+2, -1) + PX(-2, +1) + PX(+2, +1) + PX(-1, +2) + PX(+1, +2);
+                C3 = PX(-2, -2) + PX(+2, -2) + PX(-2, +2) + PX(+2, +2);
+                D1 = PX(+0, -3) + PX(-3, +0) + PX(+3, +0) + PX(+0, +3);
+                D2 = PX(-1, -3) + PX(+1, -3) + PX(-3, -1) + PX(+3, -1) + PX(-3, +1) + PX(+3, +1) + PX(-1, +3) + PX(+1, +3);
+                D3 = PX(-4, -2) + PX(-3, -2) + PX(+3, -2) + PX(+4, -2) + PX(-4, -1) + PX(+4, -1) + PX(-4, +0) + PX(+4, +0) + PX(-4, +1) + PX(+4, +1) + PX(-4, +2) + PX(-3, +2) + PX(+3, +2) + PX(+4, +2);
+#undef PX
+                int i;
+                const float *uptr;
+
+                uptr = src.px + width * (y - 4) + (x - 4);
+                for (i = 0; i < 9; i++)
+                    D3 += *uptr++;
+
+                uptr = src.px + width * (y - 3) + (x - 4);
+                for (i = 0; i < 3; i++)
+                    D3 += *uptr++;
+                uptr += 3;
+                for (i = 0; i < 3; i++)
+                    D3 += *uptr++;
+
+                uptr = src.px + width * (y + 3) + (x - 4);
+                for (i = 0; i < 3; i++)
+                    D3 += *uptr++;
+                uptr += 3;
+                for (i = 0; i < 3; i++)
+                    D3 += *uptr++;
+
+                uptr = src.px + width * (y + 4) + (x - 4);
+                for (i = 0; i < 9; i++)
+                    D3 += *uptr++;
+
+                double mean = (A + B1 + B2 + C1 + C2 + C3 + D1 + D2 + D3) / 81.0;
+                double PSF_fit = PSF[0] * (A - mean) + PSF[1] * (B1 - 4.0 * mean) + PSF[2] * (B2 - 4.0 * mean) +
+                    PSF[3] * (C1 - 4.0 * mean) + PSF[4] * (C2 - 8.0 * mean) + PSF[5] * (C3 - 4.0 * mean) +
+                    PSF[6] * (D1 - 4.0 * mean) + PSF[7] * (D2 - 8.0 * mean) + PSF[8] * (D3 - 44.0 * mean);
+
+                dst.px[width * y + x] = (float) PSF_fit;
+            }
+        }
+    });
+}
+
+static void Downsample(FloatImg& dst, const FloatImg& src, int downsample)
+{
+    int width = src.width;
+    int dw = src.width / downsample;
+    int dh = src.height / downsample;
+
+    dst.Init(dw, dh);
+
+    float const d2 = downsample * downsample;
+
+    ParallelFor(dh, 64, [&](int yy0, int yy1) {
+        for (int yy = yy0; yy < yy1; yy++)
+        {
+            for (int xx = 0; xx < dw; xx++)
+            {
+                float sum = 0.0;
+                for (int j = 0; j < downsample; j++)
+                    for (int i = 0; i < downsample; i++)
+                        sum += src.px[(yy * downsample + j) * width + xx * downsample + i];
+                float val = sum / d2;
+                dst.px[yy * dw + xx] = val;
+            }
+        }
+    });
+}
+
+void AutoFindConvolve(FloatImg& conv, const unsigned short *image, int width, int height, int downsample)
+{
+    // convert to floating point
+    conv.Init(width, height);
+    ParallelFor(conv.NPixels, 1 << 18, [&](int i0, int i1) {
+        for (int i = i0; i < i1; i++)
+            conv.px[i] = (float) image[i];
+    });
+
+    // downsample the source image
+    if (downsample > 1)
+    {
+        FloatImg tmp;
+        Downsample(tmp, conv, downsample);
+        conv.Swap(tmp);
+    }
+
+    // run the PSF convolution
+    {
+        FloatImg tmp;
+        psf_conv(tmp, conv);
+        conv.Swap(tmp);
+    }
+}
+
+static void RemoveItems(std::set<AutoFindPeak>& stars, const std::set<int>& to_erase)
+{
+    int n = 0;
+    for (std::set<AutoFindPeak>::iterator it = stars.begin(); it != stars.end(); n++)
+    {
+        if (to_erase.find(n) != to_erase.end())
+        {
+            std::set<AutoFindPeak>::iterator next = it;
+            ++next;
+            stars.erase(it);
+            it = next;
+        }
+        else
+            ++it;
+    }
+}
+
+void AutoFindPeaks(std::set<AutoFindPeak>& stars, const FloatImg& conv, int downsample, int width, int height,
+                   int searchRegion, int edgeDist, AutoFindLog log)
+{
+    enum { CONV_RADIUS = 4 };
+    int dw = conv.width;      // width of the downsampled image
+    int dh = conv.height;     // height of the downsampled image
+
+    // region containing valid data
+    int const convLeft = CONV_RADIUS;
+    int const convTop = CONV_RADIUS;
+    int const convWidth = dw - 2 * CONV_RADIUS;
+    int const convHeight = dh - 2 * CONV_RADIUS;
+    int const convRight = convLeft + convWidth - 1;
+    int const convBottom = convTop + convHeight - 1;
+
+    enum { TOP_N = 100 };  // keep track of the brightest stars
+    stars.clear();         // sorted by ascending intensity
+
+    double global_mean, global_stdev;
+    GetStats(&global_mean, &global_stdev, conv, convLeft, convTop, convWidth, convHeight);
+
+    Log(log, "AutoFind: global mean = %.1f, stdev %.1f\n", global_mean, global_stdev);
+
+    const double threshold = 0.1;
+    Log(log, "AutoFind: using threshold = %.1f\n", threshold);
+
+    // find each local maximum
+    //
+    // A pixel is a local maximum when no pixel in the surrounding 9x9 box is
+    // brighter, that is when it is equal to the 9x9 max filter of the image at that
+    // point. The max filter is separable and is computed as a horizontal pass into
+    // rowmax followed by a vertical pass in the scan below. Rows are processed in
+    // parallel stripes; the candidates are collected per row and merged in raster
+    // order afterwards so the result does not depend on how the rows were split.
+    enum { MIN_STRIPE_ROWS = 32 };
+    int srch = 4;
+    int const scanTop = convTop + srch;
+    int const scanBot = convBottom - srch;
+    int const scanLeft = convLeft + srch;
+    int const scanRight = convRight - srch;
+
+    FloatImg rowmax(conv.width, conv.height);
+    ParallelFor(convHeight, MIN_STRIPE_ROWS, [&](int r0, int r1) {
+        for (int y = convTop + r0; y < convTop + r1; y++)
+        {
+            const float *src = &conv.px[dw * y];
+            float *dst = &rowmax.px[dw * y];
+            for (int x = scanLeft; x <= scanRight; x++)
+            {
+                float m = src[x - srch];
+                for (int i = -srch + 1; i <= srch; i++)
+                    if (src[x + i] > m)
+                        m = src[x + i];
+                dst[x] = m;
+            }
+        }
+    });
+
+    std::vector<std::vector<AutoFindPeak>> rowPeaks(std::max(0, scanBot - scanTop + 1));
+    ParallelFor((int) rowPeaks.size(), MIN_STRIPE_ROWS, [&](int r0, int r1) {
+        for (int r = r0; r < r1; r++)
+        {
+            int const y = scanTop + r;
+            for (int x = scanLeft; x <= scanRight; x++)
+            {
+                float val = conv.px[dw * y + x];
+                if (!(val > 0.0))
+                    continue;
+
+                bool ismax = true;
+                for (int j = -srch; j <= srch; j++)
+                {
+                    if (rowmax.px[dw * (y + j) + x] > val)
+                    {
+                        ismax = false;
+                        break;
+                    }
+                }
+                if (!ismax)
+                    continue;
+
+                // compare local maximum to mean value of surrounding pixels
+                const int local = 7;
+                double local_mean, local_stdev;
+                int const lx0 = std::max(x - local, convLeft);
+                int const ly0 = std::max(y - local, convTop);
+                int const lx1 = std::min(x + local, convRight);
+                int const ly1 = std::min(y + local, convBottom);
+                GetStats(&local_mean, &local_stdev, conv, lx0, ly0, lx1 - lx0 + 1, ly1 - ly0 + 1);
+
+                // this is our measure of star intensity
+                double h = (val - local_mean) / global_stdev;
+
+                if (h < threshold)
+                    continue;
+
+                // coordinates on the original image
+                int imgx = x * downsample + downsample / 2;
+                int imgy = y * downsample + downsample / 2;
+
+                rowPeaks[r].push_back(AutoFindPeak(imgx, imgy, h));
+            }
+        }
+    });
+
+    for (const auto& row : rowPeaks)
+    {
+        for (const AutoFindPeak& peak : row)
+        {
+            stars.insert(peak);
+            if (stars.size() > TOP_N)
+                stars.erase(stars.begin());
+        }
+    }
+
+    for (std::set<AutoFindPeak>::const_reverse_iterator it = stars.rbegin(); it != stars.rend(); ++it)
+        Log(log, "AutoFind: local max [%d, %d] %.1f\n", it->x, it->y, it->val);
+
+    // merge stars that are very close into a single star
+    {
+        const int minlimitsq = 5 * 5;
+    repeat:
+        for (std::set<AutoFindPeak>::const_iterator a = stars.begin(); a != stars.end(); ++a)
+        {
+            std::set<AutoFindPeak>::const_iterator b = a;
+            ++b;
+            for (; b != stars.end(); ++b)
+            {
+                int dx = a->x - b->x;
+                int dy = a->y - b->y;
+                int d2 = dx * dx + dy * dy;
+                if (d2 < minlimitsq)
+                {
+                    // very close, treat as single star
+                    Log(log, "AutoFind: merge [%d, %d] %.1f - [%d, %d] %.1f\n", a->x, a->y, a->val, b->x, b->y, b->val);
+                    // erase the dimmer one
+                    stars.erase(a);
+                    goto repeat;
+                }
+            }
+        }
+    }
+
+    // exclude stars that would fit within a single searchRegion box
+    {
+        // build a list of stars to be excluded
+        std::set<int> to_erase;
+        const int extra = 5; // extra safety margin
+        const int fullw = searchRegion + extra;
+        for (std::set<AutoFindPeak>::const_iterator a = stars.begin(); a != stars.end(); ++a)
+        {
+            std::set<AutoFindPeak>::const_iterator b = a;
+            ++b;
+            for (; b != stars.end(); ++b)
+            {
+                int dx = abs(a->x - b->x);
+                int dy = abs(a->y - b->y);
+                if (dx <= fullw && dy <= fullw)
+                {
+                    // stars closer than search region, exclude them both
+                    // but do not let a very dim star eliminate a very bright star
+                    if (b->val / a->val >= 5.0)
+                    {
+                        Log(log, "AutoFind: close dim-bright [%d, %d] %.1f - [%d, %d] %.1f\n", a->x, a->y, a->val, b->x, b->y, b->val);
+                    }
+                    else
+                    {
+                        Log(log, "AutoFind: too close [%d, %d] %.1f - [%d, %d] %.1f\n", a->x, a->y, a->val, b->x, b->y, b->val);
+                        to_erase.insert(std::distance(stars.begin(), a));
+                        to_erase.insert(std::distance(stars.begin(), b));
+                    }
+                }
+            }
+        }
+        RemoveItems(stars, to_erase);
+    }
+
+    // exclude stars too close to the edge
+    {
+        std::set<AutoFindPeak>::iterator it = stars.begin();
+        while (it != stars.end())
+        {
+            std::set<AutoFindPeak>::iterator next = it;
+            ++next;
+            if (it->x <= edgeDist || it->x >= width - edgeDist ||
+                it->y <= edgeDist || it->y >= height - edgeDist)
+            {
+                Log(log, "AutoFind: too close to edge [%d, %d] %.1f\n", it->x, it->y, it->val);
+                stars.erase(it);
+            }
+            it = next;
+        }
+    }
+}
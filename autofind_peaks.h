@@ -0,0 +1,88 @@
+/*
+ *  autofind_peaks.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef AUTOFIND_PEAKS_INCLUDED
+#define AUTOFIND_PEAKS_INCLUDED
+
+#include <set>
+
+//
+// The image side of GuideStar::AutoFind: convolve the median filtered frame with
+// a star-like PSF, after downsampling it if asked to, and pick out the brightest
+// local maxima that are far enough from each other and from the frame edges to be
+// guide star candidates. There are no wxWidgets types here so the pipeline can be
+// tested on its own; AutoFind measures the candidates with Star::Find and picks
+// the guide star.
+//
+
+struct FloatImg
+{
+    float *px;
+    int width;
+    int height;
+    unsigned int NPixels;
+
+    FloatImg() : px(0) { }
+    FloatImg(int w, int h) : px(0) { Init(w, h); }
+    ~FloatImg() { delete[] px; }
+    void Init(int w, int h);
+    void Swap(FloatImg& other);
+};
+
+struct AutoFindPeak
+{
+    int x;
+    int y;
+    float val;
+
+    AutoFindPeak() { }
+    AutoFindPeak(int x_, int y_, float val_) : x(x_), y(y_), val(val_) { }
+    bool operator<(const AutoFindPeak& rhs) const { return val < rhs.val; }
+};
+
+// receives the diagnostic messages, one line each
+typedef void (*AutoFindLog)(const char *msg);
+
+// conv is the PSF convolution of the width x height image, downsampled by the
+// given factor first when it is more than 1
+extern void AutoFindConvolve(FloatImg& conv, const unsigned short *image, int width, int height, int downsample);
+
+// The candidate stars among the local maxima of conv, in the coordinates of the
+// width x height image it was made from, sorted by ascending brightness. Pairs of
+// stars within searchRegion of each other are dropped, as are stars within
+// edgeDist of the frame edges. log may be null.
+extern void AutoFindPeaks(std::set<AutoFindPeak>& stars, const FloatImg& conv, int downsample, int width, int height,
+                          int searchRegion, int edgeDist, AutoFindLog log);
+
+#endif // AUTOFIND_PEAKS_INCLUDED
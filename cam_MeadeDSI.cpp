@@ -61,6 +61,7 @@ public:
     bool   EnumCameras(wxArrayString& names, wxArrayString& ids) override;
     bool   Capture(int duration, usImage& img, int options, const wxRect& subframe) override;
     bool   HasNonGuiCapture() override;
+    bool   HasPostDarkTransform() override { return MeadeCam && (MeadeCam->IsColor || MeadeCam->IsDsiII); }
     wxByte BitsPerPixel() override;
     bool   Connect(const wxString& camId) override;
     bool   Disconnect() override;
@@ -44,6 +44,7 @@ public:
     bool    Capture(int duration, usImage& img, int options, const wxRect& subframe) override;
     bool    Connect(const wxString& camId) override;
     bool    Disconnect() override;
+    bool    HasPostDarkTransform() override { return Color; }
     wxByte  BitsPerPixel() override;
 };
 
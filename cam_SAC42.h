@@ -52,6 +52,7 @@ public:
     bool   Disconnect() override;
     void   InitCapture() override;
     bool HasNonGuiCapture() override { return true; }
+    bool HasPostDarkTransform() override { return ColorArray; }
     wxByte BitsPerPixel() override;
 };
 
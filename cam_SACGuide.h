@@ -60,6 +60,7 @@ public:
     bool    Connect(const wxString& camId) override;
     bool    Disconnect() override;
     void    InitCapture() override;
+    bool    HasPostDarkTransform() override { return true; }
 
     bool    SetGlobalGain(unsigned char gain);
     bool    ST4PulseGuideScope(int direction, int duration) override;
@@ -59,6 +59,7 @@ public:
     bool   Connect(const wxString& camId) override;
     bool   Disconnect() override;
     bool HasNonGuiCapture() override { return true; }
+    bool HasPostDarkTransform() override { return true; }
     wxByte BitsPerPixel() override;
 };
 
@@ -76,6 +76,7 @@ public:
 
     bool    Capture(int duration, usImage& img, int options, const wxRect& subframe) override;
     bool    HasNonGuiCapture() override;
+    bool    HasPostDarkTransform() override { return Color; }
     bool    Connect(const wxString& camId) override;
     bool    Disconnect() override;
     void    ShowPropertyDialog() override;
@@ -58,6 +58,7 @@ public:
     bool    EnumCameras(wxArrayString& names, wxArrayString& ids) override;
     bool    Capture(int duration, usImage& img, int options, const wxRect& subframe) override;
     bool    HasNonGuiCapture() override;
+    bool    HasPostDarkTransform() override { return Color; }
     bool    Connect(const wxString& camId) override;
     bool    Disconnect() override;
 
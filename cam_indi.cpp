@@ -137,6 +137,7 @@ public:
     bool    Connect(const wxString& camId) override;
     bool    Disconnect() override;
     bool    HasNonGuiCapture() override;
+    bool    HasPostDarkTransform() override { return HasBayer || PixSizeX != PixSizeY; }
     wxByte  BitsPerPixel() override;
     bool    GetDevicePixelSize(double *pixSize) override;
     void    ShowPropertyDialog() override;
@@ -357,6 +357,7 @@ public:
 
     void ShowPropertyDialog() override;
     bool HasNonGuiCapture() override { return true; }
+    bool HasPostDarkTransform() override { return m_isColor; }
     bool ST4HasGuideOutput() override;
     bool ST4HasNonGuiMove() override { return true; }
     bool ST4PulseGuideScope(int direction, int duration) override;
@@ -70,6 +70,7 @@ public:
     bool ST4PulseGuideScope(int direction, int duration) override;
 
     bool HasNonGuiCapture() override { return true; }
+    bool HasPostDarkTransform() override { return Color; }
     bool ST4HasNonGuiMove() override { return true; }
     wxByte BitsPerPixel() override;
     bool GetDevicePixelSize(double *devPixelSize) override;
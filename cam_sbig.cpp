@@ -72,6 +72,7 @@ public:
     bool ST4PulseGuideScope(int direction, int duration) override;
     bool ST4HasNonGuiMove() override { return true; }
     bool HasNonGuiCapture() override { return true; }
+    bool HasPostDarkTransform() override { return IsColor; }
     wxByte BitsPerPixel() override;
     bool GetDevicePixelSize(double *devPixelSize) override;
 
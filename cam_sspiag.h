@@ -51,6 +51,7 @@ public:
     void    ClearGuidePort();
 
     bool HasNonGuiCapture() override { return true; }
+    bool HasPostDarkTransform() override { return true; }
     bool ST4HasNonGuiMove() override { return true; }
     wxByte BitsPerPixel() override;
 
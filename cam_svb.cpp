@@ -79,6 +79,7 @@ public:
 
     void ShowPropertyDialog() override;
     bool HasNonGuiCapture() override { return true; }
+    bool HasPostDarkTransform() override { return m_isColor; }
     bool ST4HasNonGuiMove() override { return true; }
     wxByte BitsPerPixel() override;
     bool GetDevicePixelSize(double *devPixelSize) override;
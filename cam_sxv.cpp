@@ -83,6 +83,7 @@ public:
     const wxSize& DarkFrameSize() override { return m_darkFrameSize; }
 
     bool HasNonGuiCapture() override { return true; }
+    bool HasPostDarkTransform() override { return Interlaced; }
     bool ST4HasNonGuiMove() override { return true; }
     bool ST4PulseGuideScope(int direction, int duration) override;
     wxByte BitsPerPixel() override;
@@ -352,6 +352,7 @@ public:
     bool CanSelectCamera() const override { return true; }
     bool EnumCameras(wxArrayString& names, wxArrayString& ids) override;
     bool HasNonGuiCapture() override;
+    bool HasPostDarkTransform() override { return m_cam.m_isColor; }
     wxByte BitsPerPixel() override;
     bool Capture(int duration, usImage&, int, const wxRect& subframe) override;
     bool Connect(const wxString& camId) override;
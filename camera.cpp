@@ -821,6 +821,8 @@ void CameraConfigDialogPane::LayoutControls(GuideCamera *pCamera, BrainCtrlIdMap
     pTopline->Add(GetSizerCtrl(CtrlMap, AD_szTimeLapse), wxSizerFlags(0).Border(wxLEFT, 110).Expand());
     pGenGroup->Add(pTopline, def_flags);
     pGenGroup->Add(GetSizerCtrl(CtrlMap, AD_szAutoExposure), def_flags);
+    pGenGroup->Add(GetSingleCtrl(CtrlMap, AD_cbPipelinedCapture), def_flags);
+    pGenGroup->Add(GetSingleCtrl(CtrlMap, AD_cbFusedPreprocessing), def_flags);
     pGenGroup->Layout();
 
     // Specific controls
@@ -1441,6 +1443,27 @@ void GuideCamera::SubtractDark(usImage& img)
     }
 }
 
+// Fused alternative to SubtractDark followed by the noise reduction and stats done
+// in the worker thread; the frame must have been captured without
+// CAPTURE_SUBTRACT_DARK
+// The single-pass preprocessing applies the dark and defect map to the frame as
+// the driver returns it, which lines up with the dark only if the driver does
+// not resize or resample the frame after dark subtraction
+bool GuideCamera::CanPreprocessFrame()
+{
+    return !HasPostDarkTransform() && DarkFrameSize() == FullSize;
+}
+
+void GuideCamera::PreprocessFrame(usImage& img, bool subtractDark, int noiseReduction)
+{
+    wxCriticalSectionLocker lck(DarkFrameLock);
+
+    const DefectMap *defectMap = subtractDark ? CurrentDefectMap : nullptr;
+    const usImage *dark = subtractDark ? CurrentDarkFrame : nullptr;
+
+    PreprocessImage(img, dark, defectMap, noiseReduction);
+}
+
 static void InitiateReconnect()
 {
     WorkerThread *thr = WorkerThread::This();
@@ -196,9 +196,14 @@ public:
     void            ClearDarks();
 
     void            SubtractDark(usImage& img);
+    void            PreprocessFrame(usImage& img, bool subtractDark, int noiseReduction);
     void            GetDarklibProperties(int *pNumDarks, double *pMinExp, double *pMaxExp);
 
     virtual const wxSize& DarkFrameSize() { return FullSize; }
+    // true if the driver resamples the frame after subtracting the dark
+    // (debayer, deinterlace, pixel squaring)
+    virtual bool HasPostDarkTransform() { return false; }
+    bool CanPreprocessFrame();
 
     static double GetProfilePixelSize();
 
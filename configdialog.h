@@ -65,6 +65,8 @@ enum BRAIN_CTRL_IDS
     AD_szSaturationOptions,
     AD_szCameraTimeout,
     AD_szTimeLapse,
+    AD_cbPipelinedCapture,
+    AD_cbFusedPreprocessing,
     AD_szPixelSize,
     AD_szGain,
     AD_szDelay,
@@ -74,6 +76,7 @@ enum BRAIN_CTRL_IDS
     AD_CAMERA_TAB_BOUNDARY,        // ------ end of camera tab controls
 
     AD_cbScaleImages,
+    AD_szDisplayMaxFps,
     AD_szFocalLength,
     AD_cbAutoRestoreCal,
     AD_cbFastRecenter,
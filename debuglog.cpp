@@ -37,20 +37,202 @@
 
 #include <wx/dir.h>
 
-#define ALWAYS_FLUSH_DEBUGLOG
+#include <exception>
+
 const int RetentionPeriod = 30;
 
+// How often the writer thread flushes the file, in milliseconds. Overridden by
+// the global setting /DebugLog/FlushInterval; 0 flushes after every write.
+static const int DefaultFlushInterval = 500;
+
+/*
+ * Bounded multi-producer queue of log records. Each slot carries a sequence
+ * number telling producers and the consumer whose turn it is (D. Vyukov's
+ * bounded queue), so pushing is a single compare-and-swap. Records are only
+ * consumed with DebugLog::m_criticalSection held, so there is one consumer at
+ * a time.
+ */
+class DebugLogQueue
+{
+public:
+    enum { SIZE = 1024, TEXT_SIZE = 232 };
+
+    struct Record
+    {
+        std::atomic<unsigned int> seq;
+        wxLongLong_t time;              // wxDateTime ticks
+        unsigned long threadId;
+        unsigned int len;
+        char *longText;                 // heap copy for text that does not fit in text[]
+        char text[TEXT_SIZE];
+
+        const char *Text() const { return longText ? longText : text; }
+    };
+
+private:
+    Record m_slots[SIZE];
+    std::atomic<unsigned int> m_pushPos;
+    std::atomic<unsigned int> m_popPos;
+
+public:
+    DebugLogQueue();
+    ~DebugLogQueue();
+
+    bool Push(wxLongLong_t time, unsigned long threadId, const char *text, unsigned int len);
+    Record *Front();
+    void Pop();
+    unsigned int Size() const;
+};
+
+DebugLogQueue::DebugLogQueue()
+    :
+    m_pushPos(0),
+    m_popPos(0)
+{
+    for (unsigned int i = 0; i < SIZE; i++)
+    {
+        m_slots[i].seq.store(i, std::memory_order_relaxed);
+        m_slots[i].longText = nullptr;
+    }
+}
+
+DebugLogQueue::~DebugLogQueue()
+{
+    while (Front())
+        Pop();
+}
+
+// returns false if the queue is full
+bool DebugLogQueue::Push(wxLongLong_t time, unsigned long threadId, const char *text, unsigned int len)
+{
+    Record *rec;
+    unsigned int pos = m_pushPos.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        rec = &m_slots[pos & (SIZE - 1)];
+        int diff = (int) (rec->seq.load(std::memory_order_acquire) - pos);
+        if (diff == 0)
+        {
+            if (m_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+            return false;
+        else
+            pos = m_pushPos.load(std::memory_order_relaxed);
+    }
+
+    rec->time = time;
+    rec->threadId = threadId;
+    rec->len = len;
+    if (len <= TEXT_SIZE)
+        rec->longText = nullptr;
+    else
+        rec->longText = new char[len];
+    memcpy(rec->longText ? rec->longText : rec->text, text, len);
+
+    rec->seq.store(pos + 1, std::memory_order_release);
+
+    return true;
+}
+
+// oldest record, or null if the queue is empty
+DebugLogQueue::Record *DebugLogQueue::Front()
+{
+    unsigned int pos = m_popPos.load(std::memory_order_relaxed);
+    Record *rec = &m_slots[pos & (SIZE - 1)];
+    return rec->seq.load(std::memory_order_acquire) == pos + 1 ? rec : nullptr;
+}
+
+void DebugLogQueue::Pop()
+{
+    unsigned int pos = m_popPos.load(std::memory_order_relaxed);
+    Record *rec = &m_slots[pos & (SIZE - 1)];
+    delete[] rec->longText;
+    rec->longText = nullptr;
+    rec->seq.store(pos + SIZE, std::memory_order_release);
+    m_popPos.store(pos + 1, std::memory_order_relaxed);
+}
+
+unsigned int DebugLogQueue::Size() const
+{
+    return m_pushPos.load(std::memory_order_relaxed) - m_popPos.load(std::memory_order_relaxed);
+}
+
+class DebugLogWriterThread : public wxThread
+{
+    DebugLog *m_log;
+    std::atomic<bool> m_stop;
+
+public:
+    DebugLogWriterThread(DebugLog *log);
+    void Stop();
+
+protected:
+    ExitCode Entry() override;
+};
+
+DebugLogWriterThread::DebugLogWriterThread(DebugLog *log)
+    :
+    wxThread(wxTHREAD_JOINABLE),
+    m_log(log),
+    m_stop(false)
+{
+}
+
+void DebugLogWriterThread::Stop()
+{
+    m_stop = true;
+    m_log->m_wakeup.Post();
+    Wait();
+}
+
+wxThread::ExitCode DebugLogWriterThread::Entry()
+{
+    // when flushing after every write the producers wake us up, otherwise we
+    // wake up once per flush interval or when the queue is half full
+    enum { IDLE_TIMEOUT = 1000 };
+
+    while (!m_stop)
+    {
+        m_log->m_wakeup.WaitTimeout(m_log->m_flushInterval > 0 ? m_log->m_flushInterval : IDLE_TIMEOUT);
+        m_log->DrainQueue(true);
+    }
+
+    return (ExitCode) 0;
+}
+
+// flush whatever is queued if the process is going down on an unhandled
+// exception; only FlushOnCrash is called since it never blocks on the log lock
+static std::terminate_handler s_prevTerminateHandler;
+
+static void DebugLogTerminateHandler()
+{
+    Debug.FlushOnCrash();
+
+    if (s_prevTerminateHandler)
+        s_prevTerminateHandler();
+    abort();
+}
+
 DebugLog::DebugLog()
     :
     m_enabled(false),
-    m_lastWriteTime(wxDateTime::UNow())
+    m_lastWriteTime(wxDateTime::UNow().GetValue().GetValue()),
+    m_queue(new DebugLogQueue()),
+    m_writer(nullptr),
+    m_async(false),
+    m_flushInterval(DefaultFlushInterval)
 {
 }
 
 DebugLog::~DebugLog()
 {
-    wxFFile::Flush();
+    StopWriter();
+    DrainQueue(true);
     wxFFile::Close();
+    delete m_queue;
 }
 
 static bool ParseLogTimestamp(wxDateTime *p, const wxString& s)
@@ -106,10 +288,15 @@ void DebugLog::InitDebugLog(bool enable, bool forceOpen)
 {
     const wxDateTime& logFileTime = wxGetApp().GetLogFileTime();
 
+    if (pConfig)
+        m_flushInterval = wxMax(0, pConfig->Global.GetInt("/DebugLog/FlushInterval", DefaultFlushInterval));
+
     wxCriticalSectionLocker lock(m_criticalSection);
 
     if (m_enabled)
     {
+        // records queued so far belong in the old file
+        WriteQueuedRecords();
         wxFFile::Flush();
         wxFFile::Close();
 
@@ -127,6 +314,48 @@ void DebugLog::InitDebugLog(bool enable, bool forceOpen)
     }
 
     m_enabled = enable;
+
+    if (enable)
+        StartWriter();
+}
+
+void DebugLog::StartWriter()
+{
+    if (m_writer)
+        return;
+
+    DebugLogWriterThread *writer = new DebugLogWriterThread(this);
+    if (writer->Run() != wxTHREAD_NO_ERROR)
+    {
+        // no writer thread, Write() stays synchronous
+        delete writer;
+        return;
+    }
+
+    m_writer = writer;
+    m_async = true;
+
+    if (!s_prevTerminateHandler)
+        s_prevTerminateHandler = std::set_terminate(DebugLogTerminateHandler);
+}
+
+void DebugLog::StopWriter()
+{
+    if (!m_writer)
+        return;
+
+    m_async = false;
+    m_writer->Stop();
+    delete m_writer;
+    m_writer = nullptr;
+}
+
+// Stop the writer thread and drain the queue; anything logged afterwards is
+// written synchronously
+void DebugLog::Shutdown()
+{
+    StopWriter();
+    DrainQueue(true);
 }
 
 bool DebugLog::ChangeDirLog(const wxString& newdir)
@@ -157,6 +386,14 @@ wxString DebugLog::AddLine(const wxString& str)
     return Write(str + "\n");
 }
 
+// errors often come just before things go wrong, so do not leave them queued
+wxString DebugLog::AddErrorLine(const wxString& str)
+{
+    wxString line = Write(str + "\n");
+    Flush();
+    return line;
+}
+
 wxString DebugLog::AddBytes(const wxString& str, const unsigned char *pBytes, unsigned int count)
 {
     wxString Line = str + " - ";
@@ -176,11 +413,66 @@ bool DebugLog::Flush()
 
     if (m_enabled)
     {
-        wxCriticalSectionLocker lock(m_criticalSection);
+        ret = DrainQueue(true);
+    }
 
-        ret = wxFFile::Flush();
+    return ret;
+}
+
+// Best-effort flush for the crash handlers. Blocking on m_criticalSection could
+// hang the dying process if the crash happened while the queue was being
+// written, so give up in that case.
+void DebugLog::FlushOnCrash()
+{
+    if (!m_enabled || !m_criticalSection.TryEnter())
+        return;
+
+    WriteQueuedRecords();
+    if (wxFFile::IsOpened())
+        wxFFile::Flush();
+
+    m_criticalSection.Leave();
+}
+
+// format the queued records and write them in one go; m_criticalSection must be held
+void DebugLog::WriteQueuedRecords()
+{
+    std::string buf;
+    DebugLogQueue::Record *rec;
+
+    while ((rec = m_queue->Front()) != nullptr)
+    {
+        wxDateTime::Tm tm = wxDateTime(wxLongLong(rec->time)).GetTm();
+
+        // records from different threads can be queued slightly out of time order
+        wxLongLong_t delta = wxMax(rec->time - m_lastWriteTime, (wxLongLong_t) 0);
+        m_lastWriteTime = rec->time;
+
+        char prefix[64];
+        int n = snprintf(prefix, sizeof(prefix), "%02d:%02d:%02d.%03d %02ld.%03ld %lu ",
+            tm.hour, tm.min, tm.sec, tm.msec, (long) (delta / 1000), (long) (delta % 1000), rec->threadId);
+
+        buf.append(prefix, n);
+        buf.append(rec->Text(), rec->len);
+
+        m_queue->Pop();
     }
 
+    if (!buf.empty() && wxFFile::IsOpened())
+        wxFFile::Write(buf.data(), buf.size());
+}
+
+bool DebugLog::DrainQueue(bool flush)
+{
+    wxCriticalSectionLocker lock(m_criticalSection);
+
+    bool ret = true;
+
+    WriteQueuedRecords();
+
+    if (flush && wxFFile::IsOpened())
+        ret = wxFFile::Flush();
+
     return ret;
 }
 
@@ -188,22 +480,22 @@ wxString DebugLog::Write(const wxString& str)
 {
     if (m_enabled)
     {
-        wxCriticalSectionLocker lock(m_criticalSection);
-
-        wxDateTime now = wxDateTime::UNow();
-        wxTimeSpan deltaTime = now - m_lastWriteTime;
-        m_lastWriteTime = now;
-        wxString outputLine = wxString::Format("%s %s %lu %s", now.Format("%H:%M:%S.%l"),
-                                                              deltaTime.Format("%S.%l"),
-                                                              (unsigned long) wxThread::GetCurrentId(),
-                                                              str);
-
-        wxFFile::Write(outputLine);
-#if defined(ALWAYS_FLUSH_DEBUGLOG)
-        wxFFile::Flush();
-#endif
+        wxLongLong_t now = wxDateTime::UNow().GetValue().GetValue();
+        wxScopedCharBuffer text = str.utf8_str();
+
+        while (!m_queue->Push(now, (unsigned long) wxThread::GetCurrentId(), text.data(), text.length()))
+        {
+            // queue is full, make room from this thread
+            DrainQueue(false);
+        }
+
+        if (!m_async)
+            DrainQueue(true);
+        else if (m_flushInterval == 0 || m_queue->Size() >= DebugLogQueue::SIZE / 2)
+            m_wakeup.Post();
+
 #if defined(__WINDOWS__) && defined(_DEBUG)
-        OutputDebugString(outputLine.c_str());
+        OutputDebugString(str.c_str());
 #endif
     }
 
@@ -38,12 +38,35 @@
 
 #include "logger.h"
 
+class DebugLogQueue;
+class DebugLogWriterThread;
+
+/*
+ * Callers of Write() append a record (raw timestamp, thread id and text) to a
+ * lock-free queue and return; a writer thread formats the records and writes
+ * them to the file in batches, flushing every m_flushInterval milliseconds.
+ * Flush() drains the queue synchronously. If the queue fills up the calling
+ * thread drains it. Error lines are flushed straight away, and FlushOnCrash()
+ * gets the queued records into the file from the fatal exception handler.
+ */
 class DebugLog : public wxFFile, public Logger
 {
     bool m_enabled;
-    wxCriticalSection m_criticalSection;
-    wxDateTime m_lastWriteTime;
+    wxCriticalSection m_criticalSection; // file access and queue draining
+    wxLongLong_t m_lastWriteTime;
     wxString m_path;
+    DebugLogQueue *m_queue;
+    DebugLogWriterThread *m_writer;
+    std::atomic<bool> m_async;           // writer thread is running
+    wxSemaphore m_wakeup;                // wakes up the writer thread
+    int m_flushInterval;                 // milliseconds, 0 = flush after every write
+
+    void WriteQueuedRecords();
+    bool DrainQueue(bool flush);
+    void StartWriter();
+    void StopWriter();
+
+    friend class DebugLogWriterThread;
 
 public:
     DebugLog();
@@ -54,10 +77,13 @@ public:
     bool Enable(bool enable);
     bool IsEnabled() const;
     void InitDebugLog(bool enable, bool forceOpen);
+    void Shutdown();
     wxString AddLine(const wxString& str); // adds a newline
+    wxString AddErrorLine(const wxString& str); // adds a newline and flushes
     wxString AddBytes(const wxString& str, const unsigned char *bytes, unsigned count);
     wxString Write(const wxString& str);
     bool Flush();
+    void FlushOnCrash();
 
     bool ChangeDirLog(const wxString& newdir) override;
     void RemoveOldFiles();
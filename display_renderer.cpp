@@ -0,0 +1,323 @@
+/*
+ *  display_renderer.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+
+#include <algorithm>
+#include <chrono>
+
+wxDEFINE_EVENT(DISPLAY_RENDER_COMPLETE_EVENT, wxThreadEvent);
+
+double RenderDisplayImage(wxImage **pImage, usImage& img, const DisplayRenderParams& params)
+{
+    img.CopyToImage(pImage, params.blevel, params.wlevel, params.gamma);
+
+    wxImage *image = *pImage;
+    int imageWidth   = image->GetWidth();
+    int imageHeight  = image->GetHeight();
+    int XWinSize = params.winSize.GetWidth();
+    int YWinSize = params.winSize.GetHeight();
+
+    double scaleFactor = 1.0;
+
+    // scale the image if necessary
+
+    if (imageWidth != XWinSize || imageHeight != YWinSize)
+    {
+        // The image is not the exact right size -- figure out what to do.
+        double xScaleFactor = imageWidth / (double)XWinSize;
+        double yScaleFactor = imageHeight / (double)YWinSize;
+        int newWidth = imageWidth;
+        int newHeight = imageHeight;
+
+        double newScaleFactor = (xScaleFactor > yScaleFactor) ?
+                                xScaleFactor :
+                                yScaleFactor;
+
+        // we rescale the image if:
+        // - The image is either too big
+        // - The image is so small that at least one dimension is less
+        //   than half the width of the window or
+        // - The user has requsted rescaling
+
+        if (xScaleFactor > 1.0 || yScaleFactor > 1.0 ||
+            xScaleFactor < 0.45 || yScaleFactor < 0.45 || params.scaleImage)
+        {
+            newWidth /= newScaleFactor;
+            newHeight /= newScaleFactor;
+
+            newScaleFactor = 1.0 / newScaleFactor;
+
+            scaleFactor = newScaleFactor;
+
+            if (imageWidth != newWidth || imageHeight != newHeight)
+            {
+                if (newWidth > 0 && newHeight > 0)
+                {
+                    image->Rescale(newWidth, newHeight, wxIMAGE_QUALITY_HIGH);
+                }
+            }
+        }
+    }
+
+    return scaleFactor;
+}
+
+class DisplayRenderThread : public wxThread
+{
+    DisplayRenderer *m_renderer;
+
+public:
+    DisplayRenderThread(DisplayRenderer *renderer) : wxThread(wxTHREAD_JOINABLE), m_renderer(renderer) { }
+
+protected:
+    ExitCode Entry() override;
+};
+
+wxThread::ExitCode DisplayRenderThread::Entry()
+{
+    DisplayRenderer *r = m_renderer;
+    usImage *work = new usImage();
+
+    while (true)
+    {
+        r->m_wakeup.Wait();
+
+        DisplayRenderParams params;
+        unsigned int generation;
+        int minIntervalMs;
+        wxImage *image;
+
+        {
+            wxMutexLocker lock(r->m_lock);
+
+            if (r->m_stop)
+                break;
+            if (!r->m_hasPending)
+                continue;
+
+            // take the latest frame, leaving our previous buffer for the next Submit
+            std::swap(r->m_pending, work);
+            r->m_hasPending = false;
+            params = r->m_pendingParams;
+            generation = r->m_generation;
+            minIntervalMs = r->m_minIntervalMs;
+
+            image = r->m_spare;
+            r->m_spare = nullptr;
+        }
+
+        auto const start = std::chrono::steady_clock::now();
+
+        double scaleFactor = RenderDisplayImage(&image, *work, params);
+
+        bool post = false;
+
+        {
+            wxMutexLocker lock(r->m_lock);
+
+            if (generation != r->m_generation)
+            {
+                // discarded while we were rendering
+                std::swap(image, r->m_spare);
+            }
+            else
+            {
+                if (r->m_result)
+                {
+                    // the owner has not picked up the previous image yet
+                    ++r->m_skipped;
+                    std::swap(r->m_result, r->m_spare);
+                }
+                std::swap(image, r->m_result);
+                r->m_resultScale = scaleFactor;
+                ++r->m_rendered;
+
+                if (!r->m_resultPosted)
+                {
+                    r->m_resultPosted = true;
+                    post = true;
+                }
+            }
+        }
+
+        delete image;
+
+        if (post)
+            wxQueueEvent(r->m_owner, new wxThreadEvent(wxEVT_THREAD, DISPLAY_RENDER_COMPLETE_EVENT));
+
+        if (minIntervalMs > 0)
+        {
+            auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            if (elapsed < minIntervalMs)
+                wxMilliSleep(minIntervalMs - elapsed);
+        }
+    }
+
+    delete work;
+
+    return (ExitCode) 0;
+}
+
+DisplayRenderer::DisplayRenderer()
+    :
+    m_thread(nullptr),
+    m_owner(nullptr),
+    m_stop(false),
+    m_pending(new usImage()),
+    m_hasPending(false),
+    m_generation(0),
+    m_result(nullptr),
+    m_resultScale(1.0),
+    m_resultPosted(false),
+    m_spare(nullptr),
+    m_minIntervalMs(0),
+    m_rendered(0),
+    m_skipped(0)
+{
+}
+
+DisplayRenderer::~DisplayRenderer()
+{
+    Stop();
+    delete m_pending;
+    delete m_result;
+    delete m_spare;
+}
+
+// returns true if the thread could not be started, in which case the owner
+// renders on its own thread
+bool DisplayRenderer::Start(wxEvtHandler *owner)
+{
+    if (m_thread)
+        return false;
+
+    m_owner = owner;
+    m_stop = false;
+
+    DisplayRenderThread *thread = new DisplayRenderThread(this);
+    if (thread->Run() != wxTHREAD_NO_ERROR)
+    {
+        Debug.Write("display renderer: could not start thread\n");
+        delete thread;
+        return true;
+    }
+
+    m_thread = thread;
+    return false;
+}
+
+void DisplayRenderer::Stop()
+{
+    if (!m_thread)
+        return;
+
+    {
+        wxMutexLocker lock(m_lock);
+        m_stop = true;
+    }
+    m_wakeup.Post();
+    m_thread->Wait();
+    delete m_thread;
+    m_thread = nullptr;
+
+    Debug.Write(wxString::Format("display renderer stopped: %u frames rendered, %u skipped\n", m_rendered, m_skipped));
+}
+
+// 0 means no limit
+void DisplayRenderer::SetMaxFps(int fps)
+{
+    wxMutexLocker lock(m_lock);
+    m_minIntervalMs = fps > 0 ? 1000 / fps : 0;
+}
+
+// Queue a frame for rendering, replacing any frame that is still waiting.
+// Returns true on error.
+bool DisplayRenderer::Submit(const usImage& img, const DisplayRenderParams& params)
+{
+    {
+        wxMutexLocker lock(m_lock);
+
+        if (m_hasPending)
+            ++m_skipped;
+
+        if (m_pending->CopyFrom(img))
+        {
+            m_hasPending = false;
+            return true;
+        }
+        m_pendingParams = params;
+        m_hasPending = true;
+    }
+
+    m_wakeup.Post();
+    return false;
+}
+
+// drop the waiting frame and any result not yet taken, e.g. when the display is cleared
+void DisplayRenderer::Discard()
+{
+    wxMutexLocker lock(m_lock);
+
+    m_hasPending = false;
+    ++m_generation;
+
+    if (m_result)
+    {
+        delete m_spare;
+        m_spare = m_result;
+        m_result = nullptr;
+    }
+}
+
+// Swap the latest rendered image into *pImage; the image it replaces is reused
+// for a later render. Returns false if there is no new image.
+bool DisplayRenderer::TakeResult(wxImage **pImage, double *scaleFactor)
+{
+    wxMutexLocker lock(m_lock);
+
+    m_resultPosted = false;
+
+    if (!m_result)
+        return false;
+
+    delete m_spare;
+    m_spare = *pImage;
+    *pImage = m_result;
+    m_result = nullptr;
+    *scaleFactor = m_resultScale;
+
+    return true;
+}
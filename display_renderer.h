@@ -0,0 +1,105 @@
+/*
+ *  display_renderer.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef DISPLAY_RENDERER_INCLUDED
+#define DISPLAY_RENDERER_INCLUDED
+
+wxDECLARE_EVENT(DISPLAY_RENDER_COMPLETE_EVENT, wxThreadEvent);
+
+// how a frame is turned into the image shown in the guider window
+struct DisplayRenderParams
+{
+    int blevel;
+    int wlevel;
+    double gamma;
+    wxSize winSize;
+    bool scaleImage;
+};
+
+// Stretch img for display and scale it to fit the window the way the guider
+// shows it. *pImage is reused when it has the right size. Returns the scale
+// factor from image to display coordinates.
+extern double RenderDisplayImage(wxImage **pImage, usImage& img, const DisplayRenderParams& params);
+
+class DisplayRenderThread;
+
+/*
+ * Renders the guider display image on a background thread, so that stretching
+ * and rescaling large frames does not hold up guiding and event server requests
+ * on the main thread. Only the most recent frame is kept: a frame submitted
+ * while an earlier one is still waiting to be rendered replaces it. When an image
+ * is ready the owner receives DISPLAY_RENDER_COMPLETE_EVENT and picks it up with
+ * TakeResult. The render rate can be capped with SetMaxFps.
+ */
+class DisplayRenderer
+{
+    friend class DisplayRenderThread;
+
+    wxMutex m_lock;
+    wxSemaphore m_wakeup;
+    DisplayRenderThread *m_thread;
+    wxEvtHandler *m_owner;
+    bool m_stop;
+
+    usImage *m_pending;                 // latest submitted frame
+    DisplayRenderParams m_pendingParams;
+    bool m_hasPending;
+    unsigned int m_generation;          // results from an older generation are dropped
+
+    wxImage *m_result;                  // rendered, not yet taken by the owner
+    double m_resultScale;
+    bool m_resultPosted;
+    wxImage *m_spare;                   // recycled for the next render
+
+    int m_minIntervalMs;
+
+    unsigned int m_rendered;
+    unsigned int m_skipped;
+
+public:
+    DisplayRenderer();
+    ~DisplayRenderer();
+
+    bool Start(wxEvtHandler *owner);
+    void Stop();
+    bool IsRunning() const { return m_thread != nullptr; }
+
+    void SetMaxFps(int fps);
+
+    bool Submit(const usImage& img, const DisplayRenderParams& params);
+    void Discard();
+    bool TakeResult(wxImage **pImage, double *scaleFactor);
+};
+
+#endif // DISPLAY_RENDERER_INCLUDED
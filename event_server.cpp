@@ -33,10 +33,16 @@
  */
 
 #include "phd.h"
+#include "json_writer.h"
 
 #include <wx/sstream.h>
 #include <wx/sckstrm.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iterator>
 #include <sstream>
+#include <stdarg.h>
 #include <string.h>
 
 EventServer EvtServer;
@@ -44,6 +50,7 @@ EventServer EvtServer;
 BEGIN_EVENT_TABLE(EventServer, wxEvtHandler)
     EVT_SOCKET(EVENT_SERVER_ID, EventServer::OnEventServerEvent)
     EVT_SOCKET(EVENT_SERVER_CLIENT_ID, EventServer::OnEventServerClientEvent)
+    EVT_THREAD(EVENT_SERVER_CLIENT_ID, EventServer::OnSlowClient)
 END_EVENT_TABLE()
 
 enum
@@ -51,10 +58,6 @@ enum
     MSG_PROTOCOL_VERSION = 1,
 };
 
-static const wxString literal_null("null");
-static const wxString literal_true("true");
-static const wxString literal_false("false");
-
 static wxString state_name(EXPOSED_STATE st)
 {
     switch (st)
@@ -70,151 +73,36 @@ static wxString state_name(EXPOSED_STATE st)
     }
 }
 
-static wxString json_escape(const wxString& s)
+static void json_put_string(std::string& s, const wxString& str)
 {
-    wxString t(s);
-    static const wxString BACKSLASH("\\");
-    static const wxString BACKSLASHBACKSLASH("\\\\");
-    static const wxString DQUOT("\"");
-    static const wxString BACKSLASHDQUOT("\\\"");
-    static const wxString CR("\r");
-    static const wxString BACKSLASHCR("\\r");
-    static const wxString LF("\n");
-    static const wxString BACKSLASHLF("\\n");
-    t.Replace(BACKSLASH, BACKSLASHBACKSLASH);
-    t.Replace(DQUOT, BACKSLASHDQUOT);
-    t.Replace(CR, BACKSLASHCR);
-    t.Replace(LF, BACKSLASHLF);
-    return t;
-}
-
-template<char LDELIM, char RDELIM>
-struct JSeq
-{
-    wxString m_s;
-    bool m_first;
-    bool m_closed;
-    JSeq() : m_first(true), m_closed(false) { m_s << LDELIM; }
-    void close() { m_s << RDELIM; m_closed = true; }
-    wxString str() { if (!m_closed) close(); return m_s; }
-};
-
-typedef JSeq<'[', ']'> JAry;
-typedef JSeq<'{', '}'> JObj;
-
-static JAry& operator<<(JAry& a, const wxString& str)
-{
-    if (a.m_first)
-        a.m_first = false;
-    else
-        a.m_s << ',';
-    a.m_s << str;
-    return a;
+    json_put_string(s, str.wc_str(), str.length());
 }
 
-static JAry& operator<<(JAry& a, double d)
+static wxString json_format(const json_value *j)
 {
-    return a << wxString::Format("%.2f", d);
+    std::string s;
+    json_put(s, j);
+    return wxString::FromUTF8(s.data(), s.size());
 }
 
-static JAry& operator<<(JAry& a, int i)
+template<char LDELIM, char RDELIM>
+static wxString wxstr(const JSeq<LDELIM, RDELIM>& seq)
 {
-    return a << wxString::Format("%d", i);
+    const std::string& s = seq.str();
+    return wxString::FromUTF8(s.data(), s.size());
 }
 
-static wxString json_format(const json_value *j)
-{
-    if (!j)
-        return literal_null;
-
-    switch (j->type) {
-    default:
-    case JSON_NULL: return literal_null;
-    case JSON_OBJECT: {
-        wxString ret("{");
-        bool first = true;
-        json_for_each (jj, j)
-        {
-            if (first)
-                first = false;
-            else
-                ret << ",";
-            ret << '"' << jj->name << "\":" << json_format(jj);
-        }
-        ret << "}";
-        return ret;
-    }
-    case JSON_ARRAY: {
-        wxString ret("[");
-        bool first = true;
-        json_for_each (jj, j)
-        {
-            if (first)
-                first = false;
-            else
-                ret << ",";
-            ret << json_format(jj);
-        }
-        ret << "]";
-        return ret;
-    }
-    case JSON_STRING: return '"' + json_escape(j->string_value) + '"';
-    case JSON_INT:    return wxString::Format("%d", j->int_value);
-    case JSON_FLOAT:  return wxString::Format("%g", (double) j->float_value);
-    case JSON_BOOL:   return j->int_value ? literal_true : literal_false;
-    }
-}
-
-struct NULL_TYPE { } NULL_VALUE;
-
-// name-value pair
-struct NV
-{
-    wxString n;
-    wxString v;
-    NV(const wxString& n_, const wxString& v_) : n(n_), v('"' + json_escape(v_) + '"') { }
-    NV(const wxString& n_, const char *v_) : n(n_), v('"' + json_escape(v_) + '"') { }
-    NV(const wxString& n_, const wchar_t *v_) : n(n_), v('"' + json_escape(v_) + '"') { }
-    NV(const wxString& n_, int v_) : n(n_), v(wxString::Format("%d", v_)) { }
-    NV(const wxString& n_, double v_) : n(n_), v(wxString::Format("%g", v_)) { }
-    NV(const wxString& n_, double v_, int prec) : n(n_), v(wxString::Format("%.*f", prec, v_)) { }
-    NV(const wxString& n_, bool v_) : n(n_), v(v_ ? literal_true : literal_false) { }
-    template<typename T>
-    NV(const wxString& n_, const std::vector<T>& vec);
-    NV(const wxString& n_, JAry& ary) : n(n_), v(ary.str()) { }
-    NV(const wxString& n_, JObj& obj) : n(n_), v(obj.str()) { }
-    NV(const wxString& n_, const json_value *v_) : n(n_), v(json_format(v_)) { }
-    NV(const wxString& n_, const PHD_Point& p) : n(n_) { JAry ary; ary << p.X << p.Y; v = ary.str(); }
-    NV(const wxString& n_, const wxPoint& p) : n(n_) { JAry ary; ary << p.x << p.y; v = ary.str(); }
-    NV(const wxString& n_, const wxSize& s) : n(n_) { JAry ary; ary << s.x << s.y; v = ary.str(); }
-    NV(const wxString& n_, const NULL_TYPE& nul) : n(n_), v(literal_null) { }
-};
-
-template<typename T>
-NV::NV(const wxString& n_, const std::vector<T>& vec)
-    : n(n_)
+static JAry& operator<<(JAry& a, const wxString& str)
 {
-    std::ostringstream os;
-    os << '[';
-    for (unsigned int i = 0; i < vec.size(); i++)
-    {
-        if (i != 0)
-            os << ',';
-        os << vec[i];
-    }
-    os << ']';
-    v = os.str();
+    a.sep();
+    json_put_string(a.m_s, str);
+    return a;
 }
 
-static JObj& operator<<(JObj& j, const NV& nv)
-{
-    if (j.m_first)
-        j.m_first = false;
-    else
-        j.m_s << ',';
-    j.m_s << '"' << nv.n << "\":" << nv.v;
-    return j;
-}
+NV::NV(const char *n_, const wxString& v_) : n(n_), kind(TEXT) { json_put_string(v, v_); }
+NV::NV(const char *n_, const PHD_Point& p) : n(n_), kind(TEXT) { JAry ary; ary << p.X << p.Y; v = ary.str(); }
+NV::NV(const char *n_, const wxPoint& p) : n(n_), kind(TEXT) { JAry ary; ary << p.x << p.y; v = ary.str(); }
+NV::NV(const char *n_, const wxSize& s) : n(n_), kind(TEXT) { JAry ary; ary << s.x << s.y; v = ary.str(); }
 
 static NV NVMount(const Mount *mount)
 {
@@ -226,19 +114,15 @@ static JObj& operator<<(JObj& j, const PHD_Point& pt)
     return j << NV("X", pt.X, 3) << NV("Y", pt.Y, 3);
 }
 
-static JAry& operator<<(JAry& a, JObj& j)
-{
-    return a << j.str();
-}
-
 struct Ev : public JObj
 {
-    Ev(const wxString& event)
+    Ev(const char *event)
     {
+        static const NV s_host("Host", wxGetHostName());
         double const now = ::wxGetUTCTimeMillis().ToDouble() / 1000.0;
         *this << NV("Event", event)
             << NV("Timestamp", now, 3)
-            << NV("Host", wxGetHostName())
+            << s_host
             << NV("Inst", wxGetApp().GetInstanceNumber());
     }
 };
@@ -348,12 +232,29 @@ struct ClientReadBuf
     void reset() { dest = &m_buf[0]; }
 };
 
+// Output that the socket would not take yet. Writes never block: whatever
+// does not fit in the socket buffer is queued here and sent from the
+// wxSOCKET_OUTPUT handler when the socket becomes writable again.
+struct ClientWriteQueue
+{
+    std::deque<std::string> msgs;
+    size_t sent;             // bytes of msgs.front() already written
+    size_t queuedBytes;      // bytes waiting to be written
+    size_t peakQueuedBytes;
+    unsigned int droppedEvents;
+    bool dropping;           // events are being dropped until the queue drains
+    bool closing;            // client is being disconnected for falling behind
+
+    ClientWriteQueue() : sent(0), queuedBytes(0), peakQueuedBytes(0), droppedEvents(0), dropping(false), closing(false) { }
+};
+
 struct ClientData
 {
     wxSocketClient *cli;
     int refcnt;
     ClientReadBuf rdbuf;
     wxMutex wrlock;
+    ClientWriteQueue wrq;
 
     ClientData(wxSocketClient *cli_) : cli(cli_), refcnt(1) { }
     void AddRef() { ++refcnt; }
@@ -375,9 +276,9 @@ struct ClientDataGuard
     ClientData *operator->() const { return cd; }
 };
 
-inline static wxMutex *client_wrlock(wxSocketClient *cli)
+inline static ClientData *client_data(wxSocketClient *cli)
 {
-    return &((ClientData *) cli->GetClientData())->wrlock;
+    return (ClientData *) cli->GetClientData();
 }
 
 static wxString SockErrStr(wxSocketError e)
@@ -397,40 +298,138 @@ static wxString SockErrStr(wxSocketError e)
     }
 }
 
-static void send_buf(wxSocketClient *client, const wxCharBuffer& buf)
+enum
+{
+    DefaultMaxQueuedBytes = 256 * 1024,
+};
+
+// limit on output queued for a client before its events are dropped (or the
+// client is disconnected)
+static size_t s_maxQueuedBytes = DefaultMaxQueuedBytes;
+static bool s_disconnectSlowClients = false;
+
+// write a message without blocking; returns the number of bytes the socket took
+static size_t write_some(wxSocketClient *client, const char *buf, size_t len)
 {
-    wxMutexLocker lock(*client_wrlock(client));
-    client->Write(buf.data(), buf.length());
-    if (client->LastWriteCount() != buf.length())
+    client->Write(buf, len);
+    size_t n = client->LastWriteCount();
+    if (n != len && client->Error() && client->LastError() != wxSOCKET_WOULDBLOCK)
     {
         Debug.Write(wxString::Format("evsrv: cli %p short write %u/%u %s\n",
-            client, client->LastWriteCount(), (unsigned int) buf.length(),
-            SockErrStr(client->Error() ? client->LastError() : wxSOCKET_NOERROR)));
+            client, (unsigned int) n, (unsigned int) len, SockErrStr(client->LastError())));
+    }
+    return n;
+}
+
+// send as much queued output as the socket will take. Called with wrlock held.
+static void flush_queue(ClientData *cd)
+{
+    ClientWriteQueue& q = cd->wrq;
+
+    while (!q.msgs.empty())
+    {
+        const std::string& msg = q.msgs.front();
+        size_t n = write_some(cd->cli, msg.data() + q.sent, msg.size() - q.sent);
+        q.sent += n;
+        q.queuedBytes -= n;
+        if (q.sent < msg.size())
+            return; // socket is full, resume on wxSOCKET_OUTPUT
+        q.msgs.pop_front();
+        q.sent = 0;
+    }
+
+    if (q.dropping)
+    {
+        Debug.Write(wxString::Format("evsrv: cli %p caught up, %u events dropped\n", cd->cli, q.droppedEvents));
+        q.dropping = false;
+    }
+}
+
+static void disconnect_slow_client(ClientData *cd)
+{
+    ClientWriteQueue& q = cd->wrq;
+
+    Debug.Write(wxString::Format("evsrv: cli %p too far behind (%u bytes queued), disconnecting\n",
+        cd->cli, (unsigned int) q.queuedBytes));
+
+    q.closing = true;
+    q.msgs.clear();
+    q.sent = q.queuedBytes = 0;
+
+    // the client is removed on the GUI thread; the reference keeps the client
+    // data alive until then
+    cd->AddRef();
+    wxThreadEvent *ev = new wxThreadEvent(wxEVT_THREAD, EVENT_SERVER_CLIENT_ID);
+    ev->SetPayload(cd);
+    wxQueueEvent(&EvtServer, ev);
+}
+
+// Queue a message for a client. Responses are always delivered; an event is
+// dropped (or the client disconnected) if the client has too much output
+// waiting already.
+static void send_buf(wxSocketClient *client, const std::string& buf, bool droppable)
+{
+    ClientData *cd = client_data(client);
+    ClientWriteQueue& q = cd->wrq;
+
+    wxMutexLocker lock(cd->wrlock);
+
+    if (q.closing)
+        return;
+
+    size_t sent = 0;
+
+    if (q.msgs.empty())
+    {
+        sent = write_some(client, buf.data(), buf.size());
+        if (sent == buf.size())
+            return;
     }
+    else if (droppable && q.queuedBytes + buf.size() > s_maxQueuedBytes)
+    {
+        ++q.droppedEvents;
+
+        if (s_disconnectSlowClients)
+            disconnect_slow_client(cd);
+        else if (!q.dropping)
+        {
+            Debug.Write(wxString::Format("evsrv: cli %p falling behind (%u bytes queued), dropping events\n",
+                client, (unsigned int) q.queuedBytes));
+            q.dropping = true;
+        }
+        return;
+    }
+
+    // a partly written message must be completed to keep the stream intact,
+    // so the remainder is queued regardless of the limit
+    q.msgs.push_back(sent ? buf.substr(sent) : buf);
+    q.queuedBytes += buf.size() - sent;
+    if (q.queuedBytes > q.peakQueuedBytes)
+        q.peakQueuedBytes = q.queuedBytes;
 }
 
 static void do_notify1(wxSocketClient *client, const JAry& ary)
 {
-    send_buf(client, (JAry(ary).str() + "\r\n").ToUTF8());
+    send_buf(client, ary.line(), false);
 }
 
 static void do_notify1(wxSocketClient *client, const JObj& j)
 {
-    send_buf(client, (JObj(j).str() + "\r\n").ToUTF8());
+    send_buf(client, j.line(), false);
 }
 
 static void do_notify(const EventServer::CliSockSet& cli, const JObj& jj)
 {
-    wxCharBuffer buf = (JObj(jj).str() + "\r\n").ToUTF8();
+    const std::string& buf = jj.line();
 
     for (EventServer::CliSockSet::const_iterator it = cli.begin();
         it != cli.end(); ++it)
     {
-        send_buf(*it, buf);
+        send_buf(*it, buf, true);
     }
 }
 
-inline static void simple_notify(const EventServer::CliSockSet& cli, const wxString& ev)
+inline static void simple_notify(const EventServer::CliSockSet& cli, const char *ev)
 {
     if (!cli.empty())
         do_notify(cli, Ev(ev));
@@ -490,6 +489,18 @@ static void destroy_client(wxSocketClient *cli)
     buf->RemoveRef();
 }
 
+static void log_client_stats(wxSocketClient *cli)
+{
+    ClientData *cd = client_data(cli);
+    wxMutexLocker lock(cd->wrlock);
+    const ClientWriteQueue& q = cd->wrq;
+    if (q.peakQueuedBytes || q.droppedEvents)
+    {
+        Debug.Write(wxString::Format("evsrv: cli %p output queued %u bytes (peak %u), %u events dropped\n",
+            cli, (unsigned int) q.queuedBytes, (unsigned int) q.peakQueuedBytes, q.droppedEvents));
+    }
+}
+
 static void drain_input(wxSocketInputStream& sis)
 {
     while (sis.CanRead())
@@ -613,12 +624,20 @@ static void get_profiles(JObj& response, const json_value *params)
     response << jrpc_result(ary);
 }
 
+// Request parameters, by position or by name. Lookups scan the handful of
+// parameters directly rather than building an index for every request.
 struct Params
 {
-    std::map<std::string, const json_value *> dict;
+    enum { MAX_PARAMS = 4 };
+    const char *names[MAX_PARAMS];
+    const json_value *vals[MAX_PARAMS];
+    size_t count;
+    const json_value *obj;
 
-    void Init(const char *names[], size_t nr_names, const json_value *params)
+    void Init(const char *names_[], size_t nr_names, const json_value *params)
     {
+        count = 0;
+        obj = nullptr;
         if (!params)
             return;
         if (params->type == JSON_ARRAY)
@@ -626,16 +645,14 @@ struct Params
             const json_value *jv = params->first_child;
             for (size_t i = 0; jv && i < nr_names; i++, jv = jv->next_sibling)
             {
-                const char *name = names[i];
-                dict.insert(std::make_pair(std::string(name), jv));
+                names[count] = names_[i];
+                vals[count] = jv;
+                ++count;
             }
         }
         else if (params->type == JSON_OBJECT)
         {
-            json_for_each(jv, params)
-            {
-                dict.insert(std::make_pair(std::string(jv->name), jv));
-            }
+            obj = params;
         }
     }
     Params(const char *n1, const json_value *params)
@@ -658,10 +675,24 @@ struct Params
         const char *n[] = { n1, n2, n3, n4 };
         Init(n, 4, params);
     }
-    const json_value *param(const std::string& name) const
+    const json_value *param(const char *name) const
     {
-        auto it = dict.find(name);
-        return it == dict.end() ? 0 : it->second;
+        if (obj)
+        {
+            // the first occurrence wins if a name is repeated
+            json_for_each(jv, obj)
+            {
+                if (strcmp(jv->name, name) == 0)
+                    return jv;
+            }
+            return 0;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            if (strcmp(names[i], name) == 0)
+                return vals[i];
+        }
+        return 0;
     }
 };
 
@@ -920,22 +951,22 @@ static bool parse_rect(wxRect *r, const json_value *j)
     return true;
 }
 
-static void find_star(JObj& response, const json_value *params)
+static bool find_star_params(JObj& response, const json_value *params, wxRect *roi)
 {
-    VERIFY_GUIDER(response);
-
     Params p("roi", params);
 
-    wxRect roi;
     const json_value *j = p.param("roi");
-    if (j && !parse_rect(&roi, j))
+    if (j && !parse_rect(roi, j))
     {
         response << jrpc_error(JSONRPC_INVALID_PARAMS, "invalid ROI param");
-        return;
+        return false;
     }
 
-    bool error = pFrame->AutoSelectStar(roi);
+    return true;
+}
 
+static void find_star_result(JObj& response, bool error)
+{
     if (!error)
     {
         const PHD_Point& lockPos = pFrame->pGuider->LockPosition();
@@ -949,6 +980,19 @@ static void find_star(JObj& response, const json_value *params)
     response << jrpc_error(1, "could not find star");
 }
 
+static void find_star(JObj& response, const json_value *params)
+{
+    VERIFY_GUIDER(response);
+
+    wxRect roi;
+    if (!find_star_params(response, params, &roi))
+        return;
+
+    bool error = pFrame->AutoSelectStar(roi);
+
+    find_star_result(response, error);
+}
+
 static void get_pixel_scale(JObj& response, const json_value *params)
 {
     double scale = pFrame->GetCameraPixelScale();
@@ -1361,59 +1405,123 @@ static void get_search_region(JObj& response, const json_value *params)
     response << jrpc_result(pFrame->pGuider->GetSearchRegion());
 }
 
-struct B64Encode
+// Start a name-value pair in obj and return the buffer for the caller to write
+// the value into directly
+static std::string& json_begin_value(JObj& obj, const char *name)
 {
-    static const char *const E;
-    std::ostringstream os;
-    unsigned int t;
-    size_t nread;
+    obj.sep();
+    std::string& s = obj.m_s;
+    s += '"';
+    s += name;
+    s.append("\":", 2);
+    return s;
+}
 
-    B64Encode()
-        : t(0), nread(0)
+// Base64 encoder writing a JSON string value straight into a message buffer.
+// Input may arrive in pieces (a cutout row at a time); up to two bytes are
+// carried over to the next piece. Each 12-bit half of a 3-byte group is
+// looked up in a table of character pairs.
+class B64Encode
+{
+    struct Table
     {
+        char pairs[4096][2];
+        Table()
+        {
+            static const char E[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            for (int i = 0; i < 4096; i++)
+            {
+                pairs[i][0] = E[i >> 6];
+                pairs[i][1] = E[i & 0x3F];
+            }
+        }
+    };
+
+    static const Table& table()
+    {
+        static const Table s_table;
+        return s_table;
     }
-    void append1(unsigned char ch)
+
+    std::string& m_out;
+    const Table& m_tbl;
+    unsigned char m_carry[3];
+    size_t m_ncarry;
+
+    void encode(const unsigned char *src, size_t ngroups)
     {
-        t <<= 8;
-        t |= ch;
-        if (++nread % 3 == 0)
+        size_t const pos = m_out.size();
+        m_out.resize(pos + ngroups * 4);
+        char *dst = &m_out[pos];
+        for (; ngroups; --ngroups, src += 3, dst += 4)
         {
-            os << E[t >> 18]
-               << E[(t >> 12) & 0x3F]
-               << E[(t >> 6) & 0x3F]
-               << E[t & 0x3F];
-            t = 0;
+            unsigned int const t = (src[0] << 16) | (src[1] << 8) | src[2];
+            memcpy(dst, m_tbl.pairs[t >> 12], 2);
+            memcpy(dst + 2, m_tbl.pairs[t & 0xFFF], 2);
         }
     }
+
+public:
+    B64Encode(std::string& out)
+        : m_out(out), m_tbl(table()), m_ncarry(0)
+    {
+        m_out += '"';
+    }
     void append(const void *src_, size_t len)
     {
         const unsigned char *src = (const unsigned char *) src_;
-        const unsigned char *const end = src + len;
-        while (src < end)
-            append1(*src++);
+        if (m_ncarry)
+        {
+            while (m_ncarry < 3 && len)
+            {
+                m_carry[m_ncarry++] = *src++;
+                --len;
+            }
+            if (m_ncarry < 3)
+                return;
+            encode(m_carry, 1);
+            m_ncarry = 0;
+        }
+        size_t const ngroups = len / 3;
+        encode(src, ngroups);
+        src += ngroups * 3;
+        len -= ngroups * 3;
+        memcpy(m_carry, src, len);
+        m_ncarry = len;
     }
-    std::string finish()
+    void finish()
     {
-        switch (nread % 3) {
-        case 1:
-            os << E[t >> 2]
-               << E[(t & 0x3) << 4]
-               << "==";
-            break;
-        case 2:
-            os << E[t >> 10]
-                << E[(t >> 4) & 0x3F]
-                << E[(t & 0xf) << 2]
-                << '=';
-            break;
+        static const char *const E = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        if (m_ncarry == 1)
+        {
+            unsigned int const t = m_carry[0];
+            m_out += E[t >> 2];
+            m_out += E[(t & 0x3) << 4];
+            m_out.append("==", 2);
         }
-        os << std::ends;
-        return os.str();
+        else if (m_ncarry == 2)
+        {
+            unsigned int const t = (m_carry[0] << 8) | m_carry[1];
+            m_out += E[t >> 10];
+            m_out += E[(t >> 4) & 0x3F];
+            m_out += E[(t & 0xf) << 2];
+            m_out += '=';
+        }
+        m_ncarry = 0;
+        m_out += '"';
     }
 };
-const char *const B64Encode::E = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-static void get_star_image(JObj& response, const json_value *params)
+enum
+{
+    DefaultStarImageMaxHalfWidth = 31,
+    StarImageHalfWidthLimit = 255,
+};
+
+// Parse the cutout size param for get_star_image(s). The half-width is capped
+// at /server/star_image_max_halfw (at most StarImageHalfWidthLimit) to bound
+// the size of the response.
+static bool star_image_halfw_param(JObj& response, const json_value *params, int *halfw)
 {
     int reqsize = 15;
     Params p("size", params);
@@ -1423,23 +1531,21 @@ static void get_star_image(JObj& response, const json_value *params)
         if (val->type != JSON_INT || (reqsize = val->int_value) < 15)
         {
             response << jrpc_error(JSONRPC_INVALID_PARAMS, "invalid image size param");
-            return;
+            return false;
         }
     }
 
-    VERIFY_GUIDER(response);
+    int maxHalfw = pConfig->Global.GetInt("/server/star_image_max_halfw", DefaultStarImageMaxHalfWidth);
+    maxHalfw = wxMax(7, wxMin(maxHalfw, (int) StarImageHalfWidthLimit));
 
-    Guider *guider = pFrame->pGuider;
-    const usImage *img = guider->CurrentImage();
-    const PHD_Point& star = guider->CurrentPosition();
-
-    if (guider->GetState() < GUIDER_STATE::STATE_SELECTED || !img->ImageData || !star.IsValid())
-    {
-        response << jrpc_error(2, "no star selected");
-        return;
-    }
+    *halfw = wxMin((reqsize - 1) / 2, maxHalfw);
+    return true;
+}
 
-    int const halfw = wxMin((reqsize - 1) / 2, 31);
+// add the cutout around star to obj: width, height, star_pos (relative to the
+// cutout) and the base64 pixels
+static void star_cutout(JObj& obj, const usImage *img, const PHD_Point& star, int halfw)
+{
     int const fullw = 2 * halfw + 1;
     int const sx = (int) rint(star.X);
     int const sy = (int) rint(star.Y);
@@ -1449,23 +1555,79 @@ static void get_star_image(JObj& response, const json_value *params)
     else
         rect.Intersect(img->Subframe);
 
-    B64Encode enc;
+    PHD_Point pos(star);
+    pos.X -= rect.GetLeft();
+    pos.Y -= rect.GetTop();
+
+    obj << NV("width", rect.GetWidth())
+        << NV("height", rect.GetHeight())
+        << NV("star_pos", pos);
+
+    B64Encode enc(json_begin_value(obj, "pixels"));
     for (int y = rect.GetTop(); y <= rect.GetBottom(); y++)
     {
         const unsigned short *p = img->ImageData + y * img->Size.GetWidth() + rect.GetLeft();
         enc.append(p, rect.GetWidth() * sizeof(unsigned short));
     }
+    enc.finish();
+}
 
-    PHD_Point pos(star);
-    pos.X -= rect.GetLeft();
-    pos.Y -= rect.GetTop();
+static void get_star_image(JObj& response, const json_value *params)
+{
+    int halfw;
+    if (!star_image_halfw_param(response, params, &halfw))
+        return;
+
+    VERIFY_GUIDER(response);
+
+    Guider *guider = pFrame->pGuider;
+    const usImage *img = guider->CurrentImage();
+    const PHD_Point& star = guider->CurrentPosition();
+
+    if (guider->GetState() < GUIDER_STATE::STATE_SELECTED || !img->ImageData || !star.IsValid())
+    {
+        response << jrpc_error(2, "no star selected");
+        return;
+    }
 
     JObj rslt;
-    rslt << NV("frame", (int) img->FrameNum)
-        << NV("width", rect.GetWidth())
-        << NV("height", rect.GetHeight())
-        << NV("star_pos", pos)
-        << NV("pixels", enc.finish());
+    rslt << NV("frame", (int) img->FrameNum);
+    star_cutout(rslt, img, star, halfw);
+
+    response << jrpc_result(rslt);
+}
+
+// cutouts around all the guide stars (the primary star first) in one call
+static void get_star_images(JObj& response, const json_value *params)
+{
+    int halfw;
+    if (!star_image_halfw_param(response, params, &halfw))
+        return;
+
+    VERIFY_GUIDER(response);
+
+    Guider *guider = pFrame->pGuider;
+    const usImage *img = guider->CurrentImage();
+
+    std::vector<PHD_Point> stars;
+    guider->GetGuideStarPositions(&stars);
+
+    if (guider->GetState() < GUIDER_STATE::STATE_SELECTED || !img->ImageData || stars.empty())
+    {
+        response << jrpc_error(2, "no star selected");
+        return;
+    }
+
+    JAry ary;
+    for (const PHD_Point& star : stars)
+    {
+        JObj t;
+        star_cutout(t, img, star, halfw);
+        ary << t;
+    }
+
+    JObj rslt;
+    rslt << NV("frame", (int) img->FrameNum) << NV("stars", ary);
 
     response << jrpc_result(rslt);
 }
@@ -1733,7 +1895,7 @@ static void get_algo_param_names(JObj& response, const json_value *params)
 
     JAry names;
     for (auto it = ary.begin(); it != ary.end(); ++it)
-        names << ('"' + json_escape(*it) + '"');
+        names << *it;
 
     response << jrpc_result(names);
 }
@@ -2084,6 +2246,52 @@ struct JRpcCall
     JRpcCall(wxSocketClient *cli_, const json_value *req_) : cli(cli_), req(req_), method(nullptr) { }
 };
 
+// find_star requests waiting for a background star search to complete
+struct PendingFindStar
+{
+    wxSocketClient *cli;
+    NV id;
+
+    PendingFindStar(wxSocketClient *cli_, const json_value *id_) : cli(cli_), id(jrpc_id(id_)) { }
+};
+
+static std::vector<PendingFindStar> s_pendingFindStar;
+
+static void release_pending_find_star()
+{
+    for (const auto& req : s_pendingFindStar)
+        destroy_client(req.cli);
+    s_pendingFindStar.clear();
+}
+
+// Start the star search for find_star on a background thread. Returns true if
+// the response is deferred until EventServer::NotifyAutoSelectComplete, or false
+// if the response was filled in already.
+static bool find_star_async(JRpcCall& call, const json_value *params, const json_value *id)
+{
+    if (!pFrame || !pFrame->pGuider)
+    {
+        call.response << jrpc_error(1, "internal error");
+        return false;
+    }
+
+    wxRect roi;
+    if (!find_star_params(call.response, params, &roi))
+        return false;
+
+    if (pFrame->AutoSelectStarAsync(roi))
+    {
+        find_star_result(call.response, true);
+        return false;
+    }
+
+    // hold a reference on the client until the response is sent
+    ((ClientData *) call.cli->GetClientData())->AddRef();
+    s_pendingFindStar.push_back(PendingFindStar(call.cli, id));
+
+    return true;
+}
+
 static void dump_request(const JRpcCall& call)
 {
     Debug.Write(wxString::Format("evsrv: cli %p request: %s\n", call.cli, json_format(call.req)));
@@ -2091,23 +2299,145 @@ static void dump_request(const JRpcCall& call)
 
 static void dump_response(const JRpcCall& call)
 {
-    wxString s(const_cast<JRpcResponse&>(call.response).str());
+    wxString s(wxstr(call.response));
 
     // trim output for huge responses
 
     // this is very hacky operating directly on the string, but it's not
     // worth bothering to parse and reformat the response
-    if (call.method && strcmp(call.method->string_value, "get_star_image") == 0)
+    if (call.method && strncmp(call.method->string_value, "get_star_image", 14) == 0)
     {
-        size_t p0, p1;
-        if ((p0 = s.find("\"pixels\":\"")) != wxString::npos && (p1 = s.find('"', p0 + 10)) != wxString::npos)
+        size_t p0 = 0, p1;
+        while ((p0 = s.find("\"pixels\":\"", p0)) != wxString::npos && (p1 = s.find('"', p0 + 10)) != wxString::npos)
+        {
             s.replace(p0 + 10, p1 - (p0 + 10), "...");
+            p0 += 14;
+        }
     }
 
     Debug.Write(wxString::Format("evsrv: cli %p response: %s\n", call.cli, s));
 }
 
-static bool handle_request(JRpcCall& call)
+struct RpcStats
+{
+    unsigned int count;
+    double totalMs;
+    double maxMs;
+};
+
+struct RpcMethod
+{
+    const char *name;
+    void (*fn)(JObj& response, const json_value *params);
+    RpcStats stats;
+};
+
+static void get_rpc_stats(JObj& response, const json_value *params);
+
+static RpcMethod s_methods[] = {
+    { "clear_calibration", &clear_calibration, },
+    { "deselect_star", &deselect_star, },
+    { "get_exposure", &get_exposure, },
+    { "set_exposure", &set_exposure, },
+    { "get_exposure_durations", &get_exposure_durations, },
+    { "get_profiles", &get_profiles, },
+    { "get_profile", &get_profile, },
+    { "set_profile", &set_profile, },
+    { "get_connected", &get_connected, },
+    { "set_connected", &set_connected, },
+    { "get_calibrated", &get_calibrated, },
+    { "get_paused", &get_paused, },
+    { "set_paused", &set_paused, },
+    { "get_lock_position", &get_lock_position, },
+    { "set_lock_position", &set_lock_position, },
+    { "loop", &loop, },
+    { "stop_capture", &stop_capture, },
+    { "guide", &guide, },
+    { "dither", &dither, },
+    { "find_star", &find_star, },
+    { "get_pixel_scale", &get_pixel_scale, },
+    { "get_app_state", &get_app_state, },
+    { "flip_calibration", &flip_calibration, },
+    { "get_lock_shift_enabled", &get_lock_shift_enabled, },
+    { "set_lock_shift_enabled", &set_lock_shift_enabled, },
+    { "get_lock_shift_params", &get_lock_shift_params, },
+    { "set_lock_shift_params", &set_lock_shift_params, },
+    { "save_image", &save_image, },
+    { "get_star_image", &get_star_image, },
+    { "get_star_images", &get_star_images, },
+    { "get_use_subframes", &get_use_subframes, },
+    { "get_search_region", &get_search_region, },
+    { "shutdown", &shutdown, },
+    { "get_camera_binning", &get_camera_binning, },
+    { "get_camera_frame_size", &get_camera_frame_size, },
+    { "get_current_equipment", &get_current_equipment, },
+    { "get_guide_output_enabled", &get_guide_output_enabled, },
+    { "set_guide_output_enabled", &set_guide_output_enabled, },
+    { "get_algo_param_names", &get_algo_param_names, },
+    { "get_algo_param", &get_algo_param, },
+    { "set_algo_param", &set_algo_param, },
+    { "get_dec_guide_mode", &get_dec_guide_mode, },
+    { "set_dec_guide_mode", &set_dec_guide_mode, },
+    { "get_settling", &get_settling, },
+    { "guide_pulse", &guide_pulse, },
+    { "get_calibration_data", &get_calibration_data, },
+    { "capture_single_frame", &capture_single_frame, },
+    { "get_cooler_status", &get_cooler_status, },
+    { "get_ccd_temperature", &get_sensor_temperature, },
+    { "export_config_settings", &export_config_settings, },
+    { "get_rpc_stats", &get_rpc_stats, },
+};
+
+inline static bool method_less(const RpcMethod& a, const RpcMethod& b)
+{
+    return strcmp(a.name, b.name) < 0;
+}
+
+// sort the method table so lookups can use a binary search. With about 50
+// methods that is at most six string compares, about what hashing the name
+// would cost, and the table stays a plain static array with no allocation.
+static void init_method_table()
+{
+    std::sort(std::begin(s_methods), std::end(s_methods), method_less);
+}
+
+static RpcMethod *find_method(const char *name)
+{
+    RpcMethod key = { name, nullptr, };
+    RpcMethod *end = std::end(s_methods);
+    RpcMethod *m = std::lower_bound(std::begin(s_methods), end, key, method_less);
+    return m != end && strcmp(m->name, name) == 0 ? m : nullptr;
+}
+
+static void record_rpc_time(RpcMethod *m, const std::chrono::steady_clock::time_point& t0)
+{
+    double const ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    RpcStats& st = m->stats;
+    ++st.count;
+    st.totalMs += ms;
+    if (ms > st.maxMs)
+        st.maxMs = ms;
+}
+
+static void get_rpc_stats(JObj& response, const json_value *params)
+{
+    JAry ary;
+    for (const RpcMethod& m : s_methods)
+    {
+        const RpcStats& st = m.stats;
+        if (!st.count)
+            continue;
+        JObj t;
+        t << NV("method", m.name)
+          << NV("count", (int) st.count)
+          << NV("avg_ms", st.totalMs / st.count, 3)
+          << NV("max_ms", st.maxMs, 3);
+        ary << t;
+    }
+    response << jrpc_result(ary);
+}
+
+static bool handle_request(JRpcCall& call, bool canDefer)
 {
     const json_value *params;
     const json_value *id;
@@ -2129,81 +2459,42 @@ static bool handle_request(JRpcCall& call)
         return true;
     }
 
-    static struct {
-        const char *name;
-        void (*fn)(JObj& response, const json_value *params);
-    } methods[] = {
-        { "clear_calibration", &clear_calibration, },
-        { "deselect_star", &deselect_star, },
-        { "get_exposure", &get_exposure, },
-        { "set_exposure", &set_exposure, },
-        { "get_exposure_durations", &get_exposure_durations, },
-        { "get_profiles", &get_profiles, },
-        { "get_profile", &get_profile, },
-        { "set_profile", &set_profile, },
-        { "get_connected", &get_connected, },
-        { "set_connected", &set_connected, },
-        { "get_calibrated", &get_calibrated, },
-        { "get_paused", &get_paused, },
-        { "set_paused", &set_paused, },
-        { "get_lock_position", &get_lock_position, },
-        { "set_lock_position", &set_lock_position, },
-        { "loop", &loop, },
-        { "stop_capture", &stop_capture, },
-        { "guide", &guide, },
-        { "dither", &dither, },
-        { "find_star", &find_star, },
-        { "get_pixel_scale", &get_pixel_scale, },
-        { "get_app_state", &get_app_state, },
-        { "flip_calibration", &flip_calibration, },
-        { "get_lock_shift_enabled", &get_lock_shift_enabled, },
-        { "set_lock_shift_enabled", &set_lock_shift_enabled, },
-        { "get_lock_shift_params", &get_lock_shift_params, },
-        { "set_lock_shift_params", &set_lock_shift_params, },
-        { "save_image", &save_image, },
-        { "get_star_image", &get_star_image, },
-        { "get_use_subframes", &get_use_subframes, },
-        { "get_search_region", &get_search_region, },
-        { "shutdown", &shutdown, },
-        { "get_camera_binning", &get_camera_binning, },
-        { "get_camera_frame_size", &get_camera_frame_size, },
-        { "get_current_equipment", &get_current_equipment, },
-        { "get_guide_output_enabled", &get_guide_output_enabled, },
-        { "set_guide_output_enabled", &set_guide_output_enabled, },
-        { "get_algo_param_names", &get_algo_param_names, },
-        { "get_algo_param", &get_algo_param, },
-        { "set_algo_param", &set_algo_param, },
-        { "get_dec_guide_mode", &get_dec_guide_mode, },
-        { "set_dec_guide_mode", &set_dec_guide_mode, },
-        { "get_settling", &get_settling, },
-        { "guide_pulse", &guide_pulse, },
-        { "get_calibration_data", &get_calibration_data, },
-        { "capture_single_frame", &capture_single_frame, },
-        { "get_cooler_status", &get_cooler_status, },
-        { "get_ccd_temperature", &get_sensor_temperature, },
-        { "export_config_settings", &export_config_settings, },
-    };
+    RpcMethod *m = find_method(call.method->string_value);
 
-    for (unsigned int i = 0; i < WXSIZEOF(methods); i++)
+    if (!m)
     {
-        if (strcmp(call.method->string_value, methods[i].name) == 0)
+        if (id)
         {
-            (*methods[i].fn)(call.response, params);
-            if (id)
-            {
-                call.response << jrpc_id(id);
-                return true;
-            }
-            else
-            {
-                return false;
-            }
+            call.response << jrpc_error(JSONRPC_METHOD_NOT_FOUND, "method not found") << jrpc_id(id);
+            return true;
+        }
+        else
+        {
+            return false;
         }
     }
 
+    std::chrono::steady_clock::time_point const t0 = std::chrono::steady_clock::now();
+
+    if (canDefer && id && m->fn == &find_star)
+    {
+        // the star search can take a while on a large frame; respond when it is
+        // done rather than blocking the GUI thread
+        bool const deferred = find_star_async(call, params, id);
+        record_rpc_time(m, t0);
+        if (deferred)
+            return false;
+
+        call.response << jrpc_id(id);
+        return true;
+    }
+
+    (*m->fn)(call.response, params);
+    record_rpc_time(m, t0);
+
     if (id)
     {
-        call.response << jrpc_error(JSONRPC_METHOD_NOT_FOUND, "method not found") << jrpc_id(id);
+        call.response << jrpc_id(id);
         return true;
     }
     else
@@ -2229,13 +2520,22 @@ static void handle_cli_input_complete(wxSocketClient *cli, char *input, JsonPars
     {
         // a batch request
 
+        if (!root->first_child)
+        {
+            JRpcCall call(cli, nullptr);
+            call.response << jrpc_error(JSONRPC_INVALID_REQUEST, "invalid request - empty batch") << jrpc_id(0);
+            dump_response(call);
+            do_notify1(cli, call.response);
+            return;
+        }
+
         JAry ary;
 
         bool found = false;
         json_for_each (req, root)
         {
             JRpcCall call(cli, req);
-            if (handle_request(call))
+            if (handle_request(call, false))
             {
                 dump_response(call);
                 ary << call.response;
@@ -2252,7 +2552,7 @@ static void handle_cli_input_complete(wxSocketClient *cli, char *input, JsonPars
 
         const json_value *const req = root;
         JRpcCall call(cli, req);
-        if (handle_request(call))
+        if (handle_request(call, true))
         {
             dump_response(call);
             do_notify1(cli, call.response);
@@ -2291,10 +2591,13 @@ static void handle_cli_input(wxSocketClient *cli, JsonParser& parser)
         if (n == 0)
             break;
 
+        // the bytes already in the buffer were scanned on an earlier read and
+        // hold no line terminator; only look at the new ones
+        char *scan = rdbuf->dest;
         rdbuf->dest += n;
 
         char *end;
-        while ((end = static_cast<char *>(memchr(rdbuf->buf(), '\n', rdbuf->len()))) != nullptr)
+        while ((end = static_cast<char *>(memchr(scan, '\n', rdbuf->dest - scan))) != nullptr)
         {
             // Copy to temporary buffer to avoid rentrancy problem
             char line[ClientReadBuf::SIZE];
@@ -2306,6 +2609,7 @@ static void handle_cli_input(wxSocketClient *cli, JsonParser& parser)
             size_t len2 = rdbuf->dest - next;
             memmove(rdbuf->buf(), next, len2);
             rdbuf->dest = rdbuf->buf() + len2;
+            scan = rdbuf->buf();
 
             handle_cli_input_complete(cli, line, parser);
         }
@@ -2313,7 +2617,11 @@ static void handle_cli_input(wxSocketClient *cli, JsonParser& parser)
 }
 
 EventServer::EventServer()
-    : m_configEventDebouncer(nullptr)
+    :
+#ifdef wxHAS_UNIX_DOMAIN_SOCKETS
+    m_unixServerSocket(nullptr),
+#endif
+    m_configEventDebouncer(nullptr)
 {
 }
 
@@ -2346,6 +2654,46 @@ bool EventServer::EventServerStart(unsigned int instanceId)
     m_serverSocket->SetNotify(wxSOCKET_CONNECTION_FLAG);
     m_serverSocket->Notify(true);
 
+#ifdef wxHAS_UNIX_DOMAIN_SOCKETS
+    // optional local listener; clients on the same host skip the TCP stack
+    if (pConfig->Global.GetBoolean("/server/unix_socket", false))
+    {
+        m_unixSocketPath = wxFileName(wxFileName::GetTempDir(),
+            wxString::Format("phd2-events-%u.sock", instanceId)).GetFullPath();
+
+        // a socket file left by a previous run that did not shut down cleanly
+        // would make bind() fail
+        if (wxFileExists(m_unixSocketPath))
+            ::wxRemoveFile(m_unixSocketPath);
+
+        wxUNIXaddress unixAddr;
+        unixAddr.Filename(m_unixSocketPath);
+        m_unixServerSocket = new wxSocketServer(unixAddr);
+
+        if (m_unixServerSocket->Ok())
+        {
+            m_unixServerSocket->SetEventHandler(*this, EVENT_SERVER_ID);
+            m_unixServerSocket->SetNotify(wxSOCKET_CONNECTION_FLAG);
+            m_unixServerSocket->Notify(true);
+            Debug.Write(wxString::Format("event server listening on %s\n", m_unixSocketPath));
+        }
+        else
+        {
+            Debug.Write(wxString::Format("Event server could not listen on %s\n", m_unixSocketPath));
+            delete m_unixServerSocket;
+            m_unixServerSocket = nullptr;
+        }
+    }
+#endif
+
+    if (pConfig->Global.GetBoolean("/server/status_block", false))
+        m_statusBlock.Open(instanceId);
+
+    init_method_table();
+
+    s_maxQueuedBytes = pConfig->Global.GetInt("/server/max_queued_bytes", DefaultMaxQueuedBytes);
+    s_disconnectSlowClients = pConfig->Global.GetBoolean("/server/disconnect_slow_clients", false);
+
     m_configEventDebouncer = new wxTimer();
 
     Debug.Write(wxString::Format("event server started, listening on port %u\n", port));
@@ -2365,9 +2713,22 @@ void EventServer::EventServerStop()
     }
     m_eventServerClients.clear();
 
+    release_pending_find_star();
+
     delete m_serverSocket;
     m_serverSocket = nullptr;
 
+#ifdef wxHAS_UNIX_DOMAIN_SOCKETS
+    if (m_unixServerSocket)
+    {
+        delete m_unixServerSocket;
+        m_unixServerSocket = nullptr;
+        ::wxRemoveFile(m_unixSocketPath);
+    }
+#endif
+
+    m_statusBlock.Close();
+
     delete m_configEventDebouncer;
     m_configEventDebouncer = nullptr;
 
@@ -2389,7 +2750,7 @@ void EventServer::OnEventServerEvent(wxSocketEvent& event)
     Debug.Write(wxString::Format("evsrv: cli %p connect\n", client));
 
     client->SetEventHandler(*this, EVENT_SERVER_CLIENT_ID);
-    client->SetNotify(wxSOCKET_LOST_FLAG | wxSOCKET_INPUT_FLAG);
+    client->SetNotify(wxSOCKET_LOST_FLAG | wxSOCKET_INPUT_FLAG | wxSOCKET_OUTPUT_FLAG);
     client->SetFlags(wxSOCKET_NOWAIT);
     client->Notify(true);
     client->SetClientData(new ClientData(client));
@@ -2403,26 +2764,72 @@ void EventServer::OnEventServerClientEvent(wxSocketEvent& event)
 {
     wxSocketClient *cli = static_cast<wxSocketClient *>(event.GetSocket());
 
+    if (m_eventServerClients.find(cli) == m_eventServerClients.end())
+    {
+        // a client we dropped for falling behind; its remaining events are stale
+        Debug.Write(wxString::Format("evsrv: ignoring event %d for removed cli %p\n", event.GetSocketEvent(), cli));
+        return;
+    }
+
     if (event.GetSocketEvent() == wxSOCKET_LOST)
     {
         Debug.Write(wxString::Format("evsrv: cli %p disconnect\n", cli));
 
-        unsigned int const n = m_eventServerClients.erase(cli);
-        if (n != 1)
-            Debug.AddLine("client disconnected but not present in client set!");
-
+        log_client_stats(cli);
+        m_eventServerClients.erase(cli);
         destroy_client(cli);
     }
     else if (event.GetSocketEvent() == wxSOCKET_INPUT)
     {
         handle_cli_input(cli, m_parser);
     }
+    else if (event.GetSocketEvent() == wxSOCKET_OUTPUT)
+    {
+        ClientData *cd = client_data(cli);
+        wxMutexLocker lock(cd->wrlock);
+        flush_queue(cd);
+    }
     else
     {
         Debug.Write(wxString::Format("unexpected client socket event %d\n", event.GetSocketEvent()));
     }
 }
 
+void EventServer::OnSlowClient(wxThreadEvent& event)
+{
+    ClientData *cd = event.GetPayload<ClientData *>();
+    wxSocketClient *cli = cd->cli;
+
+    if (m_eventServerClients.erase(cli) == 1)
+    {
+        Debug.Write(wxString::Format("evsrv: cli %p disconnected, too far behind\n", cli));
+        log_client_stats(cli);
+        cli->Notify(false);
+        cli->Close();
+        destroy_client(cli);
+    }
+
+    // release the reference taken by disconnect_slow_client
+    cd->RemoveRef();
+}
+
+void EventServer::NotifyAutoSelectComplete(bool error)
+{
+    if (s_pendingFindStar.empty())
+        return;
+
+    for (const auto& req : s_pendingFindStar)
+    {
+        JRpcCall call(req.cli, nullptr);
+        find_star_result(call.response, error);
+        call.response << req.id;
+        dump_response(call);
+        do_notify1(req.cli, call.response);
+    }
+
+    release_pending_find_star();
+}
+
 void EventServer::NotifyStartCalibration(const Mount *mount)
 {
     SIMPLE_NOTIFY_EV(ev_start_calibration(mount));
@@ -2545,6 +2952,10 @@ void EventServer::NotifyResumed()
 
 void EventServer::NotifyGuideStep(const GuideStepInfo& step)
 {
+    // publish right away so readers see the step with the frame it belongs to
+    m_statusBlock.SetGuideStep(step);
+    m_statusBlock.Publish();
+
     if (m_eventServerClients.empty())
         return;
 
@@ -2643,7 +3054,7 @@ void EventServer::NotifySettling(double distance, double time, double settleTime
 
     Ev ev(ev_settling(distance, time, settleTime, starLocked));
 
-    Debug.Write(wxString::Format("evsrv: %s\n", ev.str()));
+    Debug.Write(wxString::Format("evsrv: %s\n", wxstr(ev)));
 
     do_notify(m_eventServerClients, ev);
 }
@@ -2655,7 +3066,7 @@ void EventServer::NotifySettleDone(const wxString& errorMsg, int settleFrames, i
 
     Ev ev(ev_settle_done(errorMsg, settleFrames, droppedFrames));
 
-    Debug.Write(wxString::Format("evsrv: %s\n", ev.str()));
+    Debug.Write(wxString::Format("evsrv: %s\n", wxstr(ev)));
 
     do_notify(m_eventServerClients, ev);
 }
@@ -2733,3 +3144,8 @@ void EventServer::NotifyConfigurationChange()
     do_notify(m_eventServerClients, ev);
     m_configEventDebouncer->StartOnce(0);
 }
+
+void EventServer::NotifyFrameComplete()
+{
+    m_statusBlock.Publish();
+}
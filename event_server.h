@@ -46,8 +46,13 @@ public:
 private:
     JsonParser m_parser;
     wxSocketServer *m_serverSocket;
+#ifdef wxHAS_UNIX_DOMAIN_SOCKETS
+    wxSocketServer *m_unixServerSocket;
+    wxString m_unixSocketPath;
+#endif
     CliSockSet m_eventServerClients;
     wxTimer *m_configEventDebouncer;
+    StatusBlock m_statusBlock;
 
 public:
     EventServer();
@@ -64,6 +69,7 @@ public:
     void NotifyLooping(unsigned int exposure);
     void NotifyLoopingStopped();
     void NotifyStarSelected(const PHD_Point& pos);
+    void NotifyAutoSelectComplete(bool error);
     void NotifyStarLost(const FrameDroppedInfo& info);
     void NotifyGuidingStarted();
     void NotifyGuidingStopped();
@@ -84,10 +90,12 @@ public:
     void NotifyGuidingParam(const wxString& name, bool val);
     void NotifyGuidingParam(const wxString& name, const wxString& val);
     void NotifyConfigurationChange();
+    void NotifyFrameComplete();
 
 private:
     void OnEventServerEvent(wxSocketEvent& evt);
     void OnEventServerClientEvent(wxSocketEvent& evt);
+    void OnSlowClient(wxThreadEvent& evt);
 
     wxDECLARE_EVENT_TABLE();
 };
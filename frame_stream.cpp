@@ -0,0 +1,499 @@
+/*
+ *  frame_stream.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+
+#include <wx/sckstrm.h>
+
+FrameStreamServer FrameStream;
+
+BEGIN_EVENT_TABLE(FrameStreamServer, wxEvtHandler)
+    EVT_SOCKET(FRAME_STREAM_SERVER_ID, FrameStreamServer::OnServerEvent)
+    EVT_SOCKET(FRAME_STREAM_CLIENT_ID, FrameStreamServer::OnClientEvent)
+    EVT_THREAD(FRAME_STREAM_ENCODED_ID, FrameStreamServer::OnFrameEncoded)
+END_EVENT_TABLE()
+
+static_assert(sizeof(FRAME_STREAM_HEADER) == 56, "frame stream header must not be padded");
+
+struct FrameStreamClient
+{
+    enum { MAX_INPUT = 1024 };
+
+    wxSocketClient *cli;
+    int binning;
+    int compression;
+    std::string input;                  // partial option line
+    FrameStreamMsg pending;             // frame the socket has not taken all of yet
+    size_t sent;                        // bytes of pending already sent
+    unsigned int framesSent;
+    unsigned int framesSkipped;
+
+    FrameStreamClient(wxSocketClient *cli_)
+        : cli(cli_), binning(1), compression(FRAME_COMPRESS_NONE), sent(0), framesSent(0), framesSkipped(0) { }
+
+    bool busy() const { return pending != nullptr; }
+    int encoding() const { return (binning - 1) * 2 + compression; }
+};
+
+inline static FrameStreamClient *stream_client(wxSocketClient *cli)
+{
+    return (FrameStreamClient *) cli->GetClientData();
+}
+
+// write without blocking; returns the number of bytes the socket took
+static size_t write_some(wxSocketClient *cli, const unsigned char *buf, size_t len)
+{
+    cli->Write(buf, len);
+    return cli->LastWriteCount();
+}
+
+// the header is written field by field so it is little-endian whatever the host
+inline static void put_le(unsigned char *&p, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        *p++ = (unsigned char) (v >> (8 * i));
+}
+
+inline static void put_varint(unsigned char *&p, unsigned int v)
+{
+    while (v >= 0x80)
+    {
+        *p++ = (unsigned char) (v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (unsigned char) v;
+}
+
+static void EncodeFrame(FrameStreamJob *job, int encoding);
+
+// encodes the frames posted by the server, one at a time, and tells the server
+// when each one is done
+class FrameStreamEncoder : public wxThread
+{
+    FrameStreamServer *m_server;
+    wxMessageQueue<FrameStreamJob *> m_queue;   // null to exit
+
+public:
+    FrameStreamEncoder(FrameStreamServer *server) : wxThread(wxTHREAD_JOINABLE), m_server(server) { }
+    void Post(FrameStreamJob *job) { m_queue.Post(job); }
+
+protected:
+    ExitCode Entry() override
+    {
+        FrameStreamJob *job;
+        while (m_queue.Receive(job) == wxMSGQUEUE_NO_ERROR && job)
+        {
+            for (int i = 0; i < FRAME_STREAM_NR_ENCODINGS; i++)
+                if (job->wanted[i])
+                    EncodeFrame(job, i);
+
+            wxQueueEvent(m_server, new wxThreadEvent(wxEVT_THREAD, FRAME_STREAM_ENCODED_ID));
+        }
+        return (ExitCode) 0;
+    }
+};
+
+FrameStreamServer::FrameStreamServer()
+    : m_serverSocket(nullptr), m_encoder(nullptr), m_encoding(false)
+{
+}
+
+FrameStreamServer::~FrameStreamServer()
+{
+}
+
+bool FrameStreamServer::Start(unsigned int instanceId)
+{
+    if (m_serverSocket)
+    {
+        Debug.AddLine("attempt to start frame stream server when it is already started?");
+        return false;
+    }
+
+    unsigned int port = 4500 + instanceId - 1;
+    wxIPV4address addr;
+    addr.Service(port);
+    m_serverSocket = new wxSocketServer(addr, wxSOCKET_REUSEADDR);
+
+    if (!m_serverSocket->Ok())
+    {
+        Debug.Write(wxString::Format("Frame stream server failed to start - Could not listen at port %u\n", port));
+        delete m_serverSocket;
+        m_serverSocket = nullptr;
+        return true;
+    }
+
+    m_encoder = new FrameStreamEncoder(this);
+    if (m_encoder->Run() != wxTHREAD_NO_ERROR)
+    {
+        Debug.Write("Frame stream server failed to start - Could not start the encoder thread\n");
+        delete m_encoder;
+        m_encoder = nullptr;
+        delete m_serverSocket;
+        m_serverSocket = nullptr;
+        return true;
+    }
+
+    m_serverSocket->SetEventHandler(*this, FRAME_STREAM_SERVER_ID);
+    m_serverSocket->SetNotify(wxSOCKET_CONNECTION_FLAG);
+    m_serverSocket->Notify(true);
+
+    Debug.Write(wxString::Format("frame stream server started, listening on port %u\n", port));
+
+    return false;
+}
+
+void FrameStreamServer::Stop()
+{
+    if (!m_serverSocket)
+        return;
+
+    for (CliSockSet::const_iterator it = m_clients.begin(); it != m_clients.end(); ++it)
+        DestroyClient(*it);
+    m_clients.clear();
+
+    delete m_serverSocket;
+    m_serverSocket = nullptr;
+
+    m_encoder->Post(nullptr);
+    m_encoder->Wait();
+    delete m_encoder;
+    m_encoder = nullptr;
+
+    // drop the completion of a frame that was being encoded
+    DeletePendingEvents();
+    m_encoding = false;
+
+    for (int i = 0; i < FRAME_STREAM_NR_ENCODINGS; i++)
+        m_job.encoded[i].reset();
+    std::vector<unsigned short>().swap(m_job.pixels);
+
+    Debug.AddLine("frame stream server stopped");
+}
+
+void FrameStreamServer::DestroyClient(wxSocketClient *cli)
+{
+    FrameStreamClient *client = stream_client(cli);
+    Debug.Write(wxString::Format("fsrv: cli %p %u frames sent, %u skipped\n", cli,
+        client->framesSent, client->framesSkipped));
+    delete client;
+    cli->Destroy();
+}
+
+void FrameStreamServer::OnServerEvent(wxSocketEvent& event)
+{
+    wxSocketServer *server = static_cast<wxSocketServer *>(event.GetSocket());
+
+    if (event.GetSocketEvent() != wxSOCKET_CONNECTION)
+        return;
+
+    wxSocketClient *cli = static_cast<wxSocketClient *>(server->Accept(false));
+
+    if (!cli)
+        return;
+
+    Debug.Write(wxString::Format("fsrv: cli %p connect\n", cli));
+
+    cli->SetEventHandler(*this, FRAME_STREAM_CLIENT_ID);
+    cli->SetNotify(wxSOCKET_LOST_FLAG | wxSOCKET_INPUT_FLAG | wxSOCKET_OUTPUT_FLAG);
+    cli->SetFlags(wxSOCKET_NOWAIT);
+    cli->Notify(true);
+    cli->SetClientData(new FrameStreamClient(cli));
+
+    m_clients.insert(cli);
+}
+
+void FrameStreamServer::OnClientEvent(wxSocketEvent& event)
+{
+    wxSocketClient *cli = static_cast<wxSocketClient *>(event.GetSocket());
+
+    if (m_clients.find(cli) == m_clients.end())
+        return;
+
+    FrameStreamClient *client = stream_client(cli);
+
+    switch (event.GetSocketEvent())
+    {
+    case wxSOCKET_LOST:
+        Debug.Write(wxString::Format("fsrv: cli %p disconnect\n", cli));
+        m_clients.erase(cli);
+        DestroyClient(cli);
+        break;
+
+    case wxSOCKET_INPUT:
+        HandleInput(client);
+        break;
+
+    case wxSOCKET_OUTPUT:
+        if (client->busy())
+        {
+            const std::vector<unsigned char>& msg = *client->pending;
+            client->sent += write_some(cli, &msg[client->sent], msg.size() - client->sent);
+            if (client->sent == msg.size())
+            {
+                client->pending.reset();
+                client->sent = 0;
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void FrameStreamServer::HandleInput(FrameStreamClient *client)
+{
+    wxSocketInputStream sis(*client->cli);
+
+    while (sis.CanRead())
+    {
+        char buf[256];
+        size_t n = sis.Read(buf, sizeof(buf)).LastRead();
+        if (n == 0)
+            break;
+        client->input.append(buf, n);
+    }
+
+    size_t eol;
+    while ((eol = client->input.find('\n')) != std::string::npos)
+    {
+        std::string line(client->input, 0, eol);
+        client->input.erase(0, eol + 1);
+
+        if (!m_parser.Parse(line) || m_parser.Root()->type != JSON_OBJECT)
+        {
+            Debug.Write(wxString::Format("fsrv: cli %p ignoring invalid options: %s\n", client->cli, wxString(line)));
+            continue;
+        }
+
+        json_for_each (j, m_parser.Root())
+        {
+            if (strcmp(j->name, "bin") == 0 && j->type == JSON_INT && (j->int_value == 1 || j->int_value == 2))
+                client->binning = j->int_value;
+            else if (strcmp(j->name, "compress") == 0 && j->type == JSON_STRING)
+            {
+                if (strcmp(j->string_value, "none") == 0)
+                    client->compression = FRAME_COMPRESS_NONE;
+                else if (strcmp(j->string_value, "delta") == 0)
+                    client->compression = FRAME_COMPRESS_DELTA;
+            }
+        }
+
+        Debug.Write(wxString::Format("fsrv: cli %p options bin=%d compress=%d\n", client->cli,
+            client->binning, client->compression));
+    }
+
+    if (client->input.size() > FrameStreamClient::MAX_INPUT)
+        client->input.clear();
+}
+
+// runs on the encoder thread
+static void EncodeFrame(FrameStreamJob *job, int encoding)
+{
+    int const binning = encoding / 2 + 1;
+    int const compression = encoding % 2;
+    FrameStreamMsg& enc = job->encoded[encoding];
+
+    // a slow client may still be sending the previous frame from this buffer
+    if (!enc || enc.use_count() > 1)
+        enc = std::make_shared<std::vector<unsigned char>>();
+    std::vector<unsigned char>& msg = *enc;
+
+    const wxRect& rgn = job->rgn;
+    int const width = job->size.GetWidth() / binning;
+    int const height = job->size.GetHeight() / binning;
+    int const x0 = rgn.GetLeft() / binning;
+    int const y0 = rgn.GetTop() / binning;
+    int const w = wxMin(rgn.GetWidth() / binning, width - x0);
+    int const h = wxMin(rgn.GetHeight() / binning, height - y0);
+
+    // worst case 3 bytes per pixel for delta encoding
+    size_t const maxPayload = (size_t) w * h * (compression == FRAME_COMPRESS_DELTA ? 3 : 2);
+    msg.resize(sizeof(FRAME_STREAM_HEADER) + maxPayload);
+
+    unsigned char *const payload = &msg[sizeof(FRAME_STREAM_HEADER)];
+    unsigned char *p = payload;
+    unsigned short prev = 0;
+    int const stride = job->copied.GetWidth();
+    int const cx = job->copied.GetLeft();
+    int const cy = job->copied.GetTop();
+
+    for (int y = y0; y < y0 + h; y++)
+    {
+        for (int x = x0; x < x0 + w; x++)
+        {
+            unsigned short val;
+            if (binning == 2)
+            {
+                const unsigned short *s = &job->pixels[(2 * y - cy) * stride + 2 * x - cx];
+                val = (unsigned short) (((unsigned int) s[0] + s[1] + s[stride] + s[stride + 1]) / 4);
+            }
+            else
+                val = job->pixels[(y - cy) * stride + x - cx];
+
+            if (compression == FRAME_COMPRESS_DELTA)
+            {
+                short const d = (short) (val - prev);
+                put_varint(p, (unsigned short) ((d << 1) ^ (d >> 15)));
+                prev = val;
+            }
+            else
+            {
+                *p++ = (unsigned char) val;
+                *p++ = (unsigned char) (val >> 8);
+            }
+        }
+    }
+
+    size_t const payloadSize = p - payload;
+    msg.resize(sizeof(FRAME_STREAM_HEADER) + payloadSize);
+
+    // FRAME_STREAM_HEADER, in field order
+    unsigned char *hp = &msg[0];
+    memcpy(hp, "PHDF", 4);
+    hp += 4;
+    put_le(hp, FRAME_STREAM_VERSION, 2);
+    put_le(hp, sizeof(FRAME_STREAM_HEADER), 2);
+    put_le(hp, job->frameNumber, 4);
+    put_le(hp, payloadSize, 4);
+    put_le(hp, width, 2);
+    put_le(hp, height, 2);
+    put_le(hp, x0, 2);
+    put_le(hp, y0, 2);
+    put_le(hp, w, 2);
+    put_le(hp, h, 2);
+    put_le(hp, binning, 1);
+    put_le(hp, compression, 1);
+    put_le(hp, job->bitsPerPixel, 1);
+    put_le(hp, 0, 1); // reserved1
+    put_le(hp, (uint32_t) job->exposureMs, 4);
+    put_le(hp, job->minADU, 2);
+    put_le(hp, job->maxADU, 2);
+    put_le(hp, job->medianADU, 2);
+    put_le(hp, job->pedestal, 2);
+    put_le(hp, 0, 4); // reserved2
+    put_le(hp, (uint64_t) job->startTime, 8);
+    assert(hp == &msg[sizeof(FRAME_STREAM_HEADER)]);
+}
+
+void FrameStreamServer::SendFrame(FrameStreamClient *client, const FrameStreamMsg& msg)
+{
+    size_t n = write_some(client->cli, &(*msg)[0], msg->size());
+    if (n < msg->size())
+    {
+        // the rest goes out from the wxSOCKET_OUTPUT handler
+        client->pending = msg;
+        client->sent = n;
+    }
+    ++client->framesSent;
+}
+
+void FrameStreamServer::NotifyFrame(const usImage *img)
+{
+    if (m_clients.empty() || !img || !img->ImageData)
+        return;
+
+    FrameStreamJob& job = m_job;
+    bool wanted = false;
+
+    for (int i = 0; i < FRAME_STREAM_NR_ENCODINGS; i++)
+        job.wanted[i] = false;
+
+    for (CliSockSet::const_iterator it = m_clients.begin(); it != m_clients.end(); ++it)
+    {
+        FrameStreamClient *client = stream_client(*it);
+
+        if (m_encoding || client->busy())
+        {
+            // still encoding or sending an earlier frame; skip this one rather than queue it
+            ++client->framesSkipped;
+            continue;
+        }
+
+        job.wanted[client->encoding()] = wanted = true;
+    }
+
+    if (!wanted)
+        return;
+
+    // Copy the pixels the encodings read, since the guider replaces the frame
+    // with the next one. 2x2 binning starts on an even pixel; otherwise both
+    // binnings read the same region.
+    job.size = img->Size;
+    job.rgn = img->Subframe.IsEmpty() ? wxRect(img->Size) : img->Subframe;
+    int const cx0 = job.rgn.GetLeft() & ~1;
+    int const cy0 = job.rgn.GetTop() & ~1;
+    int const cx1 = wxMin(job.rgn.GetLeft() + job.rgn.GetWidth(), img->Size.GetWidth());
+    int const cy1 = wxMin(job.rgn.GetTop() + job.rgn.GetHeight(), img->Size.GetHeight());
+    job.copied = wxRect(cx0, cy0, cx1 - cx0, cy1 - cy0);
+
+    job.pixels.resize((size_t) job.copied.GetWidth() * job.copied.GetHeight());
+    for (int y = cy0; y < cy1; y++)
+    {
+        memcpy(&job.pixels[(size_t) (y - cy0) * job.copied.GetWidth()],
+            img->ImageData + (size_t) y * img->Size.GetWidth() + cx0, job.copied.GetWidth() * sizeof(unsigned short));
+    }
+
+    job.frameNumber = img->FrameNum;
+    job.bitsPerPixel = img->BitsPerPixel;
+    job.exposureMs = img->ImgExpDur;
+    job.minADU = img->MinADU;
+    job.maxADU = img->MaxADU;
+    job.medianADU = img->MedianADU;
+    job.pedestal = img->Pedestal;
+    job.startTime = img->ImgStartTime.IsValid() ? img->ImgStartTime.GetValue().GetValue() : 0;
+
+    m_encoding = true;
+    m_encoder->Post(&job);
+}
+
+void FrameStreamServer::OnFrameEncoded(wxThreadEvent& evt)
+{
+    m_encoding = false;
+
+    for (CliSockSet::const_iterator it = m_clients.begin(); it != m_clients.end(); ++it)
+    {
+        FrameStreamClient *client = stream_client(*it);
+
+        if (client->busy())
+            continue; // counted as skipped when the frame arrived
+
+        int const encoding = client->encoding();
+        if (m_job.wanted[encoding])
+            SendFrame(client, m_job.encoded[encoding]);
+        else
+            ++client->framesSkipped; // connected or changed options while the frame was encoded
+    }
+}
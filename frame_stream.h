@@ -0,0 +1,171 @@
+/*
+ *  frame_stream.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef FRAME_STREAM_INCLUDED
+#define FRAME_STREAM_INCLUDED
+
+#include <memory>
+#include <set>
+#include "json_parser.h"
+
+class usImage;
+
+/*
+ * Live image stream for remote monitoring. When the global setting
+ * /server/frame_stream is on (default off), the stream is started with the
+ * server and clients connect to a separate port (4500 + instance - 1). They
+ * receive every captured frame as a binary message: a fixed FRAME_STREAM_HEADER
+ * followed by the pixel payload. A client may send a line of JSON at any time
+ * to choose its stream options, for example
+ *
+ *   {"bin":2,"compress":"delta"}
+ *
+ * "bin" is 1 or 2 (2x2 average), "compress" is "none" or "delta". Frames are
+ * encoded on a background thread and never queued behind one another: if a
+ * client has not finished receiving the previous frame, or the previous frame
+ * is still being encoded, new frames are skipped for that client until it
+ * catches up, so a slow client never holds up capture. Gaps in the frame
+ * number tell the client how many frames it missed.
+ */
+
+enum
+{
+    FRAME_STREAM_VERSION = 1,
+};
+
+enum FRAME_STREAM_COMPRESSION
+{
+    FRAME_COMPRESS_NONE = 0,  // little-endian uint16 pixels, row by row
+    FRAME_COMPRESS_DELTA = 1, // each pixel minus the previous one (row by row, carried across
+                              // rows, starting from 0), zigzag encoded and written as a
+                              // little-endian base-128 varint of 1 to 3 bytes
+};
+
+// All fields little-endian, no padding; 56 bytes. The server writes the fields
+// one by one, so the byte order does not depend on the host.
+struct FRAME_STREAM_HEADER
+{
+    char magic[4];              // "PHDF"
+    uint16_t version;           // FRAME_STREAM_VERSION
+    uint16_t headerSize;        // sizeof(FRAME_STREAM_HEADER)
+    uint32_t frameNumber;
+    uint32_t payloadSize;       // bytes following the header
+    uint16_t width;             // full frame size, after binning
+    uint16_t height;
+    uint16_t x;                 // region sent (the subframe or the full frame), after binning
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint8_t binning;            // 1 or 2
+    uint8_t compression;        // FRAME_STREAM_COMPRESSION
+    uint8_t bitsPerPixel;
+    uint8_t reserved1;
+    uint32_t exposureMs;
+    uint16_t minADU;            // statistics of the unbinned frame
+    uint16_t maxADU;
+    uint16_t medianADU;
+    uint16_t pedestal;
+    uint32_t reserved2;
+    int64_t startTime;          // exposure start, milliseconds since 1970-01-01 UTC
+};
+
+struct FrameStreamClient;
+class FrameStreamEncoder;
+
+// an encoded frame, shared by all the clients it is being sent to
+typedef std::shared_ptr<std::vector<unsigned char>> FrameStreamMsg;
+
+enum { FRAME_STREAM_NR_ENCODINGS = 4 }; // binning 1/2 x compression none/delta
+
+/*
+ * A frame handed to the encoder thread: a copy of the pixels and header fields
+ * the encodings need, and the encoded messages. Only one frame is encoded at a
+ * time; the GUI thread does not touch the job while the encoder has it.
+ */
+struct FrameStreamJob
+{
+    bool wanted[FRAME_STREAM_NR_ENCODINGS];
+    FrameStreamMsg encoded[FRAME_STREAM_NR_ENCODINGS]; // reused once no client holds them
+
+    std::vector<unsigned short> pixels; // the part of the frame the encodings read
+    wxRect copied;                      // where pixels came from in the frame
+    wxSize size;                        // frame size
+    wxRect rgn;                         // subframe, or the full frame
+    unsigned int frameNumber;
+    int bitsPerPixel;
+    int exposureMs;
+    unsigned short minADU;
+    unsigned short maxADU;
+    unsigned short medianADU;
+    unsigned short pedestal;
+    int64_t startTime;
+};
+
+class FrameStreamServer : public wxEvtHandler
+{
+public:
+    typedef std::set<wxSocketClient *> CliSockSet;
+
+private:
+    JsonParser m_parser;
+    wxSocketServer *m_serverSocket;
+    CliSockSet m_clients;
+    FrameStreamEncoder *m_encoder;
+    FrameStreamJob m_job;
+    bool m_encoding;                    // m_job is with the encoder thread
+
+    void HandleInput(FrameStreamClient *client);
+    void SendFrame(FrameStreamClient *client, const FrameStreamMsg& msg);
+    void DestroyClient(wxSocketClient *cli);
+
+public:
+    FrameStreamServer();
+    ~FrameStreamServer();
+
+    bool Start(unsigned int instanceId);
+    void Stop();
+
+    void NotifyFrame(const usImage *img);
+
+private:
+    void OnServerEvent(wxSocketEvent& evt);
+    void OnClientEvent(wxSocketEvent& evt);
+    void OnFrameEncoded(wxThreadEvent& evt);
+
+    wxDECLARE_EVENT_TABLE();
+};
+
+extern FrameStreamServer FrameStream;
+
+#endif
@@ -918,12 +918,22 @@ void GearDialog::OnChar(wxKeyEvent& evt)
     }
 }
 
+// An auto-select still running on a background thread has its result tied to
+// the camera that took the frame; finish it before the camera goes away
+static void CancelAutoSelect()
+{
+    if (pFrame && pFrame->pGuider)
+        pFrame->pGuider->CancelAutoSelect();
+}
+
 void GearDialog::OnChoiceCamera(wxCommandEvent& event)
 {
     try
     {
         wxString choice = m_pCameras->GetStringSelection();
 
+        CancelAutoSelect();
+
         delete m_pCamera;
         m_pCamera = nullptr;
 
@@ -1248,6 +1258,8 @@ void GearDialog::OnButtonDisconnectCamera(wxCommandEvent& event)
             throw THROW_INFO("OnButtonDisconnectCamera: called when not connected");
         }
 
+        CancelAutoSelect();
+
         m_pCamera->Disconnect();
 
         if (m_pScope && m_pScope->RequiresCamera() && m_pScope->IsConnected())
@@ -2053,6 +2065,7 @@ void GearDialog::Shutdown(bool forced)
     if (!forced && m_pCamera && m_pCamera->Connected)
     {
         Debug.AddLine("Shutdown: disconnect camera");
+        CancelAutoSelect();
         m_pCamera->Disconnect();
     }
 
@@ -99,11 +99,13 @@ inline void DeflectionLogger::Log(const PHD_Point&) { }
 
 static const int DefaultOverlayMode  = OVERLAY_NONE;
 static const bool DefaultScaleImage  = true;
+static const int DefaultDisplayMaxFps = 0; // no limit
 
 BEGIN_EVENT_TABLE(Guider, wxWindow)
     EVT_PAINT(Guider::OnPaint)
     EVT_CLOSE(Guider::OnClose)
     EVT_ERASE_BACKGROUND(Guider::OnErase)
+    EVT_THREAD(DISPLAY_RENDER_COMPLETE_EVENT, Guider::OnDisplayRenderComplete)
 END_EVENT_TABLE()
 
 static void SaveBookmarks(const std::vector<wxRealPoint>& vec)
@@ -156,6 +158,9 @@ Guider::Guider(wxWindow *parent, int xSize, int ySize) :
     m_scaleFactor = 1.0;
     m_showBookmarks = true;
     m_displayedImage = new wxImage(XWinSize,YWinSize,true);
+    m_displayedBitmapStale = true;
+    m_displayMaxFps = DefaultDisplayMaxFps;
+    m_scaleImage = DefaultScaleImage;
     m_paused = PAUSE_NONE;
     m_starFoundTimestamp = 0;
     m_avgDistanceNeedReset = false;
@@ -190,11 +195,15 @@ Guider::Guider(wxWindow *parent, int xSize, int ySize) :
     SetBackgroundStyle(wxBG_STYLE_CUSTOM);
     SetBackgroundColour(wxColour((unsigned char) 30, (unsigned char) 30,(unsigned char) 30));
 
+    // if the render thread does not start the display is rendered in PaintHelper
+    m_displayRenderer.Start(this);
+
     s_deflectionLogger.Init();
 }
 
 Guider::~Guider()
 {
+    m_displayRenderer.Stop();
     delete m_displayedImage;
     delete m_pCurrentImage;
 
@@ -209,6 +218,8 @@ void Guider::LoadProfileSettings()
     bool scaleImage = pConfig->Profile.GetBoolean("/guider/ScaleImage", DefaultScaleImage);
     SetScaleImage(scaleImage);
 
+    SetDisplayMaxFps(pConfig->Profile.GetInt("/guider/DisplayMaxFps", DefaultDisplayMaxFps));
+
     double minHFD = pConfig->Profile.GetDouble("/guider/StarMinHFD", 0.);
     SetMinStarHFD(minHFD);
 
@@ -223,8 +234,10 @@ void Guider::LoadProfileSettings()
     // clear the display
     if (m_pCurrentImage->ImageData)
     {
+        m_displayRenderer.Discard();
         delete m_displayedImage;
         m_displayedImage = new wxImage(XWinSize, YWinSize, true);
+        m_displayedBitmapStale = true;
         DisplayImage(new usImage());
     }
 }
@@ -397,7 +410,12 @@ bool Guider::SetScaleImage(bool newScaleValue)
 
     try
     {
+        bool changed = newScaleValue != m_scaleImage;
         m_scaleImage = newScaleValue;
+
+        // the displayed image is only re-rendered when something changes
+        if (changed && m_pCurrentImage->ImageData)
+            UpdateImageDisplay();
     }
     catch (const wxString& Msg)
     {
@@ -409,6 +427,13 @@ bool Guider::SetScaleImage(bool newScaleValue)
     return bError;
 }
 
+void Guider::SetDisplayMaxFps(int fps)
+{
+    m_displayMaxFps = wxMax(0, fps);
+    m_displayRenderer.SetMaxFps(m_displayMaxFps);
+    pConfig->Profile.SetInt("/guider/DisplayMaxFps", m_displayMaxFps);
+}
+
 void Guider::OnErase(wxEraseEvent& evt)
 {
     evt.Skip();
@@ -428,73 +453,25 @@ bool Guider::PaintHelper(wxAutoBufferedPaintDCBase& dc, wxMemoryDC& memDC)
         GUIDER_STATE state = GetState();
         GetSize(&XWinSize, &YWinSize);
 
-        if (m_pCurrentImage->ImageData)
+        // the window was resized since the image was rendered; until the new
+        // rendering arrives the old one is shown
+        if (m_pCurrentImage->ImageData && m_renderWinSize != wxSize(XWinSize, YWinSize))
         {
-            int blevel = m_pCurrentImage->FiltMin;
-            int wlevel = m_pCurrentImage->FiltMax;
-            m_pCurrentImage->CopyToImage(&m_displayedImage, blevel, wlevel, pFrame->Stretch_gamma);
-        }
-
-        int imageWidth   = m_displayedImage->GetWidth();
-        int imageHeight  = m_displayedImage->GetHeight();
-
-        // scale the image if necessary
-
-        if (imageWidth != XWinSize || imageHeight != YWinSize)
-        {
-            // The image is not the exact right size -- figure out what to do.
-            double xScaleFactor = imageWidth / (double)XWinSize;
-            double yScaleFactor = imageHeight / (double)YWinSize;
-            int newWidth = imageWidth;
-            int newHeight = imageHeight;
-
-            double newScaleFactor = (xScaleFactor > yScaleFactor) ?
-                                    xScaleFactor :
-                                    yScaleFactor;
-
-//            Debug.Write(wxString::Format("xScaleFactor=%.2f, yScaleFactor=%.2f, newScaleFactor=%.2f\n", xScaleFactor,
-//                    yScaleFactor, newScaleFactor));
-
-            // we rescale the image if:
-            // - The image is either too big
-            // - The image is so small that at least one dimension is less
-            //   than half the width of the window or
-            // - The user has requsted rescaling
-
-            if (xScaleFactor > 1.0 || yScaleFactor > 1.0 ||
-                xScaleFactor < 0.45 || yScaleFactor < 0.45 || m_scaleImage)
-            {
-
-                newWidth /= newScaleFactor;
-                newHeight /= newScaleFactor;
-
-                newScaleFactor = 1.0 / newScaleFactor;
-
-                m_scaleFactor = newScaleFactor;
-
-                if (imageWidth != newWidth || imageHeight != newHeight)
-                {
-//                    Debug.Write(wxString::Format("Resizing image to %d,%d\n", newWidth, newHeight));
-
-                    if (newWidth > 0 && newHeight > 0)
-                    {
-                        m_displayedImage->Rescale(newWidth, newHeight, wxIMAGE_QUALITY_HIGH);
-                    }
-                }
-            }
-            else
-            {
-                m_scaleFactor = 1.0;
-            }
+            RenderDisplay();
         }
 
         // important to provide explicit color for r,g,b, optional args to Size().
         // If default args are provided wxWidgets performs some expensive histogram
         // operations.
-        wxBitmap DisplayedBitmap(m_displayedImage->Size(wxSize(XWinSize, YWinSize), wxPoint(0, 0), 0, 0, 0));
-        memDC.SelectObject(DisplayedBitmap);
+        if (m_displayedBitmapStale || m_displayedBitmap.GetWidth() != XWinSize ||
+            m_displayedBitmap.GetHeight() != YWinSize)
+        {
+            m_displayedBitmap = wxBitmap(m_displayedImage->Size(wxSize(XWinSize, YWinSize), wxPoint(0, 0), 0, 0, 0));
+            m_displayedBitmapStale = false;
+        }
+        memDC.SelectObject(m_displayedBitmap);
 
-        dc.Blit(0, 0, DisplayedBitmap.GetWidth(), DisplayedBitmap.GetHeight(), &memDC, 0, 0, wxCOPY, false);
+        dc.Blit(0, 0, m_displayedBitmap.GetWidth(), m_displayedBitmap.GetHeight(), &memDC, 0, 0, wxCOPY, false);
 
         int XImgSize = m_displayedImage->GetWidth();
         int YImgSize = m_displayedImage->GetHeight();
@@ -725,6 +702,51 @@ void Guider::UpdateImageDisplay(usImage *pImage)
                                  pImage->Size.x, pImage->Size.y, pImage->MinADU, pImage->MaxADU, pImage->MedianADU,
                                  pImage->FiltMin, pImage->FiltMax, pFrame->Stretch_gamma));
 
+    if (m_pCurrentImage->ImageData)
+    {
+        // the window is repainted when the render thread is done, unless the
+        // frame could not be handed over and was rendered here instead
+        if (RenderDisplay())
+            return;
+    }
+    else
+        m_displayRenderer.Discard();
+
+    Refresh();
+    Update();
+}
+
+// Stretch and scale the current image for display. With the render thread
+// running this only hands the frame over; otherwise it renders right here.
+// Returns true if the frame went to the render thread, which repaints the
+// window when it is done.
+bool Guider::RenderDisplay()
+{
+    DisplayRenderParams params;
+    params.blevel = m_pCurrentImage->FiltMin;
+    params.wlevel = m_pCurrentImage->FiltMax;
+    params.gamma = pFrame->Stretch_gamma;
+    params.winSize = GetSize();
+    params.scaleImage = m_scaleImage;
+
+    m_renderWinSize = params.winSize;
+
+    if (m_displayRenderer.IsRunning() && !m_displayRenderer.Submit(*m_pCurrentImage, params))
+        return true;
+
+    m_scaleFactor = RenderDisplayImage(&m_displayedImage, *m_pCurrentImage, params);
+    m_displayedBitmapStale = true;
+
+    return false;
+}
+
+void Guider::OnDisplayRenderComplete(wxThreadEvent& evt)
+{
+    if (!m_displayRenderer.TakeResult(&m_displayedImage, &m_scaleFactor))
+        return;
+
+    m_displayedBitmapStale = true;
+
     Refresh();
     Update();
 }
@@ -1338,6 +1360,8 @@ void Guider::UpdateGuideState(usImage *pImage, bool bStopping)
         else
             statusMessage = info.status;
 
+        Trace.StarFound(pImage->FrameNum, CurrentPosition(), SNR(), HFD());
+
         // we have a star selected, so re-enable subframes
         if (m_forceFullFrame)
         {
@@ -1642,6 +1666,14 @@ void Guider::UpdateLockPosShiftCameraCoords()
     m_lockPosition.SetShiftRate(rate.X, rate.Y);
 }
 
+void Guider::GetGuideStarPositions(std::vector<PHD_Point> *positions)
+{
+    positions->clear();
+    const PHD_Point& pos = CurrentPosition();
+    if (pos.IsValid())
+        positions->push_back(pos);
+}
+
 wxString Guider::GetSettingsSummary() const
 {
     // return a loggable summary of current global configs managed by MyFrame
@@ -1687,6 +1719,7 @@ void Guider::GuiderConfigDialogPane::LayoutControls(Guider *pGuider, BrainCtrlId
     CondAddCtrl(pSharedSizer, CtrlMap, AD_cbReverseDecOnFlip);
     CondAddCtrl(pSharedSizer, CtrlMap, AD_cbEnableGuiding, wxSizerFlags(0).Border(wxLEFT, 35));
     CondAddCtrl(pSharedSizer, CtrlMap, AD_cbSlewDetection);
+    pSharedSizer->Add(GetSizerCtrl(CtrlMap, AD_szDisplayMaxFps));
     pShared->Add(pSharedSizer, def_flags);
     pShared->Layout();
 
@@ -1712,6 +1745,14 @@ ConfigDialogCtrlSet(pParent, pAdvancedDialog, CtrlMap)
     m_pScaleImage = new wxCheckBox(GetParentWindow(AD_cbScaleImages), wxID_ANY, _("Always scale images"));
     AddCtrl(CtrlMap, AD_cbScaleImages, m_pScaleImage, _("Always scale images to fill window"));
 
+    int width = StringWidth(_T("000"));
+    wxWindow *parent = GetParentWindow(AD_szDisplayMaxFps);
+    m_pDisplayMaxFps = pFrame->MakeSpinCtrl(parent, wxID_ANY, _T(" "), wxDefaultPosition,
+        wxSize(width, -1), wxSP_ARROW_KEYS, 0, 60, 0, _T("DisplayMaxFps"));
+    AddLabeledCtrl(CtrlMap, AD_szDisplayMaxFps, _("Max display rate (fps)"), m_pDisplayMaxFps,
+        _("Maximum number of frames per second shown in the guider window, 0 for no limit. Guiding still uses every frame; "
+          "lowering this reduces CPU load with short exposures or large sensors."));
+
     m_pEnableFastRecenter = new wxCheckBox(GetParentWindow(AD_cbFastRecenter), wxID_ANY, _("Fast recenter after calibration or dither"));
     AddCtrl(CtrlMap, AD_cbFastRecenter, m_pEnableFastRecenter, _("Speed up calibration and dithering by using larger guide pulses to return the star to the center position. Un-check to use the old, slower method of recentering after calibration or dither."));
 }
@@ -1720,12 +1761,14 @@ void GuiderConfigDialogCtrlSet::LoadValues()
 {
     m_pEnableFastRecenter->SetValue(m_pGuider->IsFastRecenterEnabled());
     m_pScaleImage->SetValue(m_pGuider->GetScaleImage());
+    m_pDisplayMaxFps->SetValue(m_pGuider->GetDisplayMaxFps());
 }
 
 void GuiderConfigDialogCtrlSet::UnloadValues()
 {
     m_pGuider->EnableFastRecenter(m_pEnableFastRecenter->GetValue());
     m_pGuider->SetScaleImage(m_pScaleImage->GetValue());
+    m_pGuider->SetDisplayMaxFps(m_pDisplayMaxFps->GetValue());
 }
 
 EXPOSED_STATE Guider::GetExposedState()
@@ -1806,6 +1849,18 @@ void Guider::SetAutoSelDownsample(unsigned int val)
     m_autoSelDownsample = val;
 }
 
+AutoFindParams Guider::GetAutoFindParams() const
+{
+    AutoFindParams params;
+    params.downsample = GetAutoSelDownsample();
+    params.pixelScale = pFrame->GetCameraPixelScale();
+    params.minHFD = GetMinStarHFD();
+    params.minSNR = getMinStarSNR();
+    params.saturationByADU = pCamera && pCamera->IsSaturationByADU();
+    params.saturationADU = pCamera ? pCamera->GetSaturationADU() : 0;
+    return params;
+}
+
 void Guider::SetBookmarksShown(bool show)
 {
     bool prev = m_showBookmarks;
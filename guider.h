@@ -120,6 +120,7 @@ class GuiderConfigDialogCtrlSet : public ConfigDialogCtrlSet
     Guider *m_pGuider;
     wxCheckBox *m_pEnableFastRecenter;
     wxCheckBox *m_pScaleImage;
+    wxSpinCtrl *m_pDisplayMaxFps;
 
 public:
     GuiderConfigDialogCtrlSet(wxWindow *pParent, Guider *pGuider, AdvancedDialog* pAdvancedDialog, BrainCtrlIdMap& CtrlMap);
@@ -138,6 +139,11 @@ struct GuiderOffset
 class Guider : public wxWindow
 {
     wxImage *m_displayedImage;
+    wxBitmap m_displayedBitmap;         // m_displayedImage sized to the window, ready to blit
+    bool m_displayedBitmapStale;
+    DisplayRenderer m_displayRenderer;
+    wxSize m_renderWinSize;             // window size the displayed image was rendered for
+    int m_displayMaxFps;
     OVERLAY_MODE m_overlayMode;
     OverlaySlitCoords m_overlaySlitCoords;
     const DefectMap *m_defectMapPreview;
@@ -204,6 +210,8 @@ protected:
     bool PaintHelper(wxAutoBufferedPaintDCBase& dc, wxMemoryDC& memDC);
     void SetState(GUIDER_STATE newState);
     void UpdateCurrentDistance(double distance, double distanceRA);
+    bool RenderDisplay();
+    void OnDisplayRenderComplete(wxThreadEvent& evt);
 
     void ToggleBookmark(const wxRealPoint& pt);
 
@@ -250,6 +258,8 @@ public:
 
     bool SetScaleImage(bool newScaleValue);
     bool GetScaleImage() const;
+    void SetDisplayMaxFps(int fps);
+    int GetDisplayMaxFps() const;
 
     int GetSearchRegion() const;
     double CurrentError(bool raOnly);
@@ -271,6 +281,7 @@ public:
     double getMinStarSNR() const;
     void SetAutoSelDownsample(unsigned int val);
     unsigned int GetAutoSelDownsample() const;
+    AutoFindParams GetAutoFindParams() const;
 
     // virtual functions -- these CAN be overridden by a subclass, which should
     // consider whether they need to call the base class functions as part of
@@ -293,6 +304,9 @@ public:
 
     virtual bool IsLocked() = 0;
     virtual bool AutoSelect(const wxRect& roi = wxRect()) = 0;
+    virtual bool StartAutoSelect(const wxRect& roi = wxRect()) = 0;
+    virtual bool CompleteAutoSelect() = 0;
+    virtual void CancelAutoSelect() = 0;
 
     virtual const PHD_Point& CurrentPosition() = 0;
     virtual wxRect GetBoundingBox() = 0;
@@ -305,6 +319,7 @@ public:
     virtual bool GetMultiStarMode() { return false; }
     virtual void SetMultiStarMode(bool On) {};
     virtual wxString GetStarCount() { return wxEmptyString; }
+    virtual void GetGuideStarPositions(std::vector<PHD_Point> *positions);
 
     usImage *CurrentImage() const;
     wxImage *DisplayedImage() const;
@@ -340,6 +355,11 @@ inline bool Guider::GetScaleImage() const
     return m_scaleImage;
 }
 
+inline int Guider::GetDisplayMaxFps() const
+{
+    return m_displayMaxFps;
+}
+
 inline const ShiftPoint& Guider::LockPosition() const
 {
     return m_lockPosition;
@@ -200,6 +200,34 @@ enum {
     MAX_LIST_SIZE = 12
 };
 
+// Runs GuideStar::AutoFind on a private copy of the current frame so that the
+// GUI thread, and with it the event server and the capture loop, keeps running
+// during the search. Completion is signalled with AUTOFIND_COMPLETE_EVENT; the
+// guider then picks up the result in CompleteAutoSelect.
+class AutoFindThread : public wxThread
+{
+public:
+    usImage image;
+    AutoFindParams params;
+    wxRect roi;
+    int edgeAllowance;
+    int searchRegion;
+    GuideStar star;
+    std::vector<GuideStar> stars;
+    bool found;
+    unsigned int selectionGen;  // guider's selection generation when the search started
+
+    AutoFindThread() : wxThread(wxTHREAD_JOINABLE), edgeAllowance(0), searchRegion(0), found(false), selectionGen(0) { }
+
+protected:
+    ExitCode Entry() override
+    {
+        found = star.AutoFind(image, params, edgeAllowance, searchRegion, roi, stars, MAX_LIST_SIZE);
+        wxQueueEvent(pFrame, new wxThreadEvent(wxEVT_THREAD, AUTOFIND_COMPLETE_EVENT));
+        return nullptr;
+    }
+};
+
 BEGIN_EVENT_TABLE(GuiderMultiStar, Guider)
     EVT_PAINT(GuiderMultiStar::OnPaint)
     EVT_LEFT_DOWN(GuiderMultiStar::OnLClick)
@@ -213,7 +241,9 @@ GuiderMultiStar::GuiderMultiStar(wxWindow *parent)
       m_lockPositionMoved(false),
       m_maxStars(DEFAULT_MAX_STAR_COUNT),
       m_stabilitySigmaX(DEFAULT_STABILITY_SIGMAX),
-      m_lastStarsUsed(0)
+      m_lastStarsUsed(0),
+      m_autoFindThread(nullptr),
+      m_selectionGen(0)
 {
     SetState(STATE_UNINITIALIZED);
     m_primaryDistStats = new DescriptiveStats();
@@ -221,6 +251,7 @@ GuiderMultiStar::GuiderMultiStar(wxWindow *parent)
 
 GuiderMultiStar::~GuiderMultiStar()
 {
+    CancelAutoSelect();
     delete m_massChecker;
     delete m_primaryDistStats;
 }
@@ -388,6 +419,8 @@ bool GuiderMultiStar::SetCurrentPosition(const usImage *pImage, const PHD_Point&
 
         Debug.Write(wxString::Format("SetCurrentPosition(%.2f,%.2f)\n", x, y ));
 
+        ++m_selectionGen;
+
         if ((x <= 0) || (x >= pImage->Size.x))
         {
             throw ERROR_INFO("invalid x value");
@@ -449,6 +482,64 @@ static wxString StarStatus(const Star& star)
     return status;
 }
 
+int GuiderMultiStar::AutoSelectEdgeAllowance() const
+{
+    // If mount is not calibrated, we need to chose a star a bit farther
+    // from the egde to allow for the motion of the star during
+    // calibration
+    //
+    int edgeAllowance = 0;
+    if (pMount && pMount->IsConnected() && !pMount->IsCalibrated())
+        edgeAllowance = wxMax(edgeAllowance, pMount->CalibrationTotDistance());
+    if (pSecondaryMount && pSecondaryMount->IsConnected() && !pSecondaryMount->IsCalibrated())
+        edgeAllowance = wxMax(edgeAllowance, pSecondaryMount->CalibrationTotDistance());
+    return edgeAllowance;
+}
+
+// Lock on to the star chosen by AutoFind; throws on failure
+void GuiderMultiStar::SelectAutoFoundStar(const usImage *image, const GuideStar& newStar)
+{
+    ++m_selectionGen;
+    m_massChecker->Reset();
+
+    if (!m_primaryStar.Find(image, m_searchRegion, newStar.X, newStar.Y, Star::FIND_CENTROID, GetMinStarHFD(),
+                     pCamera->GetSaturationADU()))
+    {
+        throw ERROR_INFO("Unable to find");
+    }
+
+    // DEBUG OUTPUT
+    wxString buff = wxString::Format("MultiStar: List (%d): ", m_guideStars.size());
+    for (auto pGS = m_guideStars.begin(); pGS != m_guideStars.end(); ++pGS)
+    {
+        buff += wxString::Format("{%0.2f, %0.2f}(%0.1f), ", pGS->X, pGS->Y, pGS->SNR);
+    }
+    Debug.Write(buff + "\n");
+
+    m_primaryDistStats->ClearAll();
+
+    if (SetLockPosition(m_primaryStar))
+    {
+        throw ERROR_INFO("Unable to set Lock Position");
+    }
+
+    if (GetState() == STATE_SELECTING)
+    {
+        // immediately advance the state machine now, rather than waiting for
+        // the next exposure to complete. Socket server clients are going to
+        // try to start guiding after selecting the star, but guiding will fail
+        // to start if state is still STATE_SELECTING
+        Debug.Write(wxString::Format("AutoSelect: state = %d, call UpdateGuideState\n", GetState()));
+        UpdateGuideState(NULL, false);
+    }
+
+    UpdateImageDisplay();
+
+    pFrame->StatusMsg(wxString::Format(_("Auto-selected star at (%.1f, %.1f)"), m_primaryStar.X, m_primaryStar.Y));
+    pFrame->UpdateStatusBarStarInfo(m_primaryStar.SNR, m_primaryStar.GetError() == Star::STAR_SATURATED);
+    pFrame->pProfile->UpdateData(image, m_primaryStar.X, m_primaryStar.Y);
+}
+
 bool GuiderMultiStar::AutoSelect(const wxRect& roi)
 {
     Debug.Write("GuiderMultiStar::AutoSelect enter\n");
@@ -464,60 +555,132 @@ bool GuiderMultiStar::AutoSelect(const wxRect& roi)
             throw ERROR_INFO("No Current Image");
         }
 
-        // If mount is not calibrated, we need to chose a star a bit farther
-        // from the egde to allow for the motion of the star during
-        // calibration
-        //
-        int edgeAllowance = 0;
-        if (pMount && pMount->IsConnected() && !pMount->IsCalibrated())
-            edgeAllowance = wxMax(edgeAllowance, pMount->CalibrationTotDistance());
-        if (pSecondaryMount && pSecondaryMount->IsConnected() && !pSecondaryMount->IsCalibrated())
-            edgeAllowance = wxMax(edgeAllowance, pSecondaryMount->CalibrationTotDistance());
+        int edgeAllowance = AutoSelectEdgeAllowance();
+
+        wxBusyCursor busy;
 
         GuideStar newStar;
-        if (!newStar.AutoFind(*image, edgeAllowance, m_searchRegion, roi, m_guideStars, MAX_LIST_SIZE))
+        if (!newStar.AutoFind(*image, GetAutoFindParams(), edgeAllowance, m_searchRegion, roi, m_guideStars, MAX_LIST_SIZE))
         {
             throw ERROR_INFO("Unable to AutoFind");
         }
 
-        m_massChecker->Reset();
+        SelectAutoFoundStar(image, newStar);
+    }
+    catch (const wxString& Msg)
+    {
+        POSSIBLY_UNUSED(Msg);
+        error = true;
+    }
 
-        if (!m_primaryStar.Find(image, m_searchRegion, newStar.X, newStar.Y, Star::FIND_CENTROID, GetMinStarHFD(),
-                         pCamera->GetSaturationADU()))
-        {
-            throw ERROR_INFO("Unable to find");
-        }
+    if (image && image->ImageData)
+    {
+        if (error)
+            Debug.Write("GuiderMultiStar::AutoSelect failed.\n");
+
+        ImageLogger::LogAutoSelectImage(image, !error);
+    }
+
+    return error;
+}
+
+// Start an auto-select on a background thread. Returns true if the search
+// could not be started; otherwise MyFrame receives AUTOFIND_COMPLETE_EVENT when
+// the search is done and calls CompleteAutoSelect. A request made while a
+// search is already running shares the result of that search. The result is
+// dropped if the star is selected or deselected in the meantime.
+bool GuiderMultiStar::StartAutoSelect(const wxRect& roi)
+{
+    Debug.Write("GuiderMultiStar::StartAutoSelect enter\n");
+
+    if (m_autoFindThread)
+    {
+        Debug.Write("StartAutoSelect: search already in progress\n");
+        return false;
+    }
 
-        // DEBUG OUTPUT
-        wxString buff = wxString::Format("MultiStar: List (%d): ", m_guideStars.size());
-        for (auto pGS = m_guideStars.begin(); pGS != m_guideStars.end(); ++pGS)
+    usImage *image = CurrentImage();
+
+    if (!image || !image->ImageData)
+    {
+        Debug.Write("StartAutoSelect: no current image\n");
+        return true;
+    }
+
+    AutoFindThread *thread = new AutoFindThread();
+
+    if (thread->image.CopyFrom(*image))
+    {
+        Debug.Write("StartAutoSelect: could not copy image\n");
+        delete thread;
+        return true;
+    }
+    thread->image.Subframe = image->Subframe;
+    thread->image.MinADU = image->MinADU;
+    thread->image.MaxADU = image->MaxADU;
+    thread->image.MedianADU = image->MedianADU;
+    thread->image.FiltMin = image->FiltMin;
+    thread->image.FiltMax = image->FiltMax;
+    thread->image.ImgStartTime = image->ImgStartTime;
+    thread->image.ImgExpDur = image->ImgExpDur;
+    thread->image.ImgStackCnt = image->ImgStackCnt;
+    thread->image.BitsPerPixel = image->BitsPerPixel;
+    thread->image.Pedestal = image->Pedestal;
+    thread->image.FrameNum = image->FrameNum;
+
+    thread->params = GetAutoFindParams();
+    thread->roi = roi;
+    thread->edgeAllowance = AutoSelectEdgeAllowance();
+    thread->searchRegion = m_searchRegion;
+    thread->selectionGen = m_selectionGen;
+
+    if (thread->Run() != wxTHREAD_NO_ERROR)
+    {
+        Debug.Write("StartAutoSelect: could not start thread\n");
+        delete thread;
+        return true;
+    }
+
+    m_autoFindThread = thread;
+
+    return false;
+}
+
+bool GuiderMultiStar::CompleteAutoSelect()
+{
+    if (!m_autoFindThread)
+        return true;
+
+    AutoFindThread *thread = m_autoFindThread;
+    m_autoFindThread = nullptr;
+
+    thread->Wait();
+
+    Debug.Write("GuiderMultiStar::CompleteAutoSelect enter\n");
+
+    bool error = false;
+
+    try
+    {
+        if (IsCalibratingOrGuiding())
         {
-            buff += wxString::Format("{%0.2f, %0.2f}(%0.1f), ", pGS->X, pGS->Y, pGS->SNR);
+            throw ERROR_INFO("calibrating or guiding started during auto-select");
         }
-        Debug.Write(buff + "\n");
-
-        m_primaryDistStats->ClearAll();
 
-        if (SetLockPosition(m_primaryStar))
+        // a star selected or cleared since the search started takes precedence
+        if (thread->selectionGen != m_selectionGen)
         {
-            throw ERROR_INFO("Unable to set Lock Position");
+            throw ERROR_INFO("star selection changed during auto-select");
         }
 
-        if (GetState() == STATE_SELECTING)
+        if (!thread->found)
         {
-            // immediately advance the state machine now, rather than waiting for
-            // the next exposure to complete. Socket server clients are going to
-            // try to start guiding after selecting the star, but guiding will fail
-            // to start if state is still STATE_SELECTING
-            Debug.Write(wxString::Format("AutoSelect: state = %d, call UpdateGuideState\n", GetState()));
-            UpdateGuideState(NULL, false);
+            throw ERROR_INFO("Unable to AutoFind");
         }
 
-        UpdateImageDisplay();
+        m_guideStars.swap(thread->stars);
 
-        pFrame->StatusMsg(wxString::Format(_("Auto-selected star at (%.1f, %.1f)"), m_primaryStar.X, m_primaryStar.Y));
-        pFrame->UpdateStatusBarStarInfo(m_primaryStar.SNR, m_primaryStar.GetError() == Star::STAR_SATURATED);
-        pFrame->pProfile->UpdateData(image, m_primaryStar.X, m_primaryStar.Y);
+        SelectAutoFoundStar(&thread->image, thread->star);
     }
     catch (const wxString& Msg)
     {
@@ -525,17 +688,31 @@ bool GuiderMultiStar::AutoSelect(const wxRect& roi)
         error = true;
     }
 
-    if (image && image->ImageData)
-    {
-        if (error)
-            Debug.Write("GuiderMultiStar::AutoSelect failed.\n");
+    if (error)
+        Debug.Write("GuiderMultiStar::CompleteAutoSelect failed.\n");
 
-        ImageLogger::LogAutoSelectImage(image, !error);
-    }
+    ImageLogger::LogAutoSelectImage(&thread->image, !error);
+
+    delete thread;
 
     return error;
 }
 
+// Wait for a background auto-select to finish and drop its result. The
+// AUTOFIND_COMPLETE_EVENT it has already queued then finds no search in
+// progress, so CompleteAutoSelect reports the selection as failed.
+void GuiderMultiStar::CancelAutoSelect()
+{
+    if (!m_autoFindThread)
+        return;
+
+    Debug.Write("GuiderMultiStar::CancelAutoSelect\n");
+
+    m_autoFindThread->Wait();
+    delete m_autoFindThread;
+    m_autoFindThread = nullptr;
+}
+
 bool GuiderMultiStar::IsLocked()
 {
     return m_primaryStar.WasFound();
@@ -634,6 +811,7 @@ int GuiderMultiStar::StarError()
 
 void GuiderMultiStar::InvalidateCurrentPosition(bool fullReset)
 {
+    ++m_selectionGen;
     m_primaryStar.Invalidate();
 
     if (fullReset)
@@ -746,6 +924,26 @@ wxString GuiderMultiStar::GetStarCount()
     return wxString::Format("%d/%d", wxMin(m_starsUsed, (int)m_guideStars.size()), (int)m_guideStars.size());  // no weird displays if stars are being removed from list
 }
 
+// Primary star first, then the secondary stars found in the current frame
+void GuiderMultiStar::GetGuideStarPositions(std::vector<PHD_Point> *positions)
+{
+    positions->clear();
+
+    if (!m_primaryStar.IsValid())
+        return;
+
+    positions->push_back(m_primaryStar);
+
+    if (!m_multiStarMode || m_guideStars.size() < 2)
+        return;
+
+    for (auto pGS = m_guideStars.begin() + 1; pGS != m_guideStars.end(); ++pGS)
+    {
+        if (pGS->WasFound() && pGS->IsValid())
+            positions->push_back(*pGS);
+    }
+}
+
 // Private method to build compact logging string for how secondary stars were used
 static void AppendStarUse(wxString& secondaryInfo, int starNum, double dX, double dY, double weight, const wxString& flag)
 {
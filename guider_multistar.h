@@ -45,6 +45,7 @@
 #define GUIDER_MULTISTAR_H_INCLUDED
 
 class MassChecker;
+class AutoFindThread;
 class GuiderMultiStar;
 class GuiderConfigDialogCtrlSet;
 
@@ -83,6 +84,8 @@ private:
     bool m_lockPositionMoved;
     int m_starsUsed;
     int m_lastStarsUsed;
+    AutoFindThread *m_autoFindThread;
+    unsigned int m_selectionGen;    // bumped whenever the star is selected or deselected
 
     // parameters
     bool m_massChangeThresholdEnabled;
@@ -126,6 +129,9 @@ public:
     virtual bool SetLockPosition(const PHD_Point& position) override;
     bool IsLocked() override;
     bool AutoSelect(const wxRect& roi) override;
+    bool StartAutoSelect(const wxRect& roi) override;
+    bool CompleteAutoSelect() override;
+    void CancelAutoSelect() override;
     const PHD_Point& CurrentPosition() override;
     wxRect GetBoundingBox() override;
     int GetMaxMovePixels() override;
@@ -136,6 +142,7 @@ public:
     int StarError() override;
     bool GetMultiStarMode() override;
     wxString GetStarCount() override;
+    void GetGuideStarPositions(std::vector<PHD_Point> *positions) override;
     void SetMultiStarMode(bool val) override;
     void ClearSecondaryStars();
     wxString GetSettingsSummary() const override;
@@ -153,6 +160,9 @@ private:
 
     void OnLClick(wxMouseEvent& evt);
 
+    int AutoSelectEdgeAllowance() const;
+    void SelectAutoFoundStar(const usImage *image, const GuideStar& newStar);
+
     void SaveStarFITS();
 
     DECLARE_EVENT_TABLE()
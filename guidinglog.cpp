@@ -42,16 +42,51 @@
 
 const int RetentionPeriod = 60;
 
+// High-rate rows (guide steps, dropped frames, calibration steps) are flushed
+// this often, in milliseconds, whether or not more rows arrive. Overridden by
+// the global setting /GuideLog/FlushInterval; 0 flushes after every row.
+static const int DefaultFlushInterval = 1000;
+
 GuidingLog::GuidingLog()
     :
     m_enabled(false),
     m_keepFile(false),
-    m_isGuiding(false)
+    m_isGuiding(false),
+    m_flushInterval(DefaultFlushInterval),
+    m_rowsPending(false),
+    m_flushTimer(nullptr)
 {
 }
 
 GuidingLog::~GuidingLog()
 {
+    // normally CloseGuideLog has been called by now
+    if (m_file.IsOpened())
+        m_file.Flush();
+}
+
+// append to a fixed-size row buffer, truncating rather than overflowing. A
+// truncated row still ends with a newline so it does not run into the next one;
+// once a row has been truncated further appends are ignored.
+static int AppendRow(char *buf, int size, int pos, const char *fmt, ...)
+{
+    if (pos >= size - 1)
+        return pos;
+
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf + pos, size - pos, fmt, ap);
+    va_end(ap);
+
+    if (n < 0)
+        return pos;
+
+    if (pos + n < size)
+        return pos + n;
+
+    buf[size - 2] = '\n';
+    buf[size - 1] = 0;
+    return size - 1;
 }
 
 static wxString PierSideStr(PierSide p)
@@ -255,6 +290,8 @@ void GuidingLog::EnableLogging()
 
     try
     {
+        m_flushInterval = wxMax(0, pConfig->Global.GetInt("/GuideLog/FlushInterval", DefaultFlushInterval));
+
         const wxDateTime& logFileTime = wxGetApp().GetLogFileTime();
         if (!m_file.IsOpened())
         {
@@ -292,6 +329,12 @@ void GuidingLog::EnableLogging()
             GuidingHeader(m_file);
 
         Flush();
+
+        if (m_flushInterval > 0)
+        {
+            m_flushTimer = new LogFlushTimer([this]() { if (m_rowsPending) Flush(); });
+            m_flushTimer->Start(m_flushInterval);
+        }
     }
     catch (const wxString& Msg)
     {
@@ -321,6 +364,7 @@ void GuidingLog::DisableLogging()
         Flush();
     }
 
+    StopFlushTimer();
     m_enabled = false;
 
     // persist state
@@ -368,6 +412,9 @@ bool GuidingLog::Flush()
         {
             throw ERROR_INFO("unable to flush file");
         }
+
+        m_sinceFlush.Start();
+        m_rowsPending = false;
     }
     catch (const wxString& Msg)
     {
@@ -378,6 +425,24 @@ bool GuidingLog::Flush()
     return error;
 }
 
+// Rows written at the guiding rate only flush when the flush interval has
+// elapsed. Every other entry (guiding stopped, dither, settling, ...) flushes
+// right away, which also writes out any rows held back here. If the rows stop
+// coming, the flush timer writes out the ones held back.
+void GuidingLog::RowWritten()
+{
+    if (m_flushInterval == 0 || m_sinceFlush.Time() >= m_flushInterval)
+        Flush();
+    else
+        m_rowsPending = true;
+}
+
+void GuidingLog::StopFlushTimer()
+{
+    delete m_flushTimer;
+    m_flushTimer = nullptr;
+}
+
 void GuidingLog::CloseGuideLog()
 {
     if (m_file.IsOpened())
@@ -395,6 +460,7 @@ void GuidingLog::CloseGuideLog()
         m_file.Close();
     }
 
+    StopFlushTimer();
     m_enabled = false;
 
     if (!m_keepFile)            // Delete the file if nothing useful was logged
@@ -478,7 +544,7 @@ void GuidingLog::CalibrationStep(const CalibrationStepInfo& info)
         info.pos.X, info.pos.Y,
         info.dist));
 
-    Flush();
+    RowWritten();
 }
 
 void GuidingLog::CalibrationDirectComplete(const Mount *pCalibrationMount, const wxString& direction, double angle, double rate, int parity)
@@ -508,6 +574,8 @@ void GuidingLog::CalibrationComplete(const Mount *pCalibrationMount)
     m_file.Write(wxString::Format("Calibration complete, mount = %s.\n", pCalibrationMount->Name()));
 
     Flush();
+
+    Trace.CalibrationComplete();
 }
 
 void GuidingLog::GuidingStarted()
@@ -528,6 +596,8 @@ void GuidingLog::GuidingStarted()
     Flush();
 
     m_keepFile = true;
+
+    Trace.GuidingStarted();
 }
 
 void GuidingLog::GuidingStopped()
@@ -539,11 +609,15 @@ void GuidingLog::GuidingStopped()
 
     assert(m_file.IsOpened());
 
+    double guideDur = pFrame->TimeSinceGuidingStarted();
+
     ++m_summary.guide_cnt;
-    m_summary.guide_dur += pFrame->TimeSinceGuidingStarted();
+    m_summary.guide_dur += guideDur;
 
     m_file.Write("Guiding Ends at " + wxDateTime::Now().Format(_T("%Y-%m-%d %H:%M:%S")) + "\n");
     Flush();
+
+    Trace.GuidingStopped(guideDur);
 }
 
 void GuidingLog::GuideStep(const GuideStepInfo& step)
@@ -553,30 +627,33 @@ void GuidingLog::GuideStep(const GuideStepInfo& step)
 
     assert(m_file.IsOpened());
 
-    m_file.Write(wxString::Format("%d,%.3f,\"%s\",%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,",
+    const int size = sizeof(m_row);
+    int n = AppendRow(m_row, size, 0, "%d,%.3f,\"%s\",%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,",
         step.frameNumber, step.time,
         step.mount->IsStepGuider() ? "AO" : "Mount",
         step.cameraOffset.X, step.cameraOffset.Y,
         step.mountOffset.X, step.mountOffset.Y,
-        step.guideDistanceRA, step.guideDistanceDec));
+        step.guideDistanceRA, step.guideDistanceDec);
 
     if (step.mount->IsStepGuider())
     {
         int xSteps = step.directionRA == LEFT ? -step.durationRA : step.durationRA;
         int ySteps = step.directionDec == DOWN ? -step.durationDec : step.durationDec;
-        m_file.Write(wxString::Format(",,,,%d,%d,", xSteps, ySteps));
+        n = AppendRow(m_row, size, n, ",,,,%d,%d,", xSteps, ySteps);
     }
     else
     {
-        m_file.Write(wxString::Format("%d,%s,%d,%s,,,",
+        n = AppendRow(m_row, size, n, "%d,%s,%d,%s,,,",
             step.durationRA, step.durationRA > 0 ? step.mount->DirectionChar((GUIDE_DIRECTION)step.directionRA) : "",
-            step.durationDec, step.durationDec > 0 ? step.mount->DirectionChar((GUIDE_DIRECTION)step.directionDec): ""));
+            step.durationDec, step.durationDec > 0 ? step.mount->DirectionChar((GUIDE_DIRECTION)step.directionDec): "");
     }
 
-    m_file.Write(wxString::Format("%.f,%.2f,%d\n",
-            step.starMass, step.starSNR, step.starError));
+    n = AppendRow(m_row, size, n, "%.f,%.2f,%d\n",
+            step.starMass, step.starSNR, step.starError);
 
-    Flush();
+    m_file.Write(m_row, n);
+
+    RowWritten();
 }
 
 void GuidingLog::FrameDropped(const FrameDroppedInfo& info)
@@ -586,10 +663,13 @@ void GuidingLog::FrameDropped(const FrameDroppedInfo& info)
 
     assert(m_file.IsOpened());
 
-    m_file.Write(wxString::Format("%d,%.3f,\"DROP\",,,,,,,,,,,,,%.f,%.2f,%d,\"%s\"\n",
-        info.frameNumber, info.time, info.starMass, info.starSNR, info.starError, info.status));
+    int n = AppendRow(m_row, sizeof(m_row), 0, "%d,%.3f,\"DROP\",,,,,,,,,,,,,%.f,%.2f,%d,\"%s\"\n",
+        info.frameNumber, info.time, info.starMass, info.starSNR, info.starError,
+        (const char *) info.status.utf8_str());
 
-    Flush();
+    m_file.Write(m_row, n);
+
+    RowWritten();
 }
 
 
@@ -603,7 +683,7 @@ void GuidingLog::CalibrationFrameDropped(const FrameDroppedInfo& info)
     m_file.Write(wxString::Format("INFO: STAR LOST during calibration, Mass= %.f, SNR= %.2f, Error= %d, Status=%s\n",
         info.starMass, info.starSNR, info.starError, info.status));
 
-    Flush();
+    RowWritten();
 }
 
 void GuidingLog::NotifyGuidingDithered(Guider *guider, double dx, double dy)
@@ -641,6 +721,10 @@ void GuidingLog::NotifyGAResult(const wxString& msg)
     // Client needs to handle end-of-line formatting
     m_file.Write(wxString::Format("INFO: GA Result - %s", msg));
     Flush();
+
+    // the log uploader counts these as guiding assistant runs
+    if (msg.StartsWith("Dec Drift Rate="))
+        Trace.GAResult();
 }
 
 void GuidingLog::NotifySetLockPosition(Guider *guider)
@@ -125,9 +125,16 @@ class GuidingLog : public Logger
     bool m_keepFile;
     bool m_isGuiding;
     GuideLogSummaryInfo m_summary;
+    int m_flushInterval;            // milliseconds, 0 = flush every row
+    wxStopWatch m_sinceFlush;
+    bool m_rowsPending;             // rows written since the last flush
+    LogFlushTimer *m_flushTimer;    // flushes held rows when no more rows arrive
+    char m_row[1024];               // reusable buffer for formatting guide step rows
 
     void EnableLogging();
     void DisableLogging();
+    void RowWritten();
+    void StopFlushTimer();
 
 public:
     GuidingLog();
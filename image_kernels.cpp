@@ -0,0 +1,371 @@
+/*
+ *  image_kernels.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "image_kernels.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+# define KERNELS_X86
+# include <emmintrin.h>
+# include <immintrin.h>
+# if defined(_MSC_VER)
+#  include <intrin.h>
+# endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+# define KERNELS_NEON
+# include <arm_neon.h>
+#endif
+
+// The SSE2 kernels are always available on x86-64; 32-bit x86 builds check at runtime
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define KERNELS_SSE2_BASELINE
+#endif
+
+#if defined(KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+# define TARGET_AVX2 __attribute__((target("avx2")))
+# define TARGET_SSE2 __attribute__((target("sse2")))
+#else
+# define TARGET_AVX2
+# define TARGET_SSE2
+#endif
+
+// Median of 9 values with a 19 comparator exchange network (Paeth / Devillard),
+// leaving the median in p[4]. Only min and max operations are needed, so the same
+// network is expanded for the scalar code and for each vector instruction set. A
+// macro is used rather than a template so that each expansion is compiled inside
+// a function carrying the matching target attribute.
+#define SORT2(T, MIN, MAX, a, b) do { T const t_ = MIN(a, b); b = MAX(a, b); a = t_; } while (false)
+
+#define MEDIAN9(T, MIN, MAX, p) do { \
+    SORT2(T, MIN, MAX, p[1], p[2]); SORT2(T, MIN, MAX, p[4], p[5]); SORT2(T, MIN, MAX, p[7], p[8]); \
+    SORT2(T, MIN, MAX, p[0], p[1]); SORT2(T, MIN, MAX, p[3], p[4]); SORT2(T, MIN, MAX, p[6], p[7]); \
+    SORT2(T, MIN, MAX, p[1], p[2]); SORT2(T, MIN, MAX, p[4], p[5]); SORT2(T, MIN, MAX, p[7], p[8]); \
+    SORT2(T, MIN, MAX, p[0], p[3]); SORT2(T, MIN, MAX, p[5], p[8]); SORT2(T, MIN, MAX, p[4], p[7]); \
+    SORT2(T, MIN, MAX, p[3], p[6]); SORT2(T, MIN, MAX, p[1], p[4]); SORT2(T, MIN, MAX, p[2], p[5]); \
+    SORT2(T, MIN, MAX, p[4], p[7]); SORT2(T, MIN, MAX, p[4], p[2]); SORT2(T, MIN, MAX, p[6], p[4]); \
+    SORT2(T, MIN, MAX, p[4], p[2]); \
+} while (false)
+
+#define LOAD9(LOAD, p, i) \
+    p[0] = LOAD(r0 + (i)); p[1] = LOAD(r0 + (i) + 1); p[2] = LOAD(r0 + (i) + 2); \
+    p[3] = LOAD(r1 + (i)); p[4] = LOAD(r1 + (i) + 1); p[5] = LOAD(r1 + (i) + 2); \
+    p[6] = LOAD(r2 + (i)); p[7] = LOAD(r2 + (i) + 1); p[8] = LOAD(r2 + (i) + 2)
+
+// floor((a + b + c + d) / 4) without overflowing 16 bits: the quotients and the
+// remainders of the four values divided by 4 are summed separately
+#define MEAN4(ADD, SHR2, LOW2, a, b, c, d) \
+    ADD(ADD(ADD(SHR2(a), SHR2(b)), ADD(SHR2(c), SHR2(d))), \
+        SHR2(ADD(ADD(LOW2(a), LOW2(b)), ADD(LOW2(c), LOW2(d)))))
+
+inline static unsigned short umin(unsigned short a, unsigned short b) { return a < b ? a : b; }
+inline static unsigned short umax(unsigned short a, unsigned short b) { return a < b ? b : a; }
+inline static unsigned short uadd(unsigned short a, unsigned short b) { return (unsigned short)(a + b); }
+inline static unsigned short ushr2(unsigned short a) { return (unsigned short)(a >> 2); }
+inline static unsigned short ulow2(unsigned short a) { return (unsigned short)(a & 3); }
+#define ULOAD(q) (*(q))
+
+// scalar code, used as the reference and for the tail of each row
+inline static void Median9Tail(unsigned short *dst, const unsigned short *r0, const unsigned short *r1,
+                               const unsigned short *r2, int n, int i)
+{
+    for (; i < n; i++)
+    {
+        unsigned short p[9];
+        LOAD9(ULOAD, p, i);
+        MEDIAN9(unsigned short, umin, umax, p);
+        dst[i] = p[4];
+    }
+}
+
+inline static void Mean2x2Tail(unsigned short *dst, const unsigned short *r0, const unsigned short *r1, int n, int i)
+{
+    for (; i < n; i++)
+        dst[i] = MEAN4(uadd, ushr2, ulow2, r0[i], r0[i + 1], r1[i], r1[i + 1]);
+}
+
+inline static void GrayToRgbTail(unsigned char *dst, const unsigned char *src, int n, int i)
+{
+    for (; i < n; i++)
+    {
+        unsigned char const g = src[i];
+        dst[3 * i] = g;
+        dst[3 * i + 1] = g;
+        dst[3 * i + 2] = g;
+    }
+}
+
+static void Median9RowScalar(unsigned short *dst, const unsigned short *r0, const unsigned short *r1,
+                             const unsigned short *r2, int n)
+{
+    Median9Tail(dst, r0, r1, r2, n, 0);
+}
+
+static void Mean2x2RowScalar(unsigned short *dst, const unsigned short *r0, const unsigned short *r1, int n)
+{
+    Mean2x2Tail(dst, r0, r1, n, 0);
+}
+
+static void GrayToRgbRowScalar(unsigned char *dst, const unsigned char *src, int n)
+{
+    GrayToRgbTail(dst, src, n, 0);
+}
+
+#if defined(KERNELS_X86)
+
+// SSE2 has no unsigned 16-bit min/max, so the median works on values with the sign
+// bit flipped, which maps unsigned order onto signed order
+#define SSE2_LOADX(q) _mm_xor_si128(_mm_loadu_si128((const __m128i *)(q)), bias)
+
+TARGET_SSE2 static void Median9RowSSE2(unsigned short *dst, const unsigned short *r0, const unsigned short *r1,
+                                       const unsigned short *r2, int n)
+{
+    __m128i const bias = _mm_set1_epi16((short) 0x8000);
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i p[9];
+        LOAD9(SSE2_LOADX, p, i);
+        MEDIAN9(__m128i, _mm_min_epi16, _mm_max_epi16, p);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(p[4], bias));
+    }
+    Median9Tail(dst, r0, r1, r2, n, i);
+}
+
+#undef SSE2_LOADX
+
+TARGET_SSE2 static void Mean2x2RowSSE2(unsigned short *dst, const unsigned short *r0, const unsigned short *r1, int n)
+{
+    __m128i const three = _mm_set1_epi16(3);
+#define SHR2(v) _mm_srli_epi16(v, 2)
+#define LOW2(v) _mm_and_si128(v, three)
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i const a = _mm_loadu_si128((const __m128i *)(r0 + i));
+        __m128i const b = _mm_loadu_si128((const __m128i *)(r0 + i + 1));
+        __m128i const c = _mm_loadu_si128((const __m128i *)(r1 + i));
+        __m128i const d = _mm_loadu_si128((const __m128i *)(r1 + i + 1));
+        _mm_storeu_si128((__m128i *)(dst + i), MEAN4(_mm_add_epi16, SHR2, LOW2, a, b, c, d));
+    }
+#undef SHR2
+#undef LOW2
+    Mean2x2Tail(dst, r0, r1, n, i);
+}
+
+#define AVX2_LOAD(q) _mm256_loadu_si256((const __m256i *)(q))
+
+TARGET_AVX2 static void Median9RowAVX2(unsigned short *dst, const unsigned short *r0, const unsigned short *r1,
+                                       const unsigned short *r2, int n)
+{
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i p[9];
+        LOAD9(AVX2_LOAD, p, i);
+        MEDIAN9(__m256i, _mm256_min_epu16, _mm256_max_epu16, p);
+        _mm256_storeu_si256((__m256i *)(dst + i), p[4]);
+    }
+    Median9Tail(dst, r0, r1, r2, n, i);
+}
+
+TARGET_AVX2 static void Mean2x2RowAVX2(unsigned short *dst, const unsigned short *r0, const unsigned short *r1, int n)
+{
+    __m256i const three = _mm256_set1_epi16(3);
+#define SHR2(v) _mm256_srli_epi16(v, 2)
+#define LOW2(v) _mm256_and_si256(v, three)
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i const a = AVX2_LOAD(r0 + i);
+        __m256i const b = AVX2_LOAD(r0 + i + 1);
+        __m256i const c = AVX2_LOAD(r1 + i);
+        __m256i const d = AVX2_LOAD(r1 + i + 1);
+        _mm256_storeu_si256((__m256i *)(dst + i), MEAN4(_mm256_add_epi16, SHR2, LOW2, a, b, c, d));
+    }
+#undef SHR2
+#undef LOW2
+    Mean2x2Tail(dst, r0, r1, n, i);
+}
+
+#undef AVX2_LOAD
+
+// The expansion needs a byte shuffle (SSSE3), which every AVX2 CPU has. SSE2-only
+// CPUs use the scalar loop.
+TARGET_AVX2 static void GrayToRgbRowAVX2(unsigned char *dst, const unsigned char *src, int n)
+{
+    __m128i const m0 = _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+    __m128i const m1 = _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+    __m128i const m2 = _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15);
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i const g = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i *const d = (__m128i *)(dst + 3 * i);
+        _mm_storeu_si128(d, _mm_shuffle_epi8(g, m0));
+        _mm_storeu_si128(d + 1, _mm_shuffle_epi8(g, m1));
+        _mm_storeu_si128(d + 2, _mm_shuffle_epi8(g, m2));
+    }
+    GrayToRgbTail(dst, src, n, i);
+}
+
+static void cpuid(int info[4], int leaf)
+{
+#if defined(_MSC_VER)
+    __cpuidex(info, leaf, 0);
+#else
+    __asm__ __volatile__("cpuid" : "=a"(info[0]), "=b"(info[1]), "=c"(info[2]), "=d"(info[3]) : "a"(leaf), "c"(0));
+#endif
+}
+
+static bool CpuHasSSE2()
+{
+#if defined(KERNELS_SSE2_BASELINE)
+    return true;
+#else
+    int info[4];
+    cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#endif
+}
+
+static bool CpuHasAVX2()
+{
+    int info[4];
+    cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    // the OS must save the YMM registers on context switch
+    cpuid(info, 1);
+    bool const osxsave = (info[2] & (1 << 27)) != 0;
+    bool const avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx)
+        return false;
+#if defined(_MSC_VER)
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int lo, hi;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    unsigned long long xcr0 = ((unsigned long long) hi << 32) | lo;
+#endif
+    if ((xcr0 & 6) != 6)
+        return false;
+
+    cpuid(info, 7);
+    return (info[1] & (1 << 5)) != 0;
+}
+
+#endif // KERNELS_X86
+
+#if defined(KERNELS_NEON)
+
+static void Median9RowNEON(unsigned short *dst, const unsigned short *r0, const unsigned short *r1,
+                           const unsigned short *r2, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        uint16x8_t p[9];
+        LOAD9(vld1q_u16, p, i);
+        MEDIAN9(uint16x8_t, vminq_u16, vmaxq_u16, p);
+        vst1q_u16(dst + i, p[4]);
+    }
+    Median9Tail(dst, r0, r1, r2, n, i);
+}
+
+static void Mean2x2RowNEON(unsigned short *dst, const unsigned short *r0, const unsigned short *r1, int n)
+{
+    uint16x8_t const three = vdupq_n_u16(3);
+#define SHR2(v) vshrq_n_u16(v, 2)
+#define LOW2(v) vandq_u16(v, three)
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        uint16x8_t const a = vld1q_u16(r0 + i);
+        uint16x8_t const b = vld1q_u16(r0 + i + 1);
+        uint16x8_t const c = vld1q_u16(r1 + i);
+        uint16x8_t const d = vld1q_u16(r1 + i + 1);
+        vst1q_u16(dst + i, MEAN4(vaddq_u16, SHR2, LOW2, a, b, c, d));
+    }
+#undef SHR2
+#undef LOW2
+    Mean2x2Tail(dst, r0, r1, n, i);
+}
+
+static void GrayToRgbRowNEON(unsigned char *dst, const unsigned char *src, int n)
+{
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16_t const g = vld1q_u8(src + i);
+        uint8x16x3_t const rgb = { { g, g, g } };
+        vst3q_u8(dst + 3 * i, rgb);
+    }
+    GrayToRgbTail(dst, src, n, i);
+}
+
+#endif // KERNELS_NEON
+
+static const ImageKernels s_scalarKernels = { "scalar", Median9RowScalar, Mean2x2RowScalar, GrayToRgbRowScalar };
+
+std::vector<ImageKernels> GetSupportedImageKernels()
+{
+    std::vector<ImageKernels> v;
+#if defined(KERNELS_X86)
+    if (CpuHasAVX2())
+    {
+        ImageKernels k = { "AVX2", Median9RowAVX2, Mean2x2RowAVX2, GrayToRgbRowAVX2 };
+        v.push_back(k);
+    }
+    if (CpuHasSSE2())
+    {
+        ImageKernels k = { "SSE2", Median9RowSSE2, Mean2x2RowSSE2, GrayToRgbRowScalar };
+        v.push_back(k);
+    }
+#elif defined(KERNELS_NEON)
+    ImageKernels k = { "NEON", Median9RowNEON, Mean2x2RowNEON, GrayToRgbRowNEON };
+    v.push_back(k);
+#endif
+    v.push_back(s_scalarKernels);
+    return v;
+}
+
+const ImageKernels& GetImageKernels()
+{
+    static const ImageKernels s_kernels = GetSupportedImageKernels().front();
+    return s_kernels;
+}
+
+const ImageKernels& GetScalarImageKernels()
+{
+    return s_scalarKernels;
+}
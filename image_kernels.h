@@ -0,0 +1,74 @@
+/*
+ *  image_kernels.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef IMAGE_KERNELS_INCLUDED
+#define IMAGE_KERNELS_INCLUDED
+
+#include <vector>
+
+//
+// Row kernels for the per-frame noise reduction filters and the display copy.
+//
+// Each kernel has a portable scalar reference implementation and SIMD variants
+// (SSE2 and AVX2 on x86, NEON on ARM). The best variant supported by the CPU is
+// selected once at startup. All variants produce bit-identical results.
+//
+
+// dst[i] = median of the 3x3 block whose left column is r0[i], r1[i], r2[i]
+typedef void (*Median9RowFn)(unsigned short *dst, const unsigned short *r0, const unsigned short *r1,
+                             const unsigned short *r2, int n);
+
+// dst[i] = (r0[i] + r0[i + 1] + r1[i] + r1[i + 1]) / 4, truncated
+typedef void (*Mean2x2RowFn)(unsigned short *dst, const unsigned short *r0, const unsigned short *r1, int n);
+
+// dst[3 * i] = dst[3 * i + 1] = dst[3 * i + 2] = src[i], gray to packed RGB
+typedef void (*GrayToRgbRowFn)(unsigned char *dst, const unsigned char *src, int n);
+
+struct ImageKernels
+{
+    const char *name;
+    Median9RowFn median9Row;
+    Mean2x2RowFn mean2x2Row;
+    GrayToRgbRowFn grayToRgbRow;
+};
+
+// the kernels selected for this CPU
+extern const ImageKernels& GetImageKernels();
+
+// the scalar reference kernels
+extern const ImageKernels& GetScalarImageKernels();
+
+// every variant the CPU supports, best first; the scalar kernels are last
+extern std::vector<ImageKernels> GetSupportedImageKernels();
+
+#endif // IMAGE_KERNELS_INCLUDED
@@ -34,12 +34,16 @@
 
 #include "phd.h"
 #include "image_math.h"
+#include "image_preprocess.h"
+#include "median3.h"
+#include "parallel_for.h"
 
 #include <wx/wfstream.h>
 #include <wx/txtstrm.h>
 #include <wx/tokenzr.h>
 
 #include <algorithm>
+#include <memory>
 
 int dbl_sort_func (double *first, double *second)
 {
@@ -103,45 +107,8 @@ bool QuickLRecon(usImage& img)
         tmp.Clear();
     }
 
-#define IX(x_, y_) ((RY + (y_)) * W + RX + (x_))
-
-    unsigned short *d;
-    unsigned int t;
-
-    for (int y = 0; y <= RH - 2; y++)
-    {
-        d = &tmp.ImageData[IX(0, y)];
-
-        for (int x = 0; x <= RW - 2; x++)
-        {
-            t  = img.ImageData[IX(x    , y    )];
-            t += img.ImageData[IX(x + 1, y    )];
-            t += img.ImageData[IX(x    , y + 1)];
-            t += img.ImageData[IX(x + 1, y + 1)];
-            *d++ = (unsigned short)(t >> 2);
-        }
-
-        // last col
-        t  = img.ImageData[IX(RW - 1, y    )];
-        t += img.ImageData[IX(RW - 1, y + 1)];
-        *d = (unsigned short)(t >> 1);
-    }
-
-    // last row
-
-    d = &tmp.ImageData[IX(0, RH - 1)];
-
-    for (int x = 0; x <= RW - 2; x++)
-    {
-        t  = img.ImageData[IX(x    , RH - 1)];
-        t += img.ImageData[IX(x + 1, RH - 1)];
-        *d++ = (unsigned short)(t >> 1);
-    }
-
-    // bottom-right pixel
-    *d = img.ImageData[IX(RW - 1, RH - 1)];
-
-#undef IX
+    FrameRect const r = { RX, RY, RW, RH };
+    Mean2x2Rows(tmp.ImageData, img.ImageData, W, r, 0, RH);
 
     img.SwapImageData(tmp);
     return false;
@@ -172,363 +139,21 @@ bool Median3(usImage& img)
     return false;
 }
 
-inline static void swap(unsigned short& a, unsigned short& b)
-{
-    unsigned short const t = a;
-    a = b;
-    b = t;
-}
-
-inline static unsigned short median9(const unsigned short l[9])
-{
-    unsigned short l0 = l[0], l1 = l[1], l2 = l[2], l3 = l[3], l4 = l[4];
-    unsigned short x;
-    x = l[5];
-    if (x < l0) swap(x, l0);
-    if (x < l1) swap(x, l1);
-    if (x < l2) swap(x, l2);
-    if (x < l3) swap(x, l3);
-    if (x < l4) swap(x, l4);
-    x = l[6];
-    if (x < l0) swap(x, l0);
-    if (x < l1) swap(x, l1);
-    if (x < l2) swap(x, l2);
-    if (x < l3) swap(x, l3);
-    if (x < l4) swap(x, l4);
-    x = l[7];
-    if (x < l0) swap(x, l0);
-    if (x < l1) swap(x, l1);
-    if (x < l2) swap(x, l2);
-    if (x < l3) swap(x, l3);
-    if (x < l4) swap(x, l4);
-    x = l[8];
-    if (x < l0) swap(x, l0);
-    if (x < l1) swap(x, l1);
-    if (x < l2) swap(x, l2);
-    if (x < l3) swap(x, l3);
-    if (x < l4) swap(x, l4);
-
-    if (l1 > l0) l0 = l1;
-    if (l2 > l0) l0 = l2;
-    if (l3 > l0) l0 = l3;
-    if (l4 > l0) l0 = l4;
-
-    return l0;
-}
-
-inline static unsigned short median8(const unsigned short l[8])
-{
-    unsigned short l0 = l[0], l1 = l[1], l2 = l[2], l3 = l[3], l4 = l[4];
-    unsigned short x;
-
-    x = l[5];
-    if (x < l0) swap(x, l0);
-    if (x < l1) swap(x, l1);
-    if (x < l2) swap(x, l2);
-    if (x < l3) swap(x, l3);
-    if (x < l4) swap(x, l4);
-    x = l[6];
-    if (x < l0) swap(x, l0);
-    if (x < l1) swap(x, l1);
-    if (x < l2) swap(x, l2);
-    if (x < l3) swap(x, l3);
-    if (x < l4) swap(x, l4);
-    x = l[7];
-    if (x < l0) swap(x, l0);
-    if (x < l1) swap(x, l1);
-    if (x < l2) swap(x, l2);
-    if (x < l3) swap(x, l3);
-    if (x < l4) swap(x, l4);
-
-    if (l2 > l0) swap(l2, l0);
-    if (l2 > l1) swap(l2, l1);
-
-    if (l3 > l0) swap(l3, l0);
-    if (l3 > l1) swap(l3, l1);
-
-    if (l4 > l0) swap(l4, l0);
-    if (l4 > l1) swap(l4, l1);
-
-    return (unsigned short)(((unsigned int) l0 + (unsigned int) l1) / 2);
-}
-
-inline static unsigned short median6(const unsigned short l[6])
-{
-    unsigned short l0 = l[0], l1 = l[1], l2 = l[2], l3 = l[3];
-    unsigned short x;
-
-    x = l[4];
-    if (x < l0) swap(x, l0);
-    if (x < l1) swap(x, l1);
-    if (x < l2) swap(x, l2);
-    if (x < l3) swap(x, l3);
-    x = l[5];
-    if (x < l0) swap(x, l0);
-    if (x < l1) swap(x, l1);
-    if (x < l2) swap(x, l2);
-    if (x < l3) swap(x, l3);
-
-    if (l2 > l0) swap(l2, l0);
-    if (l2 > l1) swap(l2, l1);
-
-    if (l3 > l0) swap(l3, l0);
-    if (l3 > l1) swap(l3, l1);
-
-    return (unsigned short)(((unsigned int) l0 + (unsigned int) l1) / 2);
-}
-
-inline static unsigned short median5(const unsigned short l[5])
-{
-    unsigned short l0 = l[0], l1 = l[1], l2 = l[2];
-    unsigned short x;
-    x = l[3];
-    if (x < l0) swap(x, l0);
-    if (x < l1) swap(x, l1);
-    if (x < l2) swap(x, l2);
-    x = l[4];
-    if (x < l0) swap(x, l0);
-    if (x < l1) swap(x, l1);
-    if (x < l2) swap(x, l2);
-
-    if (l1 > l0) l0 = l1;
-    if (l2 > l0) l0 = l2;
-
-    return l0;
-}
-
-inline static unsigned short median4(const unsigned short l[4])
-{
-    unsigned short l0 = l[0], l1 = l[1], l2 = l[2];
-    unsigned short x;
-    x = l[3];
-    if (x < l0) swap(x, l0);
-    if (x < l1) swap(x, l1);
-    if (x < l2) swap(x, l2);
-
-    if (l2 > l0) swap(l2, l0);
-    if (l2 > l1) swap(l2, l1);
-
-    return (unsigned short)(((unsigned int) l0 + (unsigned int) l1) / 2);
-}
-
-inline static unsigned short median3(const unsigned short l[3])
-{
-    unsigned short l0 = l[0], l1 = l[1], l2 = l[2];
-    if (l2 < l0) swap(l2, l0);
-    if (l2 < l1) swap(l2, l1);
-    if (l1 > l0) l0 = l1;
-    return l0;
-}
-
 void Median3(unsigned short *dst, const unsigned short *src, const wxSize& size, const wxRect& rect)
 {
-    int const W = size.GetWidth();
-    int const RX = rect.GetX();
-    int const RY = rect.GetY();
-    int const RW = rect.GetWidth();
-    int const RH = rect.GetHeight();
-
-    unsigned short a[9];
-    unsigned short *d;
-
-#define IX(x_, y_) ((RY + (y_)) * W + RX + (x_))
-
-    // top row
-    d = &dst[IX(0, 0)];
-
-    // top-left corner
-    a[0] = src[IX(0, 0)];
-    a[1] = src[IX(1, 0)];
-    a[2] = src[IX(0, 1)];
-    a[3] = src[IX(1, 1)];
-    *d++ = median4(a);
-
-    // top row middle pixels
-    for (int x = 1; x <= RW - 2; x++)
-    {
-        a[0] = src[IX(x - 1, 0)];
-        a[1] = src[IX(x,     0)];
-        a[2] = src[IX(x + 1, 0)];
-        a[3] = src[IX(x - 1, 1)];
-        a[4] = src[IX(x,     1)];
-        a[5] = src[IX(x + 1, 1)];
-        *d++ = median6(a);
-    }
-
-    // top-right corner
-    a[0] = src[IX(RW - 2, 0)];
-    a[1] = src[IX(RW - 1, 0)];
-    a[2] = src[IX(RW - 2, 1)];
-    a[3] = src[IX(RW - 1, 1)];
-    *d = median4(a);
-
-    for (int y = 1; y <= RH - 2; y++)
-    {
-        d = &dst[IX(0, y)];
-
-        // leftmost pixel
-        a[0] = src[IX(0, y - 1)];
-        a[1] = src[IX(1, y - 1)];
-        a[2] = src[IX(0, y    )];
-        a[3] = src[IX(1, y    )];
-        a[4] = src[IX(0, y + 1)];
-        a[5] = src[IX(1, y + 1)];
-        *d++ = median6(a);
-
-        for (int x = 1; x <= RW - 2; x++)
-        {
-            a[0] = src[IX(x - 1, y - 1)];
-            a[1] = src[IX(x    , y - 1)];
-            a[2] = src[IX(x + 1, y - 1)];
-            a[3] = src[IX(x - 1, y    )];
-            a[4] = src[IX(x    , y    )];
-            a[5] = src[IX(x + 1, y    )];
-            a[6] = src[IX(x - 1, y + 1)];
-            a[7] = src[IX(x    , y + 1)];
-            a[8] = src[IX(x + 1, y + 1)];
-            *d++ = median9(a);
-        }
-
-        // rightmost pixel
-        a[0] = src[IX(RW - 2, y - 1)];
-        a[1] = src[IX(RW - 1, y - 1)];
-        a[2] = src[IX(RW - 2, y    )];
-        a[3] = src[IX(RW - 1, y    )];
-        a[4] = src[IX(RW - 2, y + 1)];
-        a[5] = src[IX(RW - 1, y + 1)];
-        *d++ = median6(a);
-    }
-
-    // bottom row
-    d = &dst[IX(0, RH - 1)];
-
-    // bottom-left corner
-    a[0] = src[IX(0, RH - 2)];
-    a[1] = src[IX(1, RH - 2)];
-    a[2] = src[IX(0, RH - 1)];
-    a[3] = src[IX(1, RH - 1)];
-    *d++ = median4(a);
-
-    // bottom row middle pixels
-    for (int x = 1; x <= RW - 2; x++)
-    {
-        a[0] = src[IX(x - 1, RH - 2)];
-        a[1] = src[IX(x    , RH - 2)];
-        a[2] = src[IX(x + 1, RH - 2)];
-        a[3] = src[IX(x - 1, RH - 1)];
-        a[4] = src[IX(x    , RH - 1)];
-        a[5] = src[IX(x + 1, RH - 1)];
-        *d++ = median6(a);
-    }
+    // rows are independent, so large frames are filtered in parallel stripes
+    enum { MIN_STRIPE_ROWS = 128 };
 
-    // bottom-right corner
-    a[0] = src[IX(RW - 2, RH - 2)];
-    a[1] = src[IX(RW - 1, RH - 2)];
-    a[2] = src[IX(RW - 2, RH - 1)];
-    a[3] = src[IX(RW - 1, RH - 1)];
-    *d = median4(a);
-
-#undef IX
+    FrameRect const r = { rect.GetX(), rect.GetY(), rect.GetWidth(), rect.GetHeight() };
+    ParallelFor(r.height, MIN_STRIPE_ROWS, [&](int y0, int y1) {
+        Median3Rows(dst, src, size.GetWidth(), r, y0, y1);
+    });
 }
 
-static unsigned short MedianBorderingPixels(const usImage& img, int x, int y)
+void CalcFrameStats(FrameStats *stats, const unsigned short *src, const wxSize& size, const wxRect& rect)
 {
-    unsigned short array[8];
-    int const xsize = img.Size.GetWidth();
-    int const ysize = img.Size.GetHeight();
-
-    if (x > 0 && y > 0 && x < xsize - 1 && y < ysize - 1)
-    {
-        array[0] = img.ImageData[(x-1) + (y-1) * xsize];
-        array[1] = img.ImageData[(x)   + (y-1) * xsize];
-        array[2] = img.ImageData[(x+1) + (y-1) * xsize];
-        array[3] = img.ImageData[(x-1) + (y)   * xsize];
-        array[4] = img.ImageData[(x+1) + (y)   * xsize];
-        array[5] = img.ImageData[(x-1) + (y+1) * xsize];
-        array[6] = img.ImageData[(x)   + (y+1) * xsize];
-        array[7] = img.ImageData[(x+1) + (y+1) * xsize];
-        return median8(array);
-    }
-
-    if (x == 0 && y > 0 && y < ysize - 1)
-    {
-        // On left edge
-        array[0] = img.ImageData[(x)     + (y - 1) * xsize];
-        array[1] = img.ImageData[(x)     + (y + 1) * xsize];
-        array[2] = img.ImageData[(x + 1) + (y - 1) * xsize];
-        array[3] = img.ImageData[(x + 1) + (y)     * xsize];
-        array[4] = img.ImageData[(x + 1) + (y + 1) * xsize];
-        return median5(array);
-    }
-
-    if (x == xsize - 1 && y > 0 && y < ysize - 1)
-    {
-        // On right edge
-        array[0] = img.ImageData[(x)     + (y - 1) * xsize];
-        array[1] = img.ImageData[(x)     + (y + 1) * xsize];
-        array[2] = img.ImageData[(x - 1) + (y - 1) * xsize];
-        array[3] = img.ImageData[(x - 1) + (y)     * xsize];
-        array[4] = img.ImageData[(x - 1) + (y + 1) * xsize];
-        return median5(array);
-    }
-
-    if (y == 0 && x > 0 && x < xsize - 1)
-    {
-        // On bottom edge
-        array[0] = img.ImageData[(x - 1) + (y)     * xsize];
-        array[1] = img.ImageData[(x - 1) + (y + 1) * xsize];
-        array[2] = img.ImageData[(x)     + (y + 1) * xsize];
-        array[3] = img.ImageData[(x + 1) + (y)     * xsize];
-        array[4] = img.ImageData[(x + 1) + (y + 1) * xsize];
-        return median5(array);
-    }
-
-    if (y == ysize - 1 && x > 0 && x < xsize - 1)
-    {
-        // On top edge
-        array[0] = img.ImageData[(x - 1) + (y)     * xsize];
-        array[1] = img.ImageData[(x - 1) + (y - 1) * xsize];
-        array[2] = img.ImageData[(x)     + (y - 1) * xsize];
-        array[3] = img.ImageData[(x + 1) + (y)     * xsize];
-        array[4] = img.ImageData[(x + 1) + (y - 1) * xsize];
-        return median5(array);
-    }
-
-    if (x == 0 && y == 0)
-    {
-        // At lower left corner
-        array[0] = img.ImageData[(x + 1) + (y)     * xsize];
-        array[1] = img.ImageData[(x)     + (y + 1) * xsize];
-        array[2] = img.ImageData[(x + 1) + (y + 1) * xsize];
-    }
-    else if (x == 0 && y == ysize - 1)
-    {
-        // At upper left corner
-        array[0] = img.ImageData[(x + 1) + (y)     * xsize];
-        array[1] = img.ImageData[(x)     + (y - 1) * xsize];
-        array[2] = img.ImageData[(x + 1) + (y - 1) * xsize];
-    }
-    else if (x == xsize - 1 && y == ysize - 1)
-    {
-        // At upper right corner
-        array[0] = img.ImageData[(x - 1) + (y)     * xsize];
-        array[1] = img.ImageData[(x)     + (y - 1) * xsize];
-        array[2] = img.ImageData[(x - 1) + (y - 1) * xsize];
-    }
-    else if (x == xsize - 1 && y == 0)
-    {
-        // At lower right corner
-        array[0] = img.ImageData[(x - 1) + (y)     * xsize];
-        array[1] = img.ImageData[(x)     + (y + 1) * xsize];
-        array[2] = img.ImageData[(x - 1) + (y + 1) * xsize];
-    }
-    else
-    {
-        // unreachable
-        return 0;
-    }
-
-    return median3(array);
+    FrameRect const r = { rect.GetX(), rect.GetY(), rect.GetWidth(), rect.GetHeight() };
+    CalcFrameStats(stats, src, size.GetWidth(), r);
 }
 
 bool SquarePixels(usImage& img, float xsize, float ysize)
@@ -575,23 +200,19 @@ bool SquarePixels(usImage& img, float xsize, float ysize)
 // Dark subtraction algorithm:
 //     Pedestal = max(median(dark_frame) - median(light_frame), 0) - handles overall gain/gradient differences
 //     Dark_corrected(i) = min(max(light(i) + pedestal - dark(i), 0), 65335)
-bool Subtract(usImage& light, const usImage& dark)
+// Sets light.Pedestal from the medians of the light and dark frames over the light
+// frame's subframe (or the full frame)
+static void SetDarkPedestal(usImage& light, const usImage& dark)
 {
-    if (!light.ImageData || !dark.ImageData)
-        return true;
-    if (light.Size != dark.Size)
-        return true;
-
-    unsigned int left, top, width, height;
     unsigned short median_light, median_dark;
     median_light = light.MedianADU;    // median of frame or subframe
 
     if (!light.Subframe.IsEmpty())
     {
-        left = light.Subframe.GetLeft();
-        width = light.Subframe.GetWidth();
-        top = light.Subframe.GetTop();
-        height = light.Subframe.GetHeight();
+        unsigned int left = light.Subframe.GetLeft();
+        unsigned int width = light.Subframe.GetWidth();
+        unsigned int top = light.Subframe.GetTop();
+        unsigned int height = light.Subframe.GetHeight();
 
         // compute the dark's median ADU within the subframe region
         unsigned int pixcnt = width * height;
@@ -610,9 +231,6 @@ bool Subtract(usImage& light, const usImage& dark)
     }
     else
     {
-        left = top = 0;
-        width = light.Size.GetWidth();
-        height = light.Size.GetHeight();
         median_dark = dark.MedianADU; // use the pre-computed full frame median ADU
     }
 
@@ -621,120 +239,214 @@ bool Subtract(usImage& light, const usImage& dark)
         // dark was brighter than light
         light.Pedestal = median_dark - median_light;   // Needed for saturation detection in find-star
     }
+}
+
+bool Subtract(usImage& light, const usImage& dark)
+{
+    if (!light.ImageData || !dark.ImageData)
+        return true;
+    if (light.Size != dark.Size)
+        return true;
+
+    SetDarkPedestal(light, dark);
+
+    unsigned int left, top, width, height;
+
+    if (!light.Subframe.IsEmpty())
+    {
+        left = light.Subframe.GetLeft();
+        width = light.Subframe.GetWidth();
+        top = light.Subframe.GetTop();
+        height = light.Subframe.GetHeight();
+    }
+    else
+    {
+        left = top = 0;
+        width = light.Size.GetWidth();
+        height = light.Size.GetHeight();
+    }
 
     unsigned short *pl0 = &light.Pixel(left, top);
     const unsigned short *pd0 = &dark.Pixel(left, top);
     for (unsigned int r = 0; r < height;
          r++, pl0 += light.Size.GetWidth(), pd0 += light.Size.GetWidth())
     {
-        unsigned short *const endl = pl0 + width;
-        unsigned short *pl;
-        const unsigned short *pd;
-        for (pl = pl0, pd = pd0; pl < endl; pl++, pd++)
-        {
-            int newval = (int) *pl + light.Pedestal - (int) *pd;
-            if (newval < 0) newval = 0; // hot pixel in dark frame isn't present in light frame
-            else if (newval > 65535) newval = 65535;
-            *pl = (unsigned short) newval;
-        }
+        SubtractDarkRow(pl0, pd0, width, light.Pedestal);
     }
 
     return false;
 }
 
-inline static unsigned short histo_median(unsigned short histo1[256], unsigned short histo2[65536], int n)
+// Two-level histogram of the pixels in a median filter window that keeps track of
+// the median as pixels are added and removed. Each pixel update is O(1) and the
+// median only has to move from its previous position, skipping empty coarse bins,
+// rather than being searched for from the start of the histogram.
+struct MedianHistogram
 {
-    n /= 2;
-    unsigned int i;
-    for (i = 0; i < 256; i++)
+    std::vector<unsigned int> coarse;   // indexed by the high byte of the pixel value
+    std::vector<unsigned int> fine;
+    unsigned int n;        // number of pixels in the window
+    unsigned int med;      // current median estimate
+    unsigned int below;    // number of pixels with value < med
+
+    MedianHistogram() : coarse(256), fine(65536), n(0), med(0), below(0) { }
+
+    void Add(unsigned short v)
     {
-        if (histo1[i] > n)
-            break;
-        n -= histo1[i];
+        ++coarse[v >> 8];
+        ++fine[v];
+        ++n;
+        if (v < med)
+            ++below;
     }
-    for (i <<= 8; i < 65536; i++)
+
+    void Remove(unsigned short v)
     {
-        if (histo2[i] > n)
-            break;
-        n -= histo2[i];
+        --coarse[v >> 8];
+        --fine[v];
+        --n;
+        if (v < med)
+            --below;
     }
-    return i;
-}
 
-static void MedianFilter(usImage& dst, const usImage& src, int halfWidth)
-{
-    dst.Init(src.Size);
-    unsigned short *d = &dst.ImageData[0];
+    // the median is the element at index n/2 of the sorted window pixels
+    unsigned short Median()
+    {
+        unsigned int const t = n / 2;
 
+        while (below > t)
+        {
+            --med;
+            if ((med & 0xff) == 0xff && coarse[med >> 8] == 0)
+                med &= ~0xffU; // empty block, skip to its first bin
+            else
+                below -= fine[med];
+        }
+
+        while (below + fine[med] <= t)
+        {
+            below += fine[med];
+            ++med;
+            if ((med & 0xff) == 0 && coarse[med >> 8] == 0)
+                med |= 0xff; // empty block, skip to its last bin
+        }
+
+        return (unsigned short) med;
+    }
+};
+
+// Median filter rows [y0, y1) of src into dst. The window is moved in a serpentine
+// pattern (left to right, down one row, right to left, down one row, ...) so the
+// histogram is only initialized once per stripe of rows.
+static void MedianFilterRows(usImage& dst, const usImage& src, int halfWidth, int y0, int y1)
+{
     int const width = src.Size.GetWidth();
     int const height = src.Size.GetHeight();
 
-    for (int y = 0; y < height; y++)
+    MedianHistogram histo;
+
+    int top = std::max(0, y0 - halfWidth);
+    int bot = std::min(y0 + halfWidth, height - 1);
+    int left = 0;
+    int right = std::min(halfWidth, width - 1);
+
+    for (int j = top; j <= bot; j++)
     {
-        int top = std::max(0, y - halfWidth);
-        int bot = std::min(y + halfWidth, height - 1);
-        int left = 0;
-        int right = halfWidth;
-
-        // TODO: we initialize the histogram at the start of each row, but we could make this faster
-        // if we scan left to right, move down, scan right to left, move down so we never need to
-        // reinitialize the histogram
-
-        // initialize 2-level histogram
-        unsigned short histo1[256];
-        unsigned short histo2[65536];
-        memset(&histo1[0], 0, sizeof(histo1));
-        memset(&histo2[0], 0, sizeof(histo2));
-
-        for (int j = top; j <= bot; j++)
+        const unsigned short *p = &src.Pixel(left, j);
+        for (int i = left; i <= right; i++, p++)
+            histo.Add(*p);
+    }
+
+    for (int y = y0; y < y1; y++)
+    {
+        if (y > y0)
         {
-            const unsigned short *p = &src.Pixel(left, j);
-            for (int i = left; i <= right; i++, p++)
+            // move the window down one row
+            int const newTop = std::max(0, y - halfWidth);
+            int const newBot = std::min(y + halfWidth, height - 1);
+            if (newTop > top)
             {
-                ++histo1[*p >> 8];
-                ++histo2[*p];
+                const unsigned short *p = &src.Pixel(left, top);
+                for (int i = left; i <= right; i++, p++)
+                    histo.Remove(*p);
             }
+            if (newBot > bot)
+            {
+                const unsigned short *p = &src.Pixel(left, newBot);
+                for (int i = left; i <= right; i++, p++)
+                    histo.Add(*p);
+            }
+            top = newTop;
+            bot = newBot;
         }
-        unsigned int n = (right - left + 1) * (bot - top + 1);
 
-        // read off first value for this row
-        *d++ = histo_median(histo1, histo2, n);
+        unsigned short *d = &dst.Pixel(0, y);
 
-        // loop across remaining columns for this row
-        for (int i = 1; i < width; i++)
+        if (((y - y0) & 1) == 0)
         {
-            left = std::max(0, i - halfWidth);
-            right = std::min(i + halfWidth, width - 1);
-
-            // remove leftmost column
-            if (left > 0)
+            // left to right
+            for (int x = 0; x < width; x++)
             {
-                const unsigned short *p = &src.Pixel(left - 1, top);
-                for (int j = top; j <= bot; j++, p += width)
+                if (x > 0)
                 {
-                    --histo1[*p >> 8];
-                    --histo2[*p];
+                    if (x - halfWidth > left)
+                    {
+                        const unsigned short *p = &src.Pixel(left, top);
+                        for (int j = top; j <= bot; j++, p += width)
+                            histo.Remove(*p);
+                        ++left;
+                    }
+                    if (x + halfWidth < width && x + halfWidth > right)
+                    {
+                        ++right;
+                        const unsigned short *p = &src.Pixel(right, top);
+                        for (int j = top; j <= bot; j++, p += width)
+                            histo.Add(*p);
+                    }
                 }
-                n -= (bot - top + 1);
+                d[x] = histo.Median();
             }
-
-            // add new column on right
-            if (i + halfWidth <= width - 1)
+        }
+        else
+        {
+            // right to left
+            for (int x = width - 1; x >= 0; x--)
             {
-                const unsigned short *p = &src.Pixel(right, top);
-                for (int j = top; j <= bot; j++, p += width)
+                if (x < width - 1)
                 {
-                    ++histo1[*p >> 8];
-                    ++histo2[*p];
+                    if (x + halfWidth < right)
+                    {
+                        const unsigned short *p = &src.Pixel(right, top);
+                        for (int j = top; j <= bot; j++, p += width)
+                            histo.Remove(*p);
+                        --right;
+                    }
+                    if (x - halfWidth >= 0 && x - halfWidth < left)
+                    {
+                        --left;
+                        const unsigned short *p = &src.Pixel(left, top);
+                        for (int j = top; j <= bot; j++, p += width)
+                            histo.Add(*p);
+                    }
                 }
-                n += (bot - top + 1);
+                d[x] = histo.Median();
             }
-
-            *d++ = histo_median(histo1, histo2, n);
         }
     }
 }
 
+static void MedianFilter(usImage& dst, const usImage& src, int halfWidth)
+{
+    dst.Init(src.Size);
+
+    // each stripe of rows is filtered independently on its own core; the stripes
+    // are tall enough that the histogram setup for each one is negligible
+    enum { MIN_STRIPE_ROWS = 64 };
+
+    ParallelFor(src.Size.GetHeight(), MIN_STRIPE_ROWS,
+        [&](int y0, int y1) { MedianFilterRows(dst, src, halfWidth, y0, y1); });
+}
+
 struct ImageStatsWork
 {
     ImageStats stats;
@@ -1039,41 +751,86 @@ const wxArrayString& DefectMapBuilder::GetMapInfo() const
     return m_impl->mapInfo;
 }
 
+// Correct the defects of row y that lie in columns [left, right]
+static void RemoveRowDefects(usImage& light, const DefectMap& defectMap, int y, int left, int right)
+{
+    RemoveDefectRow(light.ImageData, light.Size.GetWidth(), light.Size.GetHeight(), defectMap.Rows(), y, left, right);
+}
+
 bool RemoveDefects(usImage& light, const DefectMap& defectMap)
 {
     // Check to make sure the light frame is valid
     if (!light.ImageData)
         return true;
 
+    // only the rows and columns of the subframe are visited
+    wxRect rect(light.Size);
     if (!light.Subframe.IsEmpty())
+        rect.Intersect(light.Subframe);
+
+    int const bottom = wxMin(rect.GetBottom(), defectMap.Rows().RowCount() - 1);
+
+    for (int y = rect.GetTop(); y <= bottom; y++)
+        RemoveRowDefects(light, defectMap, y, rect.GetLeft(), rect.GetRight());
+
+    return false;
+}
+
+// Dark subtraction (or defect removal), noise reduction and the frame statistics
+// in a single pass over the subframe (see PreprocessFrame). The result is the same
+// as Subtract or RemoveDefects, then QuickLRecon or Median3, then
+// usImage::CalcStats.
+bool PreprocessImage(usImage& img, const usImage *dark, const DefectMap *defectMap, int noiseReduction)
+{
+    static_assert(NR_NONE == PREPROCESS_NR_NONE && NR_2x2MEAN == PREPROCESS_NR_2x2MEAN &&
+        NR_3x3MEDIAN == PREPROCESS_NR_3x3MEDIAN, "noise reduction methods out of step");
+
+    if (!img.ImageData || !img.NPixels)
+        return true;
+
+    if (dark && (!dark->ImageData || dark->Size != img.Size))
     {
-        // Step over each defect and replace the light value
-        // with the median of the surrounding pixels
-        for (DefectMap::const_iterator it = defectMap.begin(); it != defectMap.end(); ++it)
-        {
-            const wxPoint& pt = *it;
-            // Check to see if we are within the subframe before correcting the defect
-            if (light.Subframe.Contains(pt))
-            {
-                light.Pixel(pt.x, pt.y) = MedianBorderingPixels(light, pt.x, pt.y);
-            }
-        }
+        Debug.Write(wxString::Format("PreprocessImage: dark frame %dx%d does not match image %dx%d, dark not subtracted\n",
+            dark->Size.GetWidth(), dark->Size.GetHeight(), img.Size.GetWidth(), img.Size.GetHeight()));
+        dark = nullptr;         // Subtract would reject it too
     }
-    else
+
+    bool const subframe = !img.Subframe.IsEmpty();
+    wxRect const rect(subframe ? img.Subframe : wxRect(img.Size));
+
+    if (defectMap)
+        dark = nullptr;         // the defect map takes the place of the dark
+    else if (dark)
+        SetDarkPedestal(img, *dark);
+
+    // noise reduction writes to a separate buffer, which is swapped in at the end
+    usImage tmp;
+    if (noiseReduction != NR_NONE)
     {
-        // Step over each defect and replace the light value
-        // with the median of the surrounding pixels
-        for (DefectMap::const_iterator it = defectMap.begin(); it != defectMap.end(); ++it)
+        if (tmp.Init(img.Size))
         {
-            int const x = it->x;
-            int const y = it->y;
-
-            if (x >= 0 && x < light.Size.GetWidth() && y >= 0 && y < light.Size.GetHeight())
-            {
-                light.Pixel(x, y) = MedianBorderingPixels(light, x, y);
-            }
+            Debug.Write("PreprocessImage: ERROR: memory allocation failure, skipping noise reduction\n");
+            noiseReduction = NR_NONE;
         }
+        else if (subframe)
+            tmp.Clear();
     }
+    unsigned short *const filtered = noiseReduction != NR_NONE ? tmp.ImageData : img.ImageData;
+
+    FrameRect const frect = { rect.GetX(), rect.GetY(), rect.GetWidth(), rect.GetHeight() };
+    FrameStats stats;
+    PreprocessFrame(img.ImageData, filtered, img.Size.GetWidth(), img.Size.GetHeight(), frect,
+        dark ? dark->ImageData : nullptr, img.Pedestal, defectMap ? &defectMap->Rows() : nullptr,
+        (PreprocessNoiseReduction) noiseReduction, &stats);
+
+    if (noiseReduction != NR_NONE)
+        img.SwapImageData(tmp);
+
+    img.MinADU = stats.minADU;
+    img.MaxADU = stats.maxADU;
+    img.MedianADU = stats.medianADU;
+    img.FiltMin = stats.filtMin;
+    img.FiltMax = stats.filtMax;
 
     return false;
 }
@@ -1199,9 +956,24 @@ DefectMap::DefectMap(int profileId)
 {
 }
 
+void DefectMap::push_back(const wxPoint& pt)
+{
+    m_defects.push_back(pt);
+    m_rows.Add(pt.x, pt.y);
+}
+
+void DefectMap::clear()
+{
+    m_defects.clear();
+    m_rows.Clear();
+}
+
 bool DefectMap::FindDefect(const wxPoint& pt) const
 {
-    return std::find(begin(), end(), pt) != end();
+    if (pt.y < 0 || pt.y >= DefectRowIndex::MAX_ROWS)
+        return std::find(begin(), end(), pt) != end();
+
+    return m_rows.Find(pt.x, pt.y);
 }
 
 void DefectMap::AddDefect(const wxPoint& pt)
@@ -36,11 +36,21 @@
 #ifndef IMAGE_MATH_INCLUDED
 #define IMAGE_MATH_INCLUDED
 
-class DefectMap : public std::vector<wxPoint>
+#include "image_preprocess.h"
+
+// A set of bad pixel locations. The points are kept in the order they were added,
+// which is the order of the defect map file, and are also indexed by row: each
+// row holds the sorted x coordinates of its defects. Correcting a subframe only
+// visits the rows it covers, and FindDefect is a binary search within one row.
+class DefectMap
 {
     int m_profileId;
+    std::vector<wxPoint> m_defects;
+    DefectRowIndex m_rows;
     DefectMap(int profileId);
 public:
+    typedef std::vector<wxPoint>::const_iterator const_iterator;
+
     static void DeleteDefectMap(int profileId);
     static bool DefectMapExists(int profileId, bool showAlert);
     static DefectMap *LoadDefectMap(int profileId);
@@ -51,16 +61,29 @@ public:
     bool FindDefect(const wxPoint& pt) const;
     void AddDefect(const wxPoint& pt);
 
+    const_iterator begin() const { return m_defects.begin(); }
+    const_iterator end() const { return m_defects.end(); }
+    size_t size() const { return m_defects.size(); }
+    bool empty() const { return m_defects.empty(); }
+    void clear();
+    void push_back(const wxPoint& pt);
+
+    // the defects indexed by row
+    const DefectRowIndex& Rows() const { return m_rows; }
 };
 
+struct FrameStats;
+
 extern bool QuickLRecon(usImage& img);
 extern void Median3(unsigned short *dst, const unsigned short *src, const wxSize& size, const wxRect& rect);
 extern bool Median3(usImage& img);
+extern void CalcFrameStats(FrameStats *stats, const unsigned short *src, const wxSize& size, const wxRect& rect);
 extern bool SquarePixels(usImage& img, float xsize, float ysize);
 extern int dbl_sort_func(double *first, double *second);
 extern bool Subtract(usImage& light, const usImage& dark);
 extern double CalcSlope(const ArrayOfDbl& y);
 extern bool RemoveDefects(usImage& light, const DefectMap& defectMap);
+extern bool PreprocessImage(usImage& img, const usImage *dark, const DefectMap *defectMap, int noiseReduction);
 
 struct DefectMapBuilderImpl;
 
@@ -0,0 +1,174 @@
+/*
+ *  image_pool.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "phd.h"
+
+#include <map>
+#include <vector>
+
+// maximum number of idle buffers retained by the pool across all geometries
+enum { MAX_POOLED_BUFFERS = 8 };
+
+struct ImagePoolImpl
+{
+    typedef std::vector<unsigned short *> FreeList;
+
+    wxCriticalSection lock;
+    std::map<unsigned int, FreeList> buckets; // keyed by pixel count
+    ImagePool::Stats stats;
+
+    ImagePoolImpl()
+    {
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    ~ImagePoolImpl()
+    {
+        for (auto it = buckets.begin(); it != buckets.end(); ++it)
+            for (unsigned short *buf : it->second)
+                delete[] buf;
+    }
+
+    // free one idle buffer of a geometry other than npixels, returns false if there are none
+    bool EvictOther(unsigned int npixels)
+    {
+        for (auto it = buckets.begin(); it != buckets.end(); ++it)
+        {
+            if (it->first == npixels || it->second.empty())
+                continue;
+            delete[] it->second.back();
+            it->second.pop_back();
+            --stats.pooled;
+            stats.pooledBytes -= it->first * sizeof(unsigned short);
+            if (it->second.empty())
+                buckets.erase(it);
+            return true;
+        }
+        return false;
+    }
+};
+
+static ImagePoolImpl *s_pool;
+
+void ImagePool::Init()
+{
+    if (!s_pool)
+        s_pool = new ImagePoolImpl();
+}
+
+void ImagePool::Destroy()
+{
+    if (s_pool)
+    {
+        LogStats();
+        delete s_pool;
+        s_pool = nullptr;
+    }
+}
+
+unsigned short *ImagePool::Acquire(unsigned int npixels)
+{
+    if (!npixels)
+        return nullptr;
+
+    if (s_pool)
+    {
+        unsigned int hits, misses;
+
+        {
+            wxCriticalSectionLocker lck(s_pool->lock);
+
+            auto it = s_pool->buckets.find(npixels);
+            if (it != s_pool->buckets.end() && !it->second.empty())
+            {
+                unsigned short *buf = it->second.back();
+                it->second.pop_back();
+                --s_pool->stats.pooled;
+                s_pool->stats.pooledBytes -= npixels * sizeof(unsigned short);
+                ++s_pool->stats.hits;
+                return buf;
+            }
+
+            hits = s_pool->stats.hits;
+            misses = ++s_pool->stats.misses;
+        }
+
+        // misses only happen while the pool warms up or when the frame geometry changes
+        Debug.Write(wxString::Format("ImagePool: miss, allocating %u pixels (hits=%u misses=%u)\n",
+            npixels, hits, misses));
+    }
+
+    return new unsigned short[npixels];
+}
+
+void ImagePool::Release(unsigned short *buf, unsigned int npixels)
+{
+    if (!buf)
+        return;
+
+    if (s_pool && npixels)
+    {
+        wxCriticalSectionLocker lck(s_pool->lock);
+
+        if (s_pool->stats.pooled < MAX_POOLED_BUFFERS || s_pool->EvictOther(npixels))
+        {
+            s_pool->buckets[npixels].push_back(buf);
+            ++s_pool->stats.pooled;
+            s_pool->stats.pooledBytes += npixels * sizeof(unsigned short);
+            return;
+        }
+
+        ++s_pool->stats.discards;
+    }
+
+    delete[] buf;
+}
+
+void ImagePool::GetStats(Stats *stats)
+{
+    if (s_pool)
+    {
+        wxCriticalSectionLocker lck(s_pool->lock);
+        *stats = s_pool->stats;
+    }
+    else
+        memset(stats, 0, sizeof(*stats));
+}
+
+void ImagePool::LogStats()
+{
+    Stats stats;
+    GetStats(&stats);
+    Debug.Write(wxString::Format("ImagePool: hits=%u misses=%u discards=%u pooled=%u (%.1f MB)\n",
+        stats.hits, stats.misses, stats.discards, stats.pooled, (double) stats.pooledBytes / (1024. * 1024.)));
+}
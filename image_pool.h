@@ -0,0 +1,75 @@
+/*
+ *  image_pool.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef IMAGE_POOL_INCLUDED
+#define IMAGE_POOL_INCLUDED
+
+//
+// ImagePool recycles the pixel buffers used by usImage.
+//
+// Each exposure used to allocate a fresh frame-sized buffer in usImage::Init and
+// free it a couple of frames later when the image logger let go of it. With large
+// sensors that is a multi-megabyte allocate/free (and the associated page faults)
+// for every frame. The pool keeps a small number of released buffers, keyed by
+// frame geometry (pixel count), and hands them back out on the next Init of the
+// same geometry.
+//
+// All usImage instances draw from the pool: the capture loop, the guider's
+// current image, the image logger's saved frames and the temporary images used for
+// noise reduction and dark subtraction. The pool is thread-safe, buffers are
+// acquired on the worker thread and usually released on the main thread.
+//
+class ImagePool
+{
+public:
+
+    struct Stats
+    {
+        unsigned int hits;       // buffer requests satisfied from the pool
+        unsigned int misses;     // buffer requests that required an allocation
+        unsigned int discards;   // released buffers freed because the pool was full
+        unsigned int pooled;     // buffers currently held by the pool
+        size_t pooledBytes;      // memory currently held by the pool
+    };
+
+    static void Init();
+    static void Destroy();
+
+    static unsigned short *Acquire(unsigned int npixels);
+    static void Release(unsigned short *buf, unsigned int npixels);
+
+    static void GetStats(Stats *stats);
+    static void LogStats();
+};
+
+#endif // IMAGE_POOL_INCLUDED
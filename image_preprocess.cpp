@@ -0,0 +1,433 @@
+/*
+ *  image_preprocess.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "image_preprocess.h"
+#include "image_kernels.h"
+
+#include <algorithm>
+
+bool DefectRowIndex::Add(int x, int y)
+{
+    if (y < 0 || y >= MAX_ROWS)
+        return false;
+
+    if (y >= (int) m_rows.size())
+        m_rows.resize(y + 1);
+
+    std::vector<int>& row = m_rows[y];
+    std::vector<int>::iterator it = std::lower_bound(row.begin(), row.end(), x);
+    if (it == row.end() || *it != x)
+        row.insert(it, x);
+
+    return true;
+}
+
+bool DefectRowIndex::Find(int x, int y) const
+{
+    if (y < 0 || y >= (int) m_rows.size())
+        return false;
+
+    const std::vector<int>& row = m_rows[y];
+    return std::binary_search(row.begin(), row.end(), x);
+}
+
+inline static void swap(unsigned short& a, unsigned short& b)
+{
+    unsigned short const t = a;
+    a = b;
+    b = t;
+}
+
+inline static unsigned short median8(const unsigned short l[8])
+{
+    unsigned short l0 = l[0], l1 = l[1], l2 = l[2], l3 = l[3], l4 = l[4];
+    unsigned short x;
+
+    x = l[5];
+    if (x < l0) swap(x, l0);
+    if (x < l1) swap(x, l1);
+    if (x < l2) swap(x, l2);
+    if (x < l3) swap(x, l3);
+    if (x < l4) swap(x, l4);
+    x = l[6];
+    if (x < l0) swap(x, l0);
+    if (x < l1) swap(x, l1);
+    if (x < l2) swap(x, l2);
+    if (x < l3) swap(x, l3);
+    if (x < l4) swap(x, l4);
+    x = l[7];
+    if (x < l0) swap(x, l0);
+    if (x < l1) swap(x, l1);
+    if (x < l2) swap(x, l2);
+    if (x < l3) swap(x, l3);
+    if (x < l4) swap(x, l4);
+
+    if (l2 > l0) swap(l2, l0);
+    if (l2 > l1) swap(l2, l1);
+
+    if (l3 > l0) swap(l3, l0);
+    if (l3 > l1) swap(l3, l1);
+
+    if (l4 > l0) swap(l4, l0);
+    if (l4 > l1) swap(l4, l1);
+
+    return (unsigned short)(((unsigned int) l0 + (unsigned int) l1) / 2);
+}
+
+inline static unsigned short median5(const unsigned short l[5])
+{
+    unsigned short l0 = l[0], l1 = l[1], l2 = l[2];
+    unsigned short x;
+    x = l[3];
+    if (x < l0) swap(x, l0);
+    if (x < l1) swap(x, l1);
+    if (x < l2) swap(x, l2);
+    x = l[4];
+    if (x < l0) swap(x, l0);
+    if (x < l1) swap(x, l1);
+    if (x < l2) swap(x, l2);
+
+    if (l1 > l0) l0 = l1;
+    if (l2 > l0) l0 = l2;
+
+    return l0;
+}
+
+inline static unsigned short median3(const unsigned short l[3])
+{
+    unsigned short l0 = l[0], l1 = l[1], l2 = l[2];
+    if (l2 < l0) swap(l2, l0);
+    if (l2 < l1) swap(l2, l1);
+    if (l1 > l0) l0 = l1;
+    return l0;
+}
+
+unsigned short MedianBorderingPixels(const unsigned short *img, int width, int height, int x, int y)
+{
+    unsigned short array[8];
+    int const xsize = width;
+    int const ysize = height;
+
+    if (x > 0 && y > 0 && x < xsize - 1 && y < ysize - 1)
+    {
+        array[0] = img[(x-1) + (y-1) * xsize];
+        array[1] = img[(x)   + (y-1) * xsize];
+        array[2] = img[(x+1) + (y-1) * xsize];
+        array[3] = img[(x-1) + (y)   * xsize];
+        array[4] = img[(x+1) + (y)   * xsize];
+        array[5] = img[(x-1) + (y+1) * xsize];
+        array[6] = img[(x)   + (y+1) * xsize];
+        array[7] = img[(x+1) + (y+1) * xsize];
+        return median8(array);
+    }
+
+    if (x == 0 && y > 0 && y < ysize - 1)
+    {
+        // On left edge
+        array[0] = img[(x)     + (y - 1) * xsize];
+        array[1] = img[(x)     + (y + 1) * xsize];
+        array[2] = img[(x + 1) + (y - 1) * xsize];
+        array[3] = img[(x + 1) + (y)     * xsize];
+        array[4] = img[(x + 1) + (y + 1) * xsize];
+        return median5(array);
+    }
+
+    if (x == xsize - 1 && y > 0 && y < ysize - 1)
+    {
+        // On right edge
+        array[0] = img[(x)     + (y - 1) * xsize];
+        array[1] = img[(x)     + (y + 1) * xsize];
+        array[2] = img[(x - 1) + (y - 1) * xsize];
+        array[3] = img[(x - 1) + (y)     * xsize];
+        array[4] = img[(x - 1) + (y + 1) * xsize];
+        return median5(array);
+    }
+
+    if (y == 0 && x > 0 && x < xsize - 1)
+    {
+        // On bottom edge
+        array[0] = img[(x - 1) + (y)     * xsize];
+        array[1] = img[(x - 1) + (y + 1) * xsize];
+        array[2] = img[(x)     + (y + 1) * xsize];
+        array[3] = img[(x + 1) + (y)     * xsize];
+        array[4] = img[(x + 1) + (y + 1) * xsize];
+        return median5(array);
+    }
+
+    if (y == ysize - 1 && x > 0 && x < xsize - 1)
+    {
+        // On top edge
+        array[0] = img[(x - 1) + (y)     * xsize];
+        array[1] = img[(x - 1) + (y - 1) * xsize];
+        array[2] = img[(x)     + (y - 1) * xsize];
+        array[3] = img[(x + 1) + (y)     * xsize];
+        array[4] = img[(x + 1) + (y - 1) * xsize];
+        return median5(array);
+    }
+
+    if (x == 0 && y == 0)
+    {
+        // At lower left corner
+        array[0] = img[(x + 1) + (y)     * xsize];
+        array[1] = img[(x)     + (y + 1) * xsize];
+        array[2] = img[(x + 1) + (y + 1) * xsize];
+    }
+    else if (x == 0 && y == ysize - 1)
+    {
+        // At upper left corner
+        array[0] = img[(x + 1) + (y)     * xsize];
+        array[1] = img[(x)     + (y - 1) * xsize];
+        array[2] = img[(x + 1) + (y - 1) * xsize];
+    }
+    else if (x == xsize - 1 && y == ysize - 1)
+    {
+        // At upper right corner
+        array[0] = img[(x - 1) + (y)     * xsize];
+        array[1] = img[(x)     + (y - 1) * xsize];
+        array[2] = img[(x - 1) + (y - 1) * xsize];
+    }
+    else if (x == xsize - 1 && y == 0)
+    {
+        // At lower right corner
+        array[0] = img[(x - 1) + (y)     * xsize];
+        array[1] = img[(x)     + (y + 1) * xsize];
+        array[2] = img[(x - 1) + (y + 1) * xsize];
+    }
+    else
+    {
+        // unreachable
+        return 0;
+    }
+
+    return median3(array);
+}
+
+inline static void sort2(unsigned short& a, unsigned short& b)
+{
+    unsigned short const t = std::min(a, b);
+    b = std::max(a, b);
+    a = t;
+}
+
+// Replace the defects at x[0..n) in row y, all away from the frame edges, with the
+// median of their 8 neighbors (the same value median8 gives). The neighbors of
+// the whole row are gathered before anything is written, so the result does not
+// depend on the order of the defects within the row; the medians are computed
+// with a branch-free sorting network over the batch.
+static void RemoveInteriorRowDefects(unsigned short *img, int w, int y, const int *x, int n)
+{
+    static thread_local std::vector<unsigned short> s_buf;
+    if (s_buf.size() < 9 * (size_t) n)
+        s_buf.resize(9 * (size_t) n);
+
+    unsigned short *nb[8];
+    for (int k = 0; k < 8; k++)
+        nb[k] = &s_buf[k * n];
+    unsigned short *const med = &s_buf[8 * n];
+
+    const unsigned short *const r0 = img + (y - 1) * w;
+    const unsigned short *const r1 = r0 + w;
+    const unsigned short *const r2 = r1 + w;
+
+    for (int i = 0; i < n; i++)
+    {
+        int const xi = x[i];
+        nb[0][i] = r0[xi - 1]; nb[1][i] = r0[xi]; nb[2][i] = r0[xi + 1];
+        nb[3][i] = r1[xi - 1];                    nb[4][i] = r1[xi + 1];
+        nb[5][i] = r2[xi - 1]; nb[6][i] = r2[xi]; nb[7][i] = r2[xi + 1];
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        unsigned short p0 = nb[0][i], p1 = nb[1][i], p2 = nb[2][i], p3 = nb[3][i];
+        unsigned short p4 = nb[4][i], p5 = nb[5][i], p6 = nb[6][i], p7 = nb[7][i];
+
+        // Batcher odd-even merge sort, 19 comparators
+        sort2(p0, p2); sort2(p1, p3); sort2(p4, p6); sort2(p5, p7);
+        sort2(p0, p4); sort2(p1, p5); sort2(p2, p6); sort2(p3, p7);
+        sort2(p0, p1); sort2(p2, p3); sort2(p4, p5); sort2(p6, p7);
+        sort2(p2, p4); sort2(p3, p5);
+        sort2(p1, p4); sort2(p3, p6);
+        sort2(p1, p2); sort2(p3, p4); sort2(p5, p6);
+
+        med[i] = (unsigned short)(((unsigned int) p3 + (unsigned int) p4) / 2);
+    }
+
+    unsigned short *const dst = img + y * w;
+    for (int i = 0; i < n; i++)
+        dst[x[i]] = med[i];
+}
+
+void RemoveDefectRow(unsigned short *img, int width, int height, const DefectRowIndex& defects, int y, int left, int right)
+{
+    if (y >= defects.RowCount())
+        return;
+
+    const std::vector<int>& row = defects.Row(y);
+    if (row.empty())
+        return;
+
+    int const w = width;
+    int const h = height;
+
+    const int *p0 = row.data() + (std::lower_bound(row.begin(), row.end(), left) - row.begin());
+    const int *p1 = row.data() + (std::upper_bound(row.begin(), row.end(), right) - row.begin());
+    if (p1 <= p0)
+        return;
+
+    if (y == 0 || y == h - 1)
+    {
+        // Replace the light value with the median of the surrounding pixels
+        for (const int *p = p0; p < p1; p++)
+            img[*p + y * w] = MedianBorderingPixels(img, w, h, *p, y);
+        return;
+    }
+
+    // the first and last columns have fewer neighbors
+    if (*p0 == 0)
+    {
+        img[y * w] = MedianBorderingPixels(img, w, h, 0, y);
+        ++p0;
+    }
+    bool const lastCol = p1 > p0 && p1[-1] == w - 1;
+    if (lastCol)
+        --p1;
+
+    if (p1 > p0)
+        RemoveInteriorRowDefects(img, w, y, p0, (int)(p1 - p0));
+
+    if (lastCol)
+        img[w - 1 + y * w] = MedianBorderingPixels(img, w, h, w - 1, y);
+}
+
+void SubtractDarkRow(unsigned short *pl, const unsigned short *pd, unsigned int width, int pedestal)
+{
+    unsigned short *const endl = pl + width;
+    for (; pl < endl; pl++, pd++)
+    {
+        int newval = (int) *pl + pedestal - (int) *pd;
+        if (newval < 0) newval = 0; // hot pixel in dark frame isn't present in light frame
+        else if (newval > 65535) newval = 65535;
+        *pl = (unsigned short) newval;
+    }
+}
+
+void Mean2x2Rows(unsigned short *dst, const unsigned short *src, int frameWidth, const FrameRect& rect, int y0, int y1)
+{
+    int const W = frameWidth;
+    int const RX = rect.x;
+    int const RY = rect.y;
+    int const RW = rect.width;
+    int const RH = rect.height;
+    const ImageKernels& kernels = GetImageKernels();
+
+#define IX(x_, y_) ((RY + (y_)) * W + RX + (x_))
+
+    for (int y = y0; y < y1; y++)
+    {
+        unsigned short *d = &dst[IX(0, y)];
+        if (y <= RH - 2)
+        {
+            kernels.mean2x2Row(d, &src[IX(0, y)], &src[IX(0, y + 1)], RW - 1);
+            d += RW - 1;
+
+            // last col
+            *d = (unsigned short)(((unsigned int) src[IX(RW - 1, y)] + src[IX(RW - 1, y + 1)]) >> 1);
+        }
+        else
+        {
+            // last row
+            for (int x = 0; x <= RW - 2; x++)
+                *d++ = (unsigned short)(((unsigned int) src[IX(x, y)] + src[IX(x + 1, y)]) >> 1);
+
+            // bottom-right pixel
+            *d = src[IX(RW - 1, y)];
+        }
+    }
+
+#undef IX
+}
+
+// Each stage runs a couple of rows behind the one before it, so a row is
+// corrected, filtered and measured while it is still in cache instead of the
+// whole frame being read and written once per stage.
+void PreprocessFrame(unsigned short *img, unsigned short *filtered, int frameWidth, int frameHeight, const FrameRect& rect,
+    const unsigned short *dark, int pedestal, const DefectRowIndex *defects, PreprocessNoiseReduction noiseReduction, FrameStats *stats)
+{
+    int const W = frameWidth;
+    int const RX = rect.x;
+    int const RY = rect.y;
+    int const RW = rect.width;
+    int const RH = rect.height;
+
+    FrameStatsScan scan;
+
+#define IX(x_, y_) ((RY + (y_)) * W + RX + (x_))
+
+    // row k is corrected, row k - 1 filtered (it needs the corrected row below it)
+    // and row k - 2 measured (it needs the filtered row below it)
+    for (int k = 0; k < RH + 2; k++)
+    {
+        if (k < RH)
+        {
+            if (dark)
+                SubtractDarkRow(&img[IX(0, k)], &dark[IX(0, k)], RW, pedestal);
+            else if (defects)
+                RemoveDefectRow(img, W, frameHeight, *defects, RY + k, RX, RX + RW - 1);
+        }
+
+        int const y = k - 1;
+        if (y >= 0 && y < RH)
+        {
+            switch (noiseReduction)
+            {
+            case PREPROCESS_NR_NONE:
+                break;
+            case PREPROCESS_NR_2x2MEAN:
+                Mean2x2Rows(filtered, img, W, rect, y, y + 1);
+                break;
+            case PREPROCESS_NR_3x3MEDIAN:
+                Median3Rows(filtered, img, W, rect, y, y + 1);
+                break;
+            }
+        }
+
+        if (k >= 2)
+            scan.AddRows(filtered, W, rect, k - 2, k - 1);
+    }
+
+#undef IX
+
+    scan.Finish(stats, rect);
+}
@@ -0,0 +1,106 @@
+/*
+ *  image_preprocess.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef IMAGE_PREPROCESS_INCLUDED
+#define IMAGE_PREPROCESS_INCLUDED
+
+#include "median3.h"
+
+#include <vector>
+
+//
+// Dark subtraction, bad pixel correction and noise reduction on raw frame data.
+// There are no wxWidgets types here; image_math.h has the usImage and DefectMap
+// versions used by the rest of PHD2.
+//
+
+// Bad pixel locations indexed by row: each row holds the sorted, distinct x
+// coordinates of its defects.
+class DefectRowIndex
+{
+    std::vector<std::vector<int>> m_rows;
+
+public:
+    // rows beyond this are not indexed; no sensor is that tall
+    enum { MAX_ROWS = 65536 };
+
+    // returns false if y is outside the index
+    bool Add(int x, int y);
+    bool Find(int x, int y) const;
+    void Clear() { m_rows.clear(); }
+
+    // number of indexed rows, and the sorted x coordinates of the defects in row y
+    int RowCount() const { return (int) m_rows.size(); }
+    const std::vector<int>& Row(int y) const { return m_rows[y]; }
+};
+
+// median of the pixels bordering (x, y): 8 inside the frame, 5 on an edge, 3 in a corner
+extern unsigned short MedianBorderingPixels(const unsigned short *img, int width, int height, int x, int y);
+
+// Replace the defects of row y that lie in columns [left, right] with the median
+// of their bordering pixels, in place. Rows are corrected top to bottom, so a
+// defect sees the corrected values of defects in the row above and the raw
+// values of those in the row below. In the first and last rows the defects are
+// replaced one at a time from left to right. In the other rows a defect in the
+// first column is replaced first, then all the interior defects at once from
+// the row as it stands at that point, then a defect in the last column.
+extern void RemoveDefectRow(unsigned short *img, int width, int height, const DefectRowIndex& defects, int y, int left, int right);
+
+// pl[i] = pl[i] + pedestal - pd[i], clipped to 0..65535
+extern void SubtractDarkRow(unsigned short *pl, const unsigned short *pd, unsigned int width, int pedestal);
+
+// The 2x2 mean of QuickLRecon for rows [y0, y1) of rect (relative to the top of
+// rect), into the same pixels of dst. Each row is averaged with the one below
+// it; the last column and the last row of rect average two pixels, and the
+// bottom-right pixel is copied.
+extern void Mean2x2Rows(unsigned short *dst, const unsigned short *src, int frameWidth, const FrameRect& rect, int y0, int y1);
+
+// the noise reduction methods, in the same order as NOISE_REDUCTION_METHOD
+enum PreprocessNoiseReduction
+{
+    PREPROCESS_NR_NONE,
+    PREPROCESS_NR_2x2MEAN,
+    PREPROCESS_NR_3x3MEDIAN,
+};
+
+// Dark subtraction with the given pedestal (or defect correction), noise
+// reduction and the frame statistics in a single pass over rect. Pass a null
+// dark and defects to skip the correction. The noise reduction writes rect of
+// filtered; with PREPROCESS_NR_NONE filtered must be img. The result is the
+// same as the separate passes: SubtractDarkRow or RemoveDefectRow over rect,
+// then Mean2x2Rows or Median3Rows, then CalcFrameStats of filtered.
+extern void PreprocessFrame(unsigned short *img, unsigned short *filtered, int frameWidth, int frameHeight, const FrameRect& rect,
+    const unsigned short *dark, int pedestal, const DefectRowIndex *defects, PreprocessNoiseReduction noiseReduction, FrameStats *stats);
+
+#endif // IMAGE_PREPROCESS_INCLUDED
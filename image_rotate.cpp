@@ -0,0 +1,178 @@
+/*
+ *  image_rotate.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "image_rotate.h"
+
+#include <algorithm>
+#include <cmath>
+
+void GetRotateGeometry(RotateGeometry *g, int w, int h, double theta)
+{
+    const double HALF_PI = 1.57079632679489661923;
+
+    double const q = theta / HALF_PI;
+    double const nq = floor(q + 0.5);
+
+    if (fabs(q - nq) < 1e-9)
+    {
+        int const quarter = (((int) fmod(nq, 4.)) + 4) % 4;
+        static const int cs[4][2] = { { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 } };
+
+        g->quarter = quarter;
+        g->c = cs[quarter][0];
+        g->s = cs[quarter][1];
+        g->x0 = quarter == 1 ? -(h - 1) : quarter == 2 ? -(w - 1) : 0;
+        g->y0 = quarter == 2 ? -(h - 1) : quarter == 3 ? -(w - 1) : 0;
+        g->width = quarter & 1 ? h : w;
+        g->height = quarter & 1 ? w : h;
+        return;
+    }
+
+    double const c = cos(theta);
+    double const s = sin(theta);
+
+    // bounding box of the rotated pixel centers
+    double const cx[4] = { 0., (double) (w - 1), 0., (double) (w - 1) };
+    double const cy[4] = { 0., 0., (double) (h - 1), (double) (h - 1) };
+    double xmin = 1e30, xmax = -1e30, ymin = 1e30, ymax = -1e30;
+    for (int i = 0; i < 4; i++)
+    {
+        double const x = cx[i] * c - cy[i] * s;
+        double const y = cy[i] * c + cx[i] * s;
+        xmin = std::min(xmin, x);
+        xmax = std::max(xmax, x);
+        ymin = std::min(ymin, y);
+        ymax = std::max(ymax, y);
+    }
+
+    g->quarter = -1;
+    g->c = c;
+    g->s = s;
+    g->x0 = (int) floor(xmin + 1e-6);
+    g->y0 = (int) floor(ymin + 1e-6);
+    g->width = (int) ceil(xmax - 1e-6) - g->x0 + 1;
+    g->height = (int) ceil(ymax - 1e-6) - g->y0 + 1;
+}
+
+void MirrorRows(unsigned short *p, int w, int h)
+{
+    for (int y = 0; y < h / 2; y++)
+        std::swap_ranges(p + y * w, p + (y + 1) * w, p + (h - 1 - y) * w);
+}
+
+// Rotate by quarter * 90 degrees (quarter is 1 or 3). The copy goes in square
+// tiles so that the column-wise side stays in cache.
+static void RotateQuarter(unsigned short *dst, const unsigned short *src, int w, int h, int quarter,
+                          int r0, int r1)
+{
+    enum { TILE = 64 };
+
+    // the destination is h wide and w high
+    for (int ty = r0; ty < r1; ty += TILE)
+    {
+        int const yend = std::min(ty + (int) TILE, r1);
+        for (int tx = 0; tx < h; tx += TILE)
+        {
+            int const xend = std::min(tx + (int) TILE, h);
+            for (int y = ty; y < yend; y++)
+            {
+                unsigned short *d = dst + y * h;
+                if (quarter == 1)
+                {
+                    // dst(x, y) = src(y, h - 1 - x)
+                    for (int x = tx; x < xend; x++)
+                        d[x] = src[(h - 1 - x) * w + y];
+                }
+                else
+                {
+                    // dst(x, y) = src(w - 1 - y, x)
+                    for (int x = tx; x < xend; x++)
+                        d[x] = src[x * w + (w - 1 - y)];
+                }
+            }
+        }
+    }
+}
+
+// Rotate by an arbitrary angle with bilinear interpolation. Destination pixel
+// (x, y) is the point (x + x0, y + y0) of the rotated frame; it is mapped back
+// into the source and sampled there, or set to 0 if it falls outside.
+static void RotateBilinear(unsigned short *dst, const unsigned short *src, int w, int h,
+                           const RotateGeometry& g, int r0, int r1)
+{
+    const double eps = 1e-6;
+    const double xmax = w - 1;
+    const double ymax = h - 1;
+    int const dw = g.width;
+
+    for (int y = r0; y < r1; y++)
+    {
+        unsigned short *d = dst + y * dw;
+        double const py = y + g.y0;
+
+        for (int x = 0; x < dw; x++)
+        {
+            double const px = x + g.x0;
+            double sx = px * g.c + py * g.s;
+            double sy = py * g.c - px * g.s;
+
+            if (sx < -eps || sx > xmax + eps || sy < -eps || sy > ymax + eps)
+            {
+                d[x] = 0;
+                continue;
+            }
+
+            sx = std::max(0.0, std::min(sx, xmax));
+            sy = std::max(0.0, std::min(sy, ymax));
+            int const ix = std::min((int) sx, w - 2);
+            int const iy = std::min((int) sy, h - 2);
+            double const fx = sx - ix;
+            double const fy = sy - iy;
+
+            const unsigned short *p = src + iy * w + ix;
+            double const top = p[0] + fx * (p[1] - p[0]);
+            double const bot = p[w] + fx * (p[w + 1] - p[w]);
+            d[x] = (unsigned short) (top + fy * (bot - top) + 0.5);
+        }
+    }
+}
+
+void RotateRows(unsigned short *dst, const unsigned short *src, int w, int h,
+                const RotateGeometry& g, int r0, int r1)
+{
+    if (g.quarter == 1 || g.quarter == 3)
+        RotateQuarter(dst, src, w, h, g.quarter, r0, r1);
+    else
+        RotateBilinear(dst, src, w, h, g, r0, r1);
+}
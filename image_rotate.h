@@ -0,0 +1,69 @@
+/*
+ *  image_rotate.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef IMAGE_ROTATE_INCLUDED
+#define IMAGE_ROTATE_INCLUDED
+
+//
+// Rotation and mirroring of 16-bit frames, used by usImage::Rotate.
+//
+// A w x h frame rotated by theta radians about its origin becomes the bounding
+// box of its rotated pixel centers: source point (x, y) lands on
+// (x cos - y sin - x0, y cos + x sin - y0). Quarter turns move pixels exactly;
+// other angles are sampled with bilinear interpolation. The row functions have no
+// threading of their own so the caller can split the rows between threads.
+//
+
+struct RotateGeometry
+{
+    int quarter;    // 0-3 for a multiple of 90 degrees, -1 for any other angle
+    double c;       // cos(theta)
+    double s;       // sin(theta)
+    int x0;         // offset of the rotated frame in the rotated plane
+    int y0;
+    int width;      // size of the rotated frame
+    int height;
+};
+
+extern void GetRotateGeometry(RotateGeometry *g, int w, int h, double theta);
+
+// flip the image top to bottom
+extern void MirrorRows(unsigned short *p, int w, int h);
+
+// Fill rows [r0, r1) of the rotated frame dst from the w x h frame src. Not
+// used for quarter 0 (nothing to do) or quarter 2 (reverse the pixels in place).
+extern void RotateRows(unsigned short *dst, const unsigned short *src, int w, int h,
+                       const RotateGeometry& g, int r0, int r1);
+
+#endif // IMAGE_ROTATE_INCLUDED
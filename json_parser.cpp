@@ -54,7 +54,6 @@
  *  THE SOFTWARE.
  */
 
-#include "phd.h"
 #include "json_parser.h"
 
 #include <algorithm>
@@ -71,6 +70,7 @@ private:
     };
 
     block *m_head;
+    block *m_spare;     // blocks released by reset(), reused before allocating more
     size_t m_blocksize;
 
     block_allocator(const block_allocator &);
@@ -79,6 +79,8 @@ private:
     // exchange contents with rhs
     void swap(block_allocator &rhs);
 
+    static void free_list(block *b);
+
 public:
     block_allocator(size_t blocksize);
     ~block_allocator();
@@ -86,40 +88,44 @@ public:
     // allocate memory
     void *malloc(size_t size);
 
-    // reset to empty state, keeping one allocated block
+    // reset to empty state, keeping the allocated blocks for reuse
     void reset();
 
     // free all allocated blocks
     void free();
 };
 
-block_allocator::block_allocator(size_t blocksize): m_head(0), m_blocksize(blocksize)
+block_allocator::block_allocator(size_t blocksize): m_head(0), m_spare(0), m_blocksize(blocksize)
 {
 }
 
-block_allocator::~block_allocator()
+void block_allocator::free_list(block *b)
 {
-    while (m_head)
+    while (b)
     {
-        block *temp = m_head->next;
-        ::free(m_head);
-        m_head = temp;
+        block *t = b->next;
+        ::free(b);
+        b = t;
     }
 }
 
+block_allocator::~block_allocator()
+{
+    free_list(m_head);
+    free_list(m_spare);
+}
+
 void block_allocator::reset()
 {
-    if (m_head)
+    // move every block to the spare list; the next parse reuses them, so a
+    // server parsing a stream of similar requests stops allocating
+    while (m_head)
     {
-        block *b = m_head->next;
-        m_head->next = 0;
-        while (b)
-        {
-            block *t = b->next;
-            ::free(b);
-            b = t;
-        }
-        m_head->used = sizeof(block);
+        block *b = m_head;
+        m_head = b->next;
+        b->used = sizeof(block);
+        b->next = m_spare;
+        m_spare = b;
     }
 }
 
@@ -127,19 +133,31 @@ void block_allocator::swap(block_allocator& rhs)
 {
     std::swap(m_blocksize, rhs.m_blocksize);
     std::swap(m_head, rhs.m_head);
+    std::swap(m_spare, rhs.m_spare);
 }
 
 void *block_allocator::malloc(size_t size)
 {
     if (!m_head || m_head->used + size > m_head->size)
     {
-        // calc needed size for allocation
-        size_t alloc_size = std::max(sizeof(block) + size, m_blocksize);
+        block *b;
+
+        if (m_spare && sizeof(block) + size <= m_spare->size)
+        {
+            b = m_spare;
+            m_spare = b->next;
+        }
+        else
+        {
+            // calc needed size for allocation
+            size_t alloc_size = std::max(sizeof(block) + size, m_blocksize);
+
+            // create new block
+            b = (block *)::malloc(alloc_size);
+            b->size = alloc_size;
+            b->used = sizeof(block);
+        }
 
-        // create new block
-        block *b = (block *)::malloc(alloc_size);
-        b->size = alloc_size;
-        b->used = sizeof(block);
         b->next = m_head;
         m_head = b;
     }
@@ -601,7 +619,7 @@ static json_value *json_parse(char *source, const char **error_pos,
                 object->type = JSON_INT;
 
                 char *first = it;
-                while (*it != '\x20' && *it != '\x9' && *it != '\xD' && *it != '\xA' && *it != ',' && *it != ']' && *it != '}')
+                while (*it && *it != '\x20' && *it != '\x9' && *it != '\xD' && *it != '\xA' && *it != ',' && *it != ']' && *it != '}')
                 {
                     if (*it == '.' || *it == 'e' || *it == 'E')
                     {
@@ -654,6 +672,7 @@ struct JsonParserImpl
 {
     block_allocator alloc;
     void *tmpbuf;
+    size_t tmpbufsize;
 
     json_value *root;
 
@@ -661,7 +680,7 @@ struct JsonParserImpl
     const char *error_desc;
     int error_line;
 
-    JsonParserImpl() : alloc(4096), tmpbuf(nullptr) { }
+    JsonParserImpl() : alloc(4096), tmpbuf(nullptr), tmpbufsize(0) { }
     ~JsonParserImpl() { if (tmpbuf) ::free(tmpbuf); }
 };
 
@@ -684,9 +703,14 @@ bool JsonParser::Parse(char *str)
 
 bool JsonParser::Parse(const std::string& str)
 {
-    if (m_impl->tmpbuf)
-        ::free(m_impl->tmpbuf);
-    m_impl->tmpbuf = ::malloc(str.length() + 1);
+    // the copy buffer is kept and only grows, like the node allocator
+    if (str.length() + 1 > m_impl->tmpbufsize)
+    {
+        if (m_impl->tmpbuf)
+            ::free(m_impl->tmpbuf);
+        m_impl->tmpbufsize = str.length() + 1;
+        m_impl->tmpbuf = ::malloc(m_impl->tmpbufsize);
+    }
     memcpy(m_impl->tmpbuf, str.c_str(), str.length() + 1);
     return Parse(static_cast<char *>(m_impl->tmpbuf));
 }
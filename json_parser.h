@@ -57,6 +57,8 @@
 #ifndef JSON_PARSER_H
 #define JSON_PARSER_H
 
+#include <string>
+
 enum json_type
 {
     JSON_NULL,
@@ -0,0 +1,216 @@
+/*
+ *  json_writer.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "json_writer.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+inline static bool json_needs_escape(char c)
+{
+    return c == '\\' || c == '"' || c == '\r' || c == '\n';
+}
+
+inline static void json_put_escaped(std::string& s, char c)
+{
+    switch (c) {
+    case '\\': s.append("\\\\", 2); break;
+    case '"':  s.append("\\\"", 2); break;
+    case '\r': s.append("\\r", 2); break;
+    case '\n': s.append("\\n", 2); break;
+    default:   s += c; break;
+    }
+}
+
+void json_put_string(std::string& s, const char *p, size_t len)
+{
+    s += '"';
+    const char *const end = p + len;
+    while (p < end)
+    {
+        const char *q = p;
+        while (q < end && !json_needs_escape(*q))
+            ++q;
+        s.append(p, q - p);
+        if (q == end)
+            break;
+        json_put_escaped(s, *q);
+        p = q + 1;
+    }
+    s += '"';
+}
+
+inline static void json_put_utf8(std::string& s, unsigned int cp)
+{
+    if (cp < 0x800)
+    {
+        s += (char) (0xC0 | (cp >> 6));
+    }
+    else
+    {
+        if (cp < 0x10000)
+            s += (char) (0xE0 | (cp >> 12));
+        else
+        {
+            s += (char) (0xF0 | (cp >> 18));
+            s += (char) (0x80 | ((cp >> 12) & 0x3F));
+        }
+        s += (char) (0x80 | ((cp >> 6) & 0x3F));
+    }
+    s += (char) (0x80 | (cp & 0x3F));
+}
+
+void json_put_string(std::string& s, const wchar_t *p, size_t len)
+{
+    s += '"';
+    unsigned int hi = 0; // pending high surrogate when wchar_t is UTF-16
+    for (const wchar_t *const end = p + len; p < end; ++p)
+    {
+        unsigned int cp = (unsigned int) *p;
+        if (cp < 0x80 && !hi)
+        {
+            if (json_needs_escape((char) cp))
+                json_put_escaped(s, (char) cp);
+            else
+                s += (char) cp;
+            continue;
+        }
+        if (cp >= 0xD800 && cp < 0xDC00)
+        {
+            hi = cp;
+            continue;
+        }
+        if (hi)
+        {
+            if (cp >= 0xDC00 && cp < 0xE000)
+                cp = 0x10000 + ((hi - 0xD800) << 10) + (cp - 0xDC00);
+            hi = 0;
+            if (cp < 0x80)
+            {
+                json_put_escaped(s, (char) cp);
+                continue;
+            }
+        }
+        json_put_utf8(s, cp);
+    }
+    s += '"';
+}
+
+void json_put_int(std::string& s, int i)
+{
+    char buf[12];
+    char *const end = buf + sizeof(buf);
+    char *p = end;
+    unsigned int u = i < 0 ? 0u - (unsigned int) i : (unsigned int) i;
+    do {
+        *--p = (char) ('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (i < 0)
+        *--p = '-';
+    s.append(p, end - p);
+}
+
+// printf-style formatting for floating point values, into a stack buffer in
+// the common case
+void json_put_format(std::string& s, const char *fmt, ...)
+{
+    char buf[32];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n < 0)
+        return;
+    if ((size_t) n < sizeof(buf))
+    {
+        s.append(buf, n);
+        return;
+    }
+    size_t const pos = s.size();
+    s.resize(pos + n + 1);
+    va_start(ap, fmt);
+    vsnprintf(&s[pos], n + 1, fmt, ap);
+    va_end(ap);
+    s.resize(pos + n);
+}
+
+void json_put(std::string& s, const json_value *j)
+{
+    if (!j)
+    {
+        s += literal_null;
+        return;
+    }
+
+    switch (j->type) {
+    default:
+    case JSON_NULL: s += literal_null; break;
+    case JSON_OBJECT: {
+        s += '{';
+        bool first = true;
+        json_for_each (jj, j)
+        {
+            if (first)
+                first = false;
+            else
+                s += ',';
+            s += '"';
+            s += jj->name;
+            s += "\":";
+            json_put(s, jj);
+        }
+        s += '}';
+        break;
+    }
+    case JSON_ARRAY: {
+        s += '[';
+        bool first = true;
+        json_for_each (jj, j)
+        {
+            if (first)
+                first = false;
+            else
+                s += ',';
+            json_put(s, jj);
+        }
+        s += ']';
+        break;
+    }
+    case JSON_STRING: json_put_string(s, j->string_value, strlen(j->string_value)); break;
+    case JSON_INT:    json_put_int(s, j->int_value); break;
+    case JSON_FLOAT:  json_put_double(s, (double) j->float_value); break;
+    case JSON_BOOL:   s += j->int_value ? literal_true : literal_false; break;
+    }
+}
@@ -0,0 +1,257 @@
+/*
+ *  json_writer.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef JSON_WRITER_INCLUDED
+#define JSON_WRITER_INCLUDED
+
+#include "json_parser.h"
+
+#include <sstream>
+#include <string>
+#include <string.h>
+#include <vector>
+#include <wchar.h>
+
+class PHD_Point;
+class wxPoint;
+class wxSize;
+class wxString;
+
+//
+// JSON text for the event server is written directly as UTF-8 into std::string
+// byte buffers. Nothing here goes through wxString formatting, so building a
+// message costs at most a buffer allocation rather than a temporary string for
+// every field. The NV constructors taking wxWidgets types are defined in
+// event_server.cpp.
+//
+
+static const char literal_null[] = "null";
+static const char literal_true[] = "true";
+static const char literal_false[] = "false";
+
+extern void json_put_string(std::string& s, const char *p, size_t len);
+// wide text, UTF-16 or UTF-32 depending on the size of wchar_t
+extern void json_put_string(std::string& s, const wchar_t *p, size_t len);
+extern void json_put_int(std::string& s, int i);
+extern void json_put_format(std::string& s, const char *fmt, ...);
+extern void json_put(std::string& s, const json_value *j);
+
+inline void json_put_double(std::string& s, double d)
+{
+    json_put_format(s, "%g", d);
+}
+
+inline void json_put_fixed(std::string& s, double d, int prec)
+{
+    json_put_format(s, "%.*f", prec, d);
+}
+
+// Recycled message buffers. A JSON sequence takes its buffer from here and
+// gives it back when it is destroyed, so once the buffers have grown to the
+// typical message size building an event does not touch the heap at all.
+struct JBufCache
+{
+    enum { MAX_BUFS = 8, MAX_KEEP = 64 * 1024, INITIAL_SIZE = 512 };
+    std::vector<std::string> bufs;
+
+    void get(std::string *s)
+    {
+        if (bufs.empty())
+            s->reserve(INITIAL_SIZE);
+        else
+        {
+            s->swap(bufs.back());
+            bufs.pop_back();
+        }
+    }
+    void put(std::string *s)
+    {
+        if (bufs.size() < MAX_BUFS && s->capacity() <= MAX_KEEP)
+        {
+            s->clear();
+            bufs.push_back(std::string());
+            bufs.back().swap(*s);
+        }
+    }
+    static JBufCache& instance()
+    {
+        static thread_local JBufCache s_cache;
+        return s_cache;
+    }
+};
+
+template<char LDELIM, char RDELIM>
+struct JSeq
+{
+    mutable std::string m_s;
+    bool m_first;
+    mutable bool m_closed;
+    mutable bool m_eol;
+    JSeq() : m_first(true), m_closed(false), m_eol(false) { JBufCache::instance().get(&m_s); m_s += LDELIM; }
+    JSeq(const JSeq& other) : m_first(other.m_first), m_closed(other.m_closed), m_eol(false)
+    {
+        JBufCache::instance().get(&m_s);
+        const std::string& s = other.m_s;
+        m_s.append(s, 0, other.m_eol ? s.size() - 2 : s.size());
+    }
+    ~JSeq() { JBufCache::instance().put(&m_s); }
+    void sep() { if (m_first) m_first = false; else m_s += ','; }
+    void close() const { m_s += RDELIM; m_closed = true; }
+    // the complete JSON text
+    const std::string& str() const
+    {
+        if (!m_closed)
+            close();
+        if (m_eol)
+        {
+            m_s.resize(m_s.size() - 2);
+            m_eol = false;
+        }
+        return m_s;
+    }
+    // the complete JSON text followed by the message terminator
+    const std::string& line() const
+    {
+        str();
+        m_s.append("\r\n", 2);
+        m_eol = true;
+        return m_s;
+    }
+private:
+    JSeq& operator=(const JSeq&);
+};
+
+typedef JSeq<'[', ']'> JAry;
+typedef JSeq<'{', '}'> JObj;
+
+inline JAry& operator<<(JAry& a, double d)
+{
+    a.sep();
+    json_put_fixed(a.m_s, d, 2);
+    return a;
+}
+
+inline JAry& operator<<(JAry& a, int i)
+{
+    a.sep();
+    json_put_int(a.m_s, i);
+    return a;
+}
+
+struct NULL_TYPE { };
+static const NULL_TYPE NULL_VALUE = NULL_TYPE();
+
+// name-value pair. Numbers and booleans are kept as-is and formatted straight
+// into the enclosing object; strings and nested values are rendered into v
+// when the pair is constructed.
+struct NV
+{
+    enum Kind { TEXT, INT, DOUBLE, FIXED, BOOL };
+
+    const char *n;
+    Kind kind;
+    union
+    {
+        int i;
+        double d;
+        bool b;
+    };
+    int prec = 0;
+    std::string v;
+
+    NV(const char *n_, const wxString& v_);
+    NV(const char *n_, const std::string& v_) : n(n_), kind(TEXT) { json_put_string(v, v_.data(), v_.size()); }
+    NV(const char *n_, const char *v_) : n(n_), kind(TEXT) { json_put_string(v, v_, strlen(v_)); }
+    NV(const char *n_, const wchar_t *v_) : n(n_), kind(TEXT) { json_put_string(v, v_, wcslen(v_)); }
+    NV(const char *n_, int v_) : n(n_), kind(INT), i(v_) { }
+    NV(const char *n_, double v_) : n(n_), kind(DOUBLE), d(v_) { }
+    NV(const char *n_, double v_, int prec_) : n(n_), kind(FIXED), d(v_), prec(prec_) { }
+    NV(const char *n_, bool v_) : n(n_), kind(BOOL), b(v_) { }
+    template<typename T>
+    NV(const char *n_, const std::vector<T>& vec);
+    NV(const char *n_, JAry& ary) : n(n_), kind(TEXT), v(ary.str()) { }
+    NV(const char *n_, JObj& obj) : n(n_), kind(TEXT), v(obj.str()) { }
+    NV(const char *n_, const json_value *v_) : n(n_), kind(TEXT) { json_put(v, v_); }
+    NV(const char *n_, const PHD_Point& p);
+    NV(const char *n_, const wxPoint& p);
+    NV(const char *n_, const wxSize& s);
+    NV(const char *n_, const NULL_TYPE&) : n(n_), kind(TEXT), v(literal_null) { }
+
+    void put_value(std::string& s) const
+    {
+        switch (kind) {
+        case TEXT:   s += v; break;
+        case INT:    json_put_int(s, i); break;
+        case DOUBLE: json_put_double(s, d); break;
+        case FIXED:  json_put_fixed(s, d, prec); break;
+        case BOOL:   s += b ? literal_true : literal_false; break;
+        }
+    }
+};
+
+template<typename T>
+NV::NV(const char *n_, const std::vector<T>& vec)
+    : n(n_), kind(TEXT)
+{
+    std::ostringstream os;
+    os << '[';
+    for (unsigned int i = 0; i < vec.size(); i++)
+    {
+        if (i != 0)
+            os << ',';
+        os << vec[i];
+    }
+    os << ']';
+    v = os.str();
+}
+
+inline JObj& operator<<(JObj& j, const NV& nv)
+{
+    j.sep();
+    std::string& s = j.m_s;
+    s += '"';
+    s += nv.n;
+    s.append("\":", 2);
+    nv.put_value(s);
+    return j;
+}
+
+inline JAry& operator<<(JAry& a, JObj& j)
+{
+    a.sep();
+    a.m_s += j.str();
+    return a;
+}
+
+#endif // JSON_WRITER_INCLUDED
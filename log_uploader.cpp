@@ -151,6 +151,11 @@ static wxString GuideLogName(const Session& session)
     return "PHD2_GuideLog_" + session.timestamp + ".txt";
 }
 
+static wxString TraceLogName(const Session& session)
+{
+    return "PHD2_TraceLog_" + session.timestamp + ".bin";
+}
+
 static wxString FormatTimeSpan(const wxTimeSpan& dt)
 {
     int days = dt.GetDays();
@@ -403,7 +408,23 @@ static void QuickInitSummary(Session& s)
 
     s.summary.LoadSummaryInfo(file);
     if (s.summary.valid)
+    {
+        s.summary_loaded = ST_LOADED;
+        return;
+    }
+
+    // no summary in the guide log (PHD2 did not exit cleanly); the trace log
+    // header has the same counts if it saw the whole guide log
+    TRACE_SUMMARY ts;
+    if (TraceLog::LoadSummary(wxFileName(logDir, TraceLogName(s)).GetFullPath(), fn.GetFullPath(), &ts))
+    {
+        s.summary.cal_cnt = ts.cal_cnt;
+        s.summary.guide_cnt = ts.guide_cnt;
+        s.summary.guide_dur = ts.guide_dur;
+        s.summary.ga_cnt = ts.ga_cnt;
+        s.summary.valid = true;
         s.summary_loaded = ST_LOADED;
+    }
 }
 
 static void ReallyFlush(const wxFFile& ffile)
@@ -56,4 +56,14 @@ public:
     void RemoveOldDirectories(const wxString& dirPattern, int DaysOld);
 };
 
+// Flushes a log at a fixed interval from the GUI thread, so that buffered
+// records reach the disk even when no new records arrive
+class LogFlushTimer : public wxTimer
+{
+    std::function<void()> m_flush;
+public:
+    LogFlushTimer(const std::function<void()>& flush) : m_flush(flush) { }
+    void Notify() override { m_flush(); }
+};
+
 #endif
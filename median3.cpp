@@ -0,0 +1,324 @@
+/*
+ *  median3.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "median3.h"
+#include "image_kernels.h"
+
+#include <algorithm>
+#include <memory>
+#include <string.h>
+
+inline static void swap(unsigned short& a, unsigned short& b)
+{
+    unsigned short const t = a;
+    a = b;
+    b = t;
+}
+
+inline static unsigned short median6(const unsigned short l[6])
+{
+    unsigned short l0 = l[0], l1 = l[1], l2 = l[2], l3 = l[3];
+    unsigned short x;
+
+    x = l[4];
+    if (x < l0) swap(x, l0);
+    if (x < l1) swap(x, l1);
+    if (x < l2) swap(x, l2);
+    if (x < l3) swap(x, l3);
+    x = l[5];
+    if (x < l0) swap(x, l0);
+    if (x < l1) swap(x, l1);
+    if (x < l2) swap(x, l2);
+    if (x < l3) swap(x, l3);
+
+    if (l2 > l0) swap(l2, l0);
+    if (l2 > l1) swap(l2, l1);
+
+    if (l3 > l0) swap(l3, l0);
+    if (l3 > l1) swap(l3, l1);
+
+    return (unsigned short)(((unsigned int) l0 + (unsigned int) l1) / 2);
+}
+
+inline static unsigned short median4(const unsigned short l[4])
+{
+    unsigned short l0 = l[0], l1 = l[1], l2 = l[2];
+    unsigned short x;
+    x = l[3];
+    if (x < l0) swap(x, l0);
+    if (x < l1) swap(x, l1);
+    if (x < l2) swap(x, l2);
+
+    if (l2 > l0) swap(l2, l0);
+    if (l2 > l1) swap(l2, l1);
+
+    return (unsigned short)(((unsigned int) l0 + (unsigned int) l1) / 2);
+}
+
+// Runs the 3x3 median filter over rows [y0, y1) of rect (relative to the top of
+// rect), handing each filtered pixel to the sink along with its index in the image
+// buffer. Pixels are visited in row-major order.
+template<typename Sink>
+static void Median3Scan(Sink& sink, const unsigned short *src, int frameWidth, const FrameRect& rect, int y0, int y1)
+{
+    int const W = frameWidth;
+    int const RX = rect.x;
+    int const RY = rect.y;
+    int const RW = rect.width;
+    int const RH = rect.height;
+
+    enum { MEDIAN_CHUNK = 256 };
+    unsigned short chunk[MEDIAN_CHUNK];
+    const ImageKernels& kernels = GetImageKernels();
+
+    unsigned short a[9];
+    int ix;
+
+#define IX(x_, y_) ((RY + (y_)) * W + RX + (x_))
+
+    if (y0 == 0)
+    {
+        // top row
+        ix = IX(0, 0);
+
+        // top-left corner
+        a[0] = src[IX(0, 0)];
+        a[1] = src[IX(1, 0)];
+        a[2] = src[IX(0, 1)];
+        a[3] = src[IX(1, 1)];
+        sink(ix++, median4(a));
+
+        // top row middle pixels
+        for (int x = 1; x <= RW - 2; x++)
+        {
+            a[0] = src[IX(x - 1, 0)];
+            a[1] = src[IX(x,     0)];
+            a[2] = src[IX(x + 1, 0)];
+            a[3] = src[IX(x - 1, 1)];
+            a[4] = src[IX(x,     1)];
+            a[5] = src[IX(x + 1, 1)];
+            sink(ix++, median6(a));
+        }
+
+        // top-right corner
+        a[0] = src[IX(RW - 2, 0)];
+        a[1] = src[IX(RW - 1, 0)];
+        a[2] = src[IX(RW - 2, 1)];
+        a[3] = src[IX(RW - 1, 1)];
+        sink(ix, median4(a));
+    }
+
+    for (int y = std::max(y0, 1); y <= std::min(y1 - 1, RH - 2); y++)
+    {
+        ix = IX(0, y);
+
+        // leftmost pixel
+        a[0] = src[IX(0, y - 1)];
+        a[1] = src[IX(1, y - 1)];
+        a[2] = src[IX(0, y    )];
+        a[3] = src[IX(1, y    )];
+        a[4] = src[IX(0, y + 1)];
+        a[5] = src[IX(1, y + 1)];
+        sink(ix++, median6(a));
+
+        // interior pixels, in chunks through the vectorized row kernel
+        for (int x = 1; x <= RW - 2; )
+        {
+            int const n = std::min(RW - 1 - x, (int) MEDIAN_CHUNK);
+            kernels.median9Row(chunk, &src[IX(x - 1, y - 1)], &src[IX(x - 1, y)], &src[IX(x - 1, y + 1)], n);
+            for (int i = 0; i < n; i++)
+                sink(ix++, chunk[i]);
+            x += n;
+        }
+
+        // rightmost pixel
+        a[0] = src[IX(RW - 2, y - 1)];
+        a[1] = src[IX(RW - 1, y - 1)];
+        a[2] = src[IX(RW - 2, y    )];
+        a[3] = src[IX(RW - 1, y    )];
+        a[4] = src[IX(RW - 2, y + 1)];
+        a[5] = src[IX(RW - 1, y + 1)];
+        sink(ix++, median6(a));
+    }
+
+    if (y1 == RH)
+    {
+        // bottom row
+        ix = IX(0, RH - 1);
+
+        // bottom-left corner
+        a[0] = src[IX(0, RH - 2)];
+        a[1] = src[IX(1, RH - 2)];
+        a[2] = src[IX(0, RH - 1)];
+        a[3] = src[IX(1, RH - 1)];
+        sink(ix++, median4(a));
+
+        // bottom row middle pixels
+        for (int x = 1; x <= RW - 2; x++)
+        {
+            a[0] = src[IX(x - 1, RH - 2)];
+            a[1] = src[IX(x    , RH - 2)];
+            a[2] = src[IX(x + 1, RH - 2)];
+            a[3] = src[IX(x - 1, RH - 1)];
+            a[4] = src[IX(x    , RH - 1)];
+            a[5] = src[IX(x + 1, RH - 1)];
+            sink(ix++, median6(a));
+        }
+
+        // bottom-right corner
+        a[0] = src[IX(RW - 2, RH - 2)];
+        a[1] = src[IX(RW - 1, RH - 2)];
+        a[2] = src[IX(RW - 2, RH - 1)];
+        a[3] = src[IX(RW - 1, RH - 1)];
+        sink(ix, median4(a));
+    }
+
+#undef IX
+}
+
+struct Median3Writer
+{
+    unsigned short *dst;
+    Median3Writer(unsigned short *d) : dst(d) { }
+    void operator()(int ix, unsigned short val) { dst[ix] = val; }
+};
+
+void Median3Rows(unsigned short *dst, const unsigned short *src, int frameWidth, const FrameRect& rect, int y0, int y1)
+{
+    Median3Writer writer(dst);
+    Median3Scan(writer, src, frameWidth, rect, y0, y1);
+}
+
+// Pixel value histogram used to find the median without sorting a copy of the
+// image. Allocated once per thread; only the fine bins under non-empty coarse bins
+// are cleared after use so small subframes do not pay for the full table.
+struct StatsHistogram
+{
+    unsigned int coarse[256];   // indexed by the high byte of the pixel value
+    unsigned int fine[65536];
+};
+
+struct Median3Stats
+{
+    const unsigned short *src;
+    StatsHistogram *histo;
+    unsigned short minADU;
+    unsigned short maxADU;
+    unsigned short filtMin;
+    unsigned short filtMax;
+
+    Median3Stats(const unsigned short *s, StatsHistogram *h)
+        : src(s), histo(h), minADU(65535), maxADU(0), filtMin(65535), filtMax(0) { }
+
+    void operator()(int ix, unsigned short val)
+    {
+        unsigned short const d = src[ix];
+        if (d < minADU) minADU = d;
+        if (d > maxADU) maxADU = d;
+        ++histo->coarse[d >> 8];
+        ++histo->fine[d];
+        if (val < filtMin) filtMin = val;
+        if (val > filtMax) filtMax = val;
+    }
+};
+
+static StatsHistogram *GetStatsHistogram()
+{
+    static thread_local std::unique_ptr<StatsHistogram> s_histo;
+    if (!s_histo)
+        s_histo.reset(new StatsHistogram());
+    return s_histo.get();
+}
+
+FrameStatsScan::FrameStatsScan()
+    : m_histo(GetStatsHistogram()), m_minADU(65535), m_maxADU(0), m_filtMin(65535), m_filtMax(0)
+{
+}
+
+void FrameStatsScan::AddRows(const unsigned short *src, int frameWidth, const FrameRect& rect, int y0, int y1)
+{
+    // min, max and histogram of the raw pixels are accumulated in the same pass
+    // that computes the extrema of the 3x3 median filtered image
+    Median3Stats acc(src, m_histo);
+    acc.minADU = m_minADU;
+    acc.maxADU = m_maxADU;
+    acc.filtMin = m_filtMin;
+    acc.filtMax = m_filtMax;
+
+    Median3Scan(acc, src, frameWidth, rect, y0, y1);
+
+    m_minADU = acc.minADU;
+    m_maxADU = acc.maxADU;
+    m_filtMin = acc.filtMin;
+    m_filtMax = acc.filtMax;
+}
+
+// Fill in the stats from the accumulated pixels of rect and clear the histogram
+// for the next frame
+void FrameStatsScan::Finish(FrameStats *stats, const FrameRect& rect)
+{
+    StatsHistogram *const histo = m_histo;
+
+    stats->minADU = m_minADU;
+    stats->maxADU = m_maxADU;
+    stats->filtMin = m_filtMin;
+    stats->filtMax = m_filtMax;
+
+    // the median is the element at index n/2 of the sorted pixels
+    unsigned int const target = (unsigned int) rect.width * (unsigned int) rect.height / 2;
+    unsigned int cum = 0;
+    unsigned int hi = 0;
+    while (cum + histo->coarse[hi] <= target)
+        cum += histo->coarse[hi++];
+    unsigned int v = hi << 8;
+    while (cum + histo->fine[v] <= target)
+        cum += histo->fine[v++];
+    stats->medianADU = (unsigned short) v;
+
+    for (unsigned int i = 0; i < 256; i++)
+    {
+        if (histo->coarse[i])
+        {
+            memset(&histo->fine[i << 8], 0, 256 * sizeof(histo->fine[0]));
+            histo->coarse[i] = 0;
+        }
+    }
+}
+
+void CalcFrameStats(FrameStats *stats, const unsigned short *src, int frameWidth, const FrameRect& rect)
+{
+    FrameStatsScan scan;
+    scan.AddRows(src, frameWidth, rect, 0, rect.height);
+    scan.Finish(stats, rect);
+}
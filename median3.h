@@ -0,0 +1,85 @@
+/*
+ *  median3.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef MEDIAN3_INCLUDED
+#define MEDIAN3_INCLUDED
+
+//
+// The 3x3 median filter, and the frame statistics computed in the same pass over
+// the pixels. Only the pixels inside rect are read, in a frame frameWidth pixels
+// wide. There are no wxWidgets types here; image_math.h has the wxSize and
+// wxRect versions used by the rest of PHD2.
+//
+
+struct FrameRect
+{
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+struct FrameStats
+{
+    unsigned short minADU;
+    unsigned short maxADU;
+    unsigned short medianADU;
+    unsigned short filtMin;     // min and max of the 3x3 median filtered image
+    unsigned short filtMax;
+};
+
+// filter rows [y0, y1) of rect (relative to the top of rect) into the same pixels of dst
+extern void Median3Rows(unsigned short *dst, const unsigned short *src, int frameWidth, const FrameRect& rect, int y0, int y1);
+extern void CalcFrameStats(FrameStats *stats, const unsigned short *src, int frameWidth, const FrameRect& rect);
+
+struct StatsHistogram;
+
+// CalcFrameStats a band of rows at a time, for callers that finish the frame row
+// by row. AddRows(y0, y1) also reads row y1 (relative to the top of rect), the
+// row below the band, so it must already be final. Bands must be added in order.
+class FrameStatsScan
+{
+    StatsHistogram *m_histo;
+    unsigned short m_minADU;
+    unsigned short m_maxADU;
+    unsigned short m_filtMin;
+    unsigned short m_filtMax;
+
+public:
+    FrameStatsScan();
+    void AddRows(const unsigned short *src, int frameWidth, const FrameRect& rect, int y0, int y1);
+    void Finish(FrameStats *stats, const FrameRect& rect);
+};
+
+#endif // MEDIAN3_INCLUDED
@@ -1001,6 +1001,19 @@ Mount::MOVE_RESULT Mount::MoveOffset(GuiderOffset *ofs, unsigned int moveOptions
 
             if (moveOptions & MOVEOPT_ALGO_RESULT)
             {
+                if ((moveOptions & MOVEOPT_LATENT) && m_lastCorrection.IsValid())
+                {
+                    // Pipelined capture: the frame was exposed before the previous
+                    // correction took effect. Feed the algorithms the expected offset
+                    // once that correction lands so they do not correct twice for the
+                    // same error.
+                    xDistance -= m_lastCorrection.X;
+                    yDistance -= m_lastCorrection.Y;
+
+                    Debug.Write(wxString::Format("Latent frame, pending correction (%.2f, %.2f) xDistance=%.2f yDistance=%.2f\n",
+                        m_lastCorrection.X, m_lastCorrection.Y, xDistance, yDistance));
+                }
+
                 // Feed the raw distances to the guide algorithms
                 if (m_pXGuideAlgorithm)
                 {
@@ -1033,6 +1046,12 @@ Mount::MOVE_RESULT Mount::MoveOffset(GuiderOffset *ofs, unsigned int moveOptions
             result = MoveAxis(yDirection, requestedYAmount, moveOptions, &yMoveResult);
         }
 
+        // remember how far the mount was actually moved in case the next frame was
+        // exposed before the move took effect; the Dec pulse may include backlash comp
+        double xMoved = wxMin(fabs(xDistance), xMoveResult.amountMoved * m_xRate);
+        double yMoved = wxMin(fabs(yDistance), yMoveResult.amountMoved * m_cal.yRate);
+        m_lastCorrection.SetXY(xDistance > 0.0 ? xMoved : -xMoved, yDistance > 0.0 ? yMoved : -yMoved);
+
         // Record the info about the guide step. The info will be picked up back in the main UI thread.
         // We don't want to do anything with the info here in the worker thread since UI operations are
         // not allowed outside the main UI thread.
@@ -1058,10 +1077,13 @@ Mount::MOVE_RESULT Mount::MoveOffset(GuiderOffset *ofs, unsigned int moveOptions
         info.starHFD = pFrame->pGuider->HFD();
         info.avgDist = pFrame->CurrentGuideError();
         info.starError = pFrame->pGuider->StarError();
+
+        Trace.GuideStep(info);
     }
     catch (const wxString& errMsg)
     {
         POSSIBLY_UNUSED(errMsg);
+        m_lastCorrection.Invalidate();
         if (result == MOVE_OK)
             result = MOVE_ERROR;
     }
@@ -1610,6 +1632,8 @@ void Mount::NotifyGuidingStarted()
 {
     Debug.Write("Mount: notify guiding started\n");
 
+    m_lastCorrection.Invalidate();
+
     if (m_pXGuideAlgorithm)
         m_pXGuideAlgorithm->GuidingStarted();
 
@@ -1621,6 +1645,8 @@ void Mount::NotifyGuidingStopped()
 {
     Debug.Write("Mount: notify guiding stopped\n");
 
+    m_lastCorrection.Invalidate();
+
     if (m_pXGuideAlgorithm)
         m_pXGuideAlgorithm->GuidingStopped();
 
@@ -1646,6 +1672,8 @@ void Mount::NotifyGuidingResumed()
 {
     Debug.Write("Mount: notify guiding resumed\n");
 
+    m_lastCorrection.Invalidate();
+
     if (m_pXGuideAlgorithm)
         m_pXGuideAlgorithm->GuidingResumed();
 
@@ -129,6 +129,8 @@ enum MountMoveOptionBits
     MOVEOPT_USE_BLC     = (1<<2),    // use backlash comp for this move
     MOVEOPT_GRAPH       = (1<<3),    // display the move on the graphs
     MOVEOPT_MANUAL      = (1<<4),    // manual move - allow even when guiding disabled
+    MOVEOPT_LATENT      = (1<<5),    // offset measured before the previous move took effect (pipelined capture)
+    MOVEOPT_PIPELINED   = (1<<6),    // move queued on the secondary worker thread by pipelined capture
 };
 
 enum
@@ -183,6 +185,7 @@ protected:
     wxString m_Name;
     BacklashComp *m_backlashComp;
     GuideStepInfo m_lastStep;
+    PHD_Point m_lastCorrection; // mount coordinates, last move actually sent
 
     // Things related to the Advanced Config Dialog
 public:
@@ -61,6 +61,8 @@ static const bool DefaultDitherRaOnly = false;
 static const DitherMode DefaultDitherMode = DITHER_RANDOM;
 static const bool DefaultServerMode = true;
 static const int DefaultTimelapse = 0;
+static const bool DefaultPreArmExposures = false;
+static const bool DefaultFusedPreprocessing = false;
 static const int DefaultFocalLength = 0;
 static const int DefaultExposureDuration = 1000;
 static const int DefaultAutoExpMin = 1000;
@@ -74,6 +76,7 @@ wxDEFINE_EVENT(STATUSBAR_ENQUEUE_EVENT, wxCommandEvent);
 wxDEFINE_EVENT(STATUSBAR_TIMER_EVENT, wxTimerEvent);
 wxDEFINE_EVENT(SET_STATUS_TEXT_EVENT, wxThreadEvent);
 wxDEFINE_EVENT(ALERT_FROM_THREAD_EVENT, wxThreadEvent);
+wxDEFINE_EVENT(AUTOFIND_COMPLETE_EVENT, wxThreadEvent);
 wxDEFINE_EVENT(RECONNECT_CAMERA_EVENT, wxThreadEvent);
 wxDEFINE_EVENT(UPDATER_EVENT, wxThreadEvent);
 
@@ -166,6 +169,7 @@ wxBEGIN_EVENT_TABLE(MyFrame, wxFrame)
     EVT_THREAD(SET_STATUS_TEXT_EVENT, MyFrame::OnStatusMsg)
     EVT_THREAD(ALERT_FROM_THREAD_EVENT, MyFrame::OnAlertFromThread)
     EVT_THREAD(RECONNECT_CAMERA_EVENT, MyFrame::OnReconnectCameraFromThread)
+    EVT_THREAD(AUTOFIND_COMPLETE_EVENT, MyFrame::OnAutoFindComplete)
     EVT_THREAD(UPDATER_EVENT, MyFrame::OnUpdaterStateChanged)
     EVT_COMMAND(wxID_ANY, REQUEST_MOUNT_MOVE_EVENT, MyFrame::OnRequestMountMove)
     EVT_TIMER(STATUSBAR_TIMER_EVENT, MyFrame::OnStatusBarTimerEvent)
@@ -387,6 +391,13 @@ MyFrame::MyFrame()
     m_continueCapturing = false;
     CaptureActive     = false;
     m_exposurePending = false;
+    m_nextFrameLatent = false;
+    m_latentFrame = false;
+    m_overlapMoves = false;
+    m_pipelinedMoves = 0;
+    m_heldFrames = 0;
+    m_preArmExposures = DefaultPreArmExposures;
+    m_fusedPreprocessing = DefaultFusedPreprocessing;
 
     m_singleExposure.enabled = false;
     m_singleExposure.duration = 0;
@@ -838,6 +849,9 @@ void MyFrame::LoadProfileSettings()
     int timeLapse = pConfig->Profile.GetInt("/frame/timeLapse", DefaultTimelapse);
     SetTimeLapse(timeLapse);
 
+    m_preArmExposures = pConfig->Profile.GetBoolean("/frame/preArmExposures", DefaultPreArmExposures);
+    m_fusedPreprocessing = pConfig->Profile.GetBoolean("/frame/fusedPreprocessing", DefaultFusedPreprocessing);
+
     // Don't re-save the setting here with a call to SetAutoLoadCalibration().  An un-initialized registry key (-1) will
     // be populated after the 1st calibration
     int autoLoad = pConfig->Profile.GetInt("/AutoLoadCalibration", -1);
@@ -1663,7 +1677,61 @@ void MyFrame::ScheduleExposure()
     wxCriticalSectionLocker lock(m_CSpWorkerThread);
 
     if (m_pPrimaryWorkerThread) // can be null when app is shutting down (unlikely but possible)
+    {
         m_pPrimaryWorkerThread->EnqueueWorkerThreadExposeRequest(img, exposureDuration, exposureOptions, subframe);
+        if (PreArmActive())
+            m_pPrimaryWorkerThread->ArmNextExposure(exposureDuration, exposureOptions, subframe);
+    }
+}
+
+// Pre-arming only applies to continuous capture with cameras that capture in
+// the worker thread. Calibration needs each frame to see the preceding move.
+bool MyFrame::PreArmActive() const
+{
+    return m_preArmExposures && m_continueCapturing && !m_singleExposure.enabled &&
+        pCamera && pCamera->HasNonGuiCapture() && !pGuider->IsCalibrating();
+}
+
+/*
+ * Arm the worker thread to start the exposure after the one already in progress
+ * as soon as that one is read out. Called after each frame that was itself
+ * pre-armed, so the exposure parameters (duration, guider subframe) trail the
+ * GUI state by one frame.
+ */
+void MyFrame::ArmNextExposure()
+{
+    assert(wxThread::IsMain());
+
+    if (!PreArmActive())
+        return;
+
+    int exposureDuration = RequestedExposureDuration();
+    int exposureOptions = GetRawImageMode() ? CAPTURE_BPM_REVIEW : CAPTURE_LIGHT;
+    const wxRect& subframe = pGuider->GetBoundingBox();
+
+    wxCriticalSectionLocker lock(m_CSpWorkerThread);
+
+    if (m_pPrimaryWorkerThread)
+        m_pPrimaryWorkerThread->ArmNextExposure(exposureDuration, exposureOptions, subframe);
+}
+
+/*
+ * Pipelined capture sends the correction for a frame from the secondary worker
+ * thread while the primary worker exposes the next frame. Any other move for
+ * the mount scheduled before that correction completes is queued behind it on
+ * the same thread, so the mount is never driven from two threads at once.
+ * Mounts guiding through the camera and AOs stay in step with the exposures on
+ * the primary thread. Called with m_CSpWorkerThread held.
+ */
+bool MyFrame::UsePipelinedMoveThread(Mount *mount, unsigned int moveOptions) const
+{
+    if (!m_pSecondaryWorkerThread || mount->SynchronousOnly() || mount->IsStepGuider())
+        return false;
+
+    if (m_pipelinedMoves > 0)
+        return true;
+
+    return m_overlapMoves && (moveOptions & (MOVEOPT_ALGO_RESULT | MOVEOPT_ALGO_DEDUCE)) != 0;
 }
 
 void MyFrame::SchedulePrimaryMove(Mount *mount, const GuiderOffset& ofs, unsigned int moveOptions)
@@ -1678,6 +1746,16 @@ void MyFrame::SchedulePrimaryMove(Mount *mount, const GuiderOffset& ofs, unsigne
     if ((moveOptions & MOVEOPT_MANUAL) == 0)
         mount->IncrementRequestCount();
 
+    if (m_latentFrame && (moveOptions & (MOVEOPT_ALGO_RESULT | MOVEOPT_ALGO_DEDUCE)) != 0)
+        moveOptions |= MOVEOPT_LATENT;
+
+    if (UsePipelinedMoveThread(mount, moveOptions))
+    {
+        ++m_pipelinedMoves;
+        m_pSecondaryWorkerThread->EnqueueWorkerThreadMoveRequest(mount, ofs, moveOptions | MOVEOPT_PIPELINED);
+        return;
+    }
+
     assert(m_pPrimaryWorkerThread);
     m_pPrimaryWorkerThread->EnqueueWorkerThreadMoveRequest(mount, ofs, moveOptions);
 }
@@ -1715,6 +1793,13 @@ void MyFrame::ScheduleAxisMove(Mount *mount, const GUIDE_DIRECTION direction, in
     if ((moveOptions & MOVEOPT_MANUAL) == 0)
         mount->IncrementRequestCount();
 
+    if (UsePipelinedMoveThread(mount, moveOptions))
+    {
+        ++m_pipelinedMoves;
+        m_pSecondaryWorkerThread->EnqueueWorkerThreadAxisMove(mount, direction, duration, moveOptions | MOVEOPT_PIPELINED);
+        return;
+    }
+
     assert(m_pPrimaryWorkerThread);
     m_pPrimaryWorkerThread->EnqueueWorkerThreadAxisMove(mount, direction, duration, moveOptions);
 }
@@ -1781,6 +1866,30 @@ bool MyFrame::AutoSelectStar(const wxRect& roi)
     return pGuider->AutoSelect(roi);
 }
 
+// Like AutoSelectStar, but the star search runs on a background thread and the
+// result is applied when AUTOFIND_COMPLETE_EVENT arrives. Returns true if the
+// search could not be started.
+bool MyFrame::AutoSelectStarAsync(const wxRect& roi)
+{
+    if (pGuider->IsCalibratingOrGuiding())
+    {
+        Debug.Write("cannot auto-select star while calibrating or guiding\n");
+        return true; // error
+    }
+
+    return pGuider->StartAutoSelect(roi);
+}
+
+void MyFrame::OnAutoFindComplete(wxThreadEvent& event)
+{
+    if (!pGuider)
+        return;
+
+    bool error = pGuider->CompleteAutoSelect();
+
+    EvtServer.NotifyAutoSelectComplete(error);
+}
+
 void MyFrame::StartCapturing()
 {
     Debug.Write(wxString::Format("StartCapturing CaptureActive=%d continueCapturing=%d exposurePending=%d\n", CaptureActive, m_continueCapturing, m_exposurePending));
@@ -1792,6 +1901,7 @@ void MyFrame::StartCapturing()
 
         CaptureActive = true;
         m_frameCounter = 0;
+        m_nextFrameLatent = false;
 
         CheckDarkFrameGeometry();
         UpdateButtonsStatus();
@@ -1830,6 +1940,7 @@ bool MyFrame::StopCapturing()
 
         if (m_exposurePending)
         {
+            m_pPrimaryWorkerThread->DisarmNextExposure();
             m_pPrimaryWorkerThread->RequestStop();
             finished = false;
         }
@@ -1856,6 +1967,11 @@ void MyFrame::SetPaused(PauseType pause)
 
     if (pause != PAUSE_NONE && !isPaused)
     {
+        {
+            wxCriticalSectionLocker lock(m_CSpWorkerThread);
+            if (m_pPrimaryWorkerThread)
+                m_pPrimaryWorkerThread->DisarmNextExposure();
+        }
         pGuider->SetPaused(pause);
         StatusMsg(_("Paused"));
         GuideLog.ServerCommand(pGuider, "PAUSE");
@@ -2108,6 +2224,7 @@ void MyFrame::OnClose(wxCloseEvent& event)
     StartServer(false);
 
     GuideLog.CloseGuideLog();
+    Trace.Close();
 
     pConfig->Global.SetString("/perspective", m_mgr.SavePerspective());
     wxString geometry = wxString::Format("%c;%d;%d;%d;%d",
@@ -2646,6 +2763,24 @@ bool MyFrame::SetTimeLapse(int timeLapse)
     return bError;
 }
 
+void MyFrame::SetPreArmExposures(bool val)
+{
+    if (m_preArmExposures != val)
+    {
+        m_preArmExposures = val;
+        pConfig->Profile.SetBoolean("/frame/preArmExposures", m_preArmExposures);
+    }
+}
+
+void MyFrame::SetFusedPreprocessing(bool val)
+{
+    if (m_fusedPreprocessing != val)
+    {
+        m_fusedPreprocessing = val;
+        pConfig->Profile.SetBoolean("/frame/fusedPreprocessing", m_fusedPreprocessing);
+    }
+}
+
 bool MyFrame::SetFocalLength(int focalLength)
 {
     bool bError = false;
@@ -2964,6 +3099,19 @@ MyFrameConfigDialogCtrlSet::MyFrameConfigDialogCtrlSet(MyFrame *pFrame, Advanced
     AddLabeledCtrl(CtrlMap, AD_szTimeLapse, _("Time Lapse (ms)"), m_pTimeLapse,
         _("How long should PHD wait between guide frames? Default = 0ms, useful when using very short exposures (e.g., using a video camera) but wanting to send guide commands less frequently"));
 
+    parent = GetParentWindow(AD_cbPipelinedCapture);
+    m_pPipelinedCapture = new wxCheckBox(parent, wxID_ANY, _("Pipelined capture"));
+    AddCtrl(CtrlMap, AD_cbPipelinedCapture, m_pPipelinedCapture,
+        _("Start the next exposure as soon as the current frame is downloaded, and send guide corrections while it is exposing. "
+          "Shortens the guide cycle with slow-downloading cameras, at the cost of each correction being seen one frame later. "
+          "Not used for cameras that must capture on the main thread, or for single exposures."));
+
+    parent = GetParentWindow(AD_cbFusedPreprocessing);
+    m_pFusedPreprocessing = new wxCheckBox(parent, wxID_ANY, _("Single-pass image processing"));
+    AddCtrl(CtrlMap, AD_cbFusedPreprocessing, m_pFusedPreprocessing,
+        _("Do the dark subtraction or bad-pixel correction, the noise reduction and the image statistics in one pass over the frame. "
+          "Gives the same result with less memory traffic, which helps with large frames."));
+
     parent = GetParentWindow(AD_szFocalLength);
     // Put a validator on this field to be sure that only digits are entered - avoids problem where
     // user face-plant on keyboard results in a focal length of zero
@@ -3144,6 +3292,8 @@ void MyFrameConfigDialogCtrlSet::LoadValues()
     m_pLogDir->Enable(!pFrame->CaptureActive);
     m_pSelectDir->Enable(!pFrame->CaptureActive);
     m_pAutoLoadCalibration->SetValue(m_pFrame->GetAutoLoadCalibration());
+    m_pPipelinedCapture->SetValue(m_pFrame->GetPreArmExposures());
+    m_pFusedPreprocessing->SetValue(m_pFrame->GetFusedPreprocessing());
 
     const AutoExposureCfg& cfg = m_pFrame->GetAutoExposureCfg();
 
@@ -3216,6 +3366,8 @@ void MyFrameConfigDialogCtrlSet::UnloadValues()
         m_pFrame->SetDitherRaOnly(m_ditherRaOnly->GetValue());
         m_pFrame->SetDitherScaleFactor(m_ditherScaleFactor->GetValue());
         m_pFrame->SetTimeLapse(m_pTimeLapse->GetValue());
+        m_pFrame->SetPreArmExposures(m_pPipelinedCapture->GetValue());
+        m_pFrame->SetFusedPreprocessing(m_pFusedPreprocessing->GetValue());
         int oldFL = m_pFrame->GetFocalLength();
         int newFL = GetFocalLength();               // From UI control
         if (oldFL != newFL)
@@ -56,6 +56,7 @@ wxDECLARE_EVENT(STATUSBAR_ENQUEUE_EVENT, wxCommandEvent);
 wxDECLARE_EVENT(STATUSBAR_TIMER_EVENT, wxTimerEvent);
 wxDECLARE_EVENT(SET_STATUS_TEXT_EVENT, wxThreadEvent);
 wxDECLARE_EVENT(ALERT_FROM_THREAD_EVENT, wxThreadEvent);
+wxDECLARE_EVENT(AUTOFIND_COMPLETE_EVENT, wxThreadEvent);
 
 enum NOISE_REDUCTION_METHOD
 {
@@ -122,6 +123,8 @@ class MyFrameConfigDialogCtrlSet : public ConfigDialogCtrlSet
     wxCheckBox *m_ditherRaOnly;
     wxChoice *m_pNoiseReduction;
     wxSpinCtrl *m_pTimeLapse;
+    wxCheckBox *m_pPipelinedCapture;
+    wxCheckBox *m_pFusedPreprocessing;
     wxTextCtrl *m_pFocalLength;
     wxChoice *m_pLanguage;
     int m_oldLanguageChoice;
@@ -181,6 +184,8 @@ private:
     DitherSpiral m_ditherSpiral;
     bool m_serverMode;
     int  m_timeLapse;       // Delay between frames (useful for vid cameras)
+    bool m_preArmExposures; // start the next exposure as soon as the current one is read out
+    bool m_fusedPreprocessing; // dark, noise reduction and stats in one pass over the frame
     int  m_focalLength;
     bool m_beepForLostStar;
     double m_sampling;
@@ -244,6 +249,11 @@ public:
     wxDialog *pCalReviewDlg;
     bool CaptureActive; // Is camera looping captures?
     bool m_exposurePending; // exposure scheduled and not completed
+    bool m_nextFrameLatent; // next frame was exposed before the current frame's correction was applied
+    bool m_latentFrame;     // frame being processed was exposed before the previous correction was applied
+    bool m_overlapMoves;    // guide moves for the frame being processed may run during the next exposure
+    int m_pipelinedMoves;   // outstanding MOVEOPT_PIPELINED moves, protected by m_CSpWorkerThread
+    int m_heldFrames;       // exposure complete events deferred until the pipelined moves are done
     double Stretch_gamma;
     unsigned int m_frameCounter;
     wxDateTime m_guidingStarted;
@@ -327,7 +337,7 @@ public:
     void OnImportCamCal(wxCommandEvent& evt);
 
     void OnExposeComplete(wxThreadEvent& evt);
-    void OnExposeComplete(usImage *image, bool err);
+    void OnExposeComplete(usImage *image, bool err, bool nextArmed = false);
     void OnMoveComplete(wxThreadEvent& evt);
 
     void LoadProfileSettings();
@@ -386,6 +396,13 @@ public:
     void OnRequestMountMove(wxCommandEvent& evt);
 
     void ScheduleExposure();
+    void SetPreArmExposures(bool val);
+    bool GetPreArmExposures() const;
+    void SetFusedPreprocessing(bool val);
+    bool GetFusedPreprocessing() const;
+    bool PreArmActive() const;
+    void ArmNextExposure();
+    bool UsePipelinedMoveThread(Mount *mount, unsigned int moveOptions) const;
 
     void SchedulePrimaryMove(Mount *mount, const GuiderOffset& ofs, unsigned int moveOptions);
     void ScheduleSecondaryMove(Mount *mount, const GuiderOffset& ofs, unsigned int moveOptions);
@@ -397,6 +414,7 @@ public:
     bool StartSingleExposure(int duration, const wxRect& subframe);
 
     bool AutoSelectStar(const wxRect& roi = wxRect());
+    bool AutoSelectStarAsync(const wxRect& roi = wxRect());
 
     void SetPaused(PauseType pause);
 
@@ -481,6 +499,7 @@ private:
     void OnAlertHelp(wxCommandEvent& evt);
     void OnAlertFromThread(wxThreadEvent& event);
     void OnReconnectCameraFromThread(wxThreadEvent& event);
+    void OnAutoFindComplete(wxThreadEvent& event);
     void OnStatusBarTimerEvent(wxTimerEvent& evt);
     void OnUpdaterStateChanged(wxThreadEvent& event);
     void OnMessageBoxProxy(wxCommandEvent& evt);
@@ -678,6 +697,9 @@ enum {
     SOCK_SERVER_CLIENT_ID,
     EVENT_SERVER_ID,
     EVENT_SERVER_CLIENT_ID,
+    FRAME_STREAM_SERVER_ID,
+    FRAME_STREAM_CLIENT_ID,
+    FRAME_STREAM_ENCODED_ID,
 };
 
 wxDECLARE_EVENT(APPSTATE_NOTIFY_EVENT, wxCommandEvent);
@@ -749,6 +771,16 @@ inline int MyFrame::GetTimeLapse() const
     return m_timeLapse;
 }
 
+inline bool MyFrame::GetPreArmExposures() const
+{
+    return m_preArmExposures;
+}
+
+inline bool MyFrame::GetFusedPreprocessing() const
+{
+    return m_fusedPreprocessing;
+}
+
 inline int MyFrame::GetFocalLength() const
 {
     return m_focalLength;
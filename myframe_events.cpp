@@ -412,6 +412,7 @@ void MyFrame::FinishStop(void)
     UpdateButtonsStatus();
     StatusMsg(_("Stopped."));
     PhdController::AbortController("Stopped capturing");
+    ImagePool::LogStats();
 }
 
 static wxString RawModeWarningKey(void)
@@ -444,17 +445,21 @@ static void WarnRawImageMode(void)
  * - updates button state based on appropriate state variables
  * - schedules another exposure if CaptureActive is stil true
  *
+ * When nextArmed is set the worker thread has already started the next
+ * exposure, so the exposure remains pending and the worker is just re-armed.
+ *
  */
-void MyFrame::OnExposeComplete(usImage *pNewFrame, bool err)
+void MyFrame::OnExposeComplete(usImage *pNewFrame, bool err, bool nextArmed)
 {
     try
     {
-        Debug.Write("OnExposeComplete: enter\n");
+        Debug.Write(wxString::Format("OnExposeComplete: enter nextArmed=%d\n", nextArmed));
 
-        m_exposurePending = false;
+        m_exposurePending = nextArmed;
 
         if (pGuider->GetPauseType() == PAUSE_FULL)
         {
+            m_nextFrameLatent = false;
             delete pNewFrame;
             Debug.Write("guider is paused, ignoring frame, not scheduling exposure\n");
             return;
@@ -466,6 +471,8 @@ void MyFrame::OnExposeComplete(usImage *pNewFrame, bool err)
 
             delete pNewFrame;
 
+            m_nextFrameLatent = false;
+
             bool stopping = !m_continueCapturing;
             StopCapturing();
             if (pGuider->IsCalibratingOrGuiding())
@@ -489,6 +496,7 @@ void MyFrame::OnExposeComplete(usImage *pNewFrame, bool err)
         }
 
         pNewFrame->FrameNum = ++m_frameCounter;
+        Trace.FrameCaptured(pNewFrame);
 
         if (m_rawImageMode && !m_rawImageModeWarningDone)
         {
@@ -502,9 +510,19 @@ void MyFrame::OnExposeComplete(usImage *pNewFrame, bool err)
             CheckDarkFrameGeometry();
         }
 
+        // With pipelined capture this frame may have been exposed before the
+        // correction for the previous frame was applied, and the correction for
+        // this frame can be sent while the next one is exposing
+        m_latentFrame = m_nextFrameLatent;
+        m_nextFrameLatent = nextArmed;
+        m_overlapMoves = nextArmed;
+
         pGuider->UpdateGuideState(pNewFrame, !m_continueCapturing);
         pNewFrame = NULL; // the guider owns it now
 
+        m_latentFrame = false;
+        m_overlapMoves = false;
+
         PhdController::UpdateControllerState();
 
         Debug.Write(wxString::Format("OnExposeComplete: CaptureActive=%d m_continueCapturing=%d\n",
@@ -514,25 +532,51 @@ void MyFrame::OnExposeComplete(usImage *pNewFrame, bool err)
 
         if (CaptureActive)
         {
-            ScheduleExposure();
+            if (nextArmed)
+                ArmNextExposure();
+            else
+                ScheduleExposure();
         }
-        else
+        else if (!nextArmed)
         {
             FinishStop();
         }
+        // else the stop completes with the pre-armed exposure, which RequestStop interrupts
+
+        FrameStream.NotifyFrame(pGuider->CurrentImage());
+        EvtServer.NotifyFrameComplete();
     }
     catch (const wxString& Msg)
     {
         POSSIBLY_UNUSED(Msg);
+        m_latentFrame = false;
+        m_overlapMoves = false;
         UpdateButtonsStatus();
     }
 }
 
 void MyFrame::OnExposeComplete(wxThreadEvent& event)
 {
-    usImage *image = event.GetPayload<usImage *>();
-    bool err = event.GetInt() != 0;
-    OnExposeComplete(image, err);
+    EXPOSED_FRAME frame;
+
+    {
+        wxCriticalSectionLocker lock(m_CSpWorkerThread);
+
+        // With pipelined capture the correction for the previous frame can still be
+        // running when the next frame arrives. Hold the frame until the mount is
+        // done; OnMoveComplete delivers it.
+        if (m_pipelinedMoves > 0)
+        {
+            Debug.Write("OnExposeComplete: holding frame until pipelined move completes\n");
+            ++m_heldFrames;
+            return;
+        }
+
+        if (!m_pPrimaryWorkerThread || !m_pPrimaryWorkerThread->PopExposedFrame(&frame))
+            return;
+    }
+
+    OnExposeComplete(frame.pImage, frame.error, frame.nextArmed);
 }
 
 void MyFrame::OnMoveComplete(wxThreadEvent& event_)
@@ -541,6 +585,18 @@ void MyFrame::OnMoveComplete(wxThreadEvent& event_)
     {
         MoveCompleteEvent& event = static_cast<MoveCompleteEvent&>(event_);
 
+        if (event.moveOptions & MOVEOPT_PIPELINED)
+        {
+            wxCriticalSectionLocker lock(m_CSpWorkerThread);
+            assert(m_pipelinedMoves > 0);
+            if (--m_pipelinedMoves == 0)
+            {
+                // deliver the held frames once this event has been handled
+                for (; m_heldFrames > 0; --m_heldFrames)
+                    wxQueueEvent(this, new wxThreadEvent(wxEVT_THREAD, MYFRAME_WORKER_THREAD_EXPOSE_COMPLETE));
+            }
+        }
+
         if (event.moveOptions & MOVEOPT_MANUAL)
         {
             Debug.Write(wxString::Format("Manual Move completed, result = %d\n", event.result));
@@ -623,7 +679,7 @@ void MyFrame::OnButtonStop(wxCommandEvent& WXUNUSED(event))
 void MyFrame::OnButtonAutoStar(wxCommandEvent& WXUNUSED(event))
 {
     if (!wxGetKeyState(WXK_SHIFT))
-        AutoSelectStar();
+        AutoSelectStarAsync();
     else
         pGuider->InvalidateCurrentPosition(true);
 }
@@ -914,7 +970,7 @@ bool MyFrame::FlipCalibrationData()
 
 void MyFrame::OnAutoStar(wxCommandEvent& WXUNUSED(evt))
 {
-    AutoSelectStar();
+    AutoSelectStarAsync();
 }
 
 void MyFrame::OnSetupCamera(wxCommandEvent& WXUNUSED(event))
@@ -0,0 +1,192 @@
+/*
+ *  parallel_for.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+#include "parallel_for.h"
+
+#include <vector>
+
+class ParallelForWorker;
+
+struct ParallelForPool
+{
+    wxMutex lock;
+    wxCondition workReady;
+    wxCondition workDone;
+    std::vector<ParallelForWorker *> workers;
+    const std::function<void(int, int)> *func;
+    int count;
+    int nchunks;
+    int nextChunk;                          // next chunk to be claimed
+    int pending;                            // chunks not finished yet
+    unsigned int generation;                // bumped for each ParallelFor call
+    bool inUse;                             // a ParallelFor call owns the fields above
+    bool exit;
+
+    ParallelForPool()
+        : workReady(lock), workDone(lock), func(nullptr), count(0), nchunks(0),
+        nextChunk(0), pending(0), generation(0), inUse(false), exit(false)
+    {
+    }
+
+    // claim and run chunks until there are none left, called with lock held
+    void RunChunks()
+    {
+        while (nextChunk < nchunks)
+        {
+            int const i = nextChunk++;
+            int const begin = (int)((long long) count * i / nchunks);
+            int const end = (int)((long long) count * (i + 1) / nchunks);
+
+            lock.Unlock();
+            (*func)(begin, end);
+            lock.Lock();
+
+            if (--pending == 0)
+                workDone.Signal();
+        }
+    }
+};
+
+class ParallelForWorker : public wxThread
+{
+    ParallelForPool *m_pool;
+
+public:
+    ParallelForWorker(ParallelForPool *pool) : wxThread(wxTHREAD_JOINABLE), m_pool(pool) { }
+
+protected:
+    ExitCode Entry() override
+    {
+        ParallelForPool *pool = m_pool;
+        unsigned int seen = 0;
+
+        wxMutexLocker lck(pool->lock);
+        while (true)
+        {
+            while (!pool->exit && pool->generation == seen)
+                pool->workReady.Wait();
+            if (pool->exit)
+                break;
+            seen = pool->generation;
+            pool->RunChunks();
+        }
+
+        return (ExitCode) 0;
+    }
+};
+
+static ParallelForPool *s_pool;
+
+void ParallelForInit()
+{
+    if (s_pool)
+        return;
+
+    s_pool = new ParallelForPool();
+
+    int const nworkers = wxThread::GetCPUCount() - 1;
+    for (int i = 0; i < nworkers; i++)
+    {
+        ParallelForWorker *worker = new ParallelForWorker(s_pool);
+        if (worker->Run() != wxTHREAD_NO_ERROR)
+        {
+            // the calling thread picks up the chunks the missing workers would have run
+            delete worker;
+            break;
+        }
+        s_pool->workers.push_back(worker);
+    }
+
+    Debug.Write(wxString::Format("ParallelFor: %u worker threads\n", (unsigned int) s_pool->workers.size()));
+}
+
+void ParallelForDestroy()
+{
+    if (!s_pool)
+        return;
+
+    {
+        wxMutexLocker lck(s_pool->lock);
+        s_pool->exit = true;
+        s_pool->workReady.Broadcast();
+    }
+
+    for (ParallelForWorker *worker : s_pool->workers)
+    {
+        worker->Wait();
+        delete worker;
+    }
+
+    delete s_pool;
+    s_pool = nullptr;
+}
+
+void ParallelFor(int count, int minChunk, const std::function<void(int begin, int end)>& func)
+{
+    if (count <= 0)
+        return;
+
+    int const nchunks = std::min(wxThread::GetCPUCount(), count / std::max(minChunk, 1));
+    ParallelForPool *pool = s_pool;
+
+    if (nchunks > 1 && pool && !pool->workers.empty())
+    {
+        wxMutexLocker lck(pool->lock);
+
+        if (!pool->inUse)
+        {
+            pool->inUse = true;
+            pool->func = &func;
+            pool->count = count;
+            pool->nchunks = nchunks;
+            pool->nextChunk = 0;
+            pool->pending = nchunks;
+            ++pool->generation;
+            pool->workReady.Broadcast();
+
+            pool->RunChunks();
+
+            while (pool->pending > 0)
+                pool->workDone.Wait();
+
+            pool->func = nullptr;
+            pool->inUse = false;
+            return;
+        }
+    }
+
+    // no pool, or it is busy with another call
+    func(0, count);
+}
@@ -0,0 +1,56 @@
+/*
+ *  parallel_for.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PARALLEL_FOR_INCLUDED
+#define PARALLEL_FOR_INCLUDED
+
+#include <functional>
+
+//
+// Splits the range [0, count) into contiguous chunks and runs func(begin, end) on
+// each chunk, one chunk per CPU core. The chunks are shared between the calling
+// thread and a pool of worker threads started once by ParallelForInit, and the call
+// returns when all chunks are done. Chunks hold at least minChunk items, so small
+// ranges run entirely on the calling thread.
+//
+// The pool runs one ParallelFor at a time. A call made while the pool is busy, from
+// another thread or from inside func, runs the whole range on its calling thread.
+//
+// func must be safe to call concurrently for disjoint ranges.
+//
+extern void ParallelFor(int count, int minChunk, const std::function<void(int begin, int end)>& func);
+
+extern void ParallelForInit();
+extern void ParallelForDestroy();
+
+#endif // PARALLEL_FOR_INCLUDED
@@ -34,6 +34,8 @@
 
 #include "phd.h"
 
+#include "image_kernels.h"
+#include "parallel_for.h"
 #include "phdupdate.h"
 
 #include <curl/curl.h>
@@ -59,6 +61,7 @@ GuideCamera *pCamera = nullptr;
 
 DebugLog Debug;
 GuidingLog GuideLog;
+TraceLog Trace;
 
 int XWinSize = 640;
 int YWinSize = 512;
@@ -437,14 +440,20 @@ static void OpenLogs(bool rollover)
     Debug.Write(wxString::Format("   opencv %s\n", CV_VERSION));
 #endif
 
+    // the trace log checks the size of the guide log when it is opened, so open it
+    // before the guide log
     if (rollover)
     {
         bool guideEnabled = GuideLog.IsEnabled();
         GuideLog.CloseGuideLog();
+        Trace.Open(wxGetApp().GetLogFileTime());
         GuideLog.EnableLogging(guideEnabled);
     }
     else
+    {
+        Trace.Open(wxGetApp().GetLogFileTime());
         GuideLog.EnableLogging(true);
+    }
 }
 
 struct LogToStderr
@@ -575,6 +584,9 @@ bool PhdApp::OnInit()
 
     logger.Close(); // writes any deferrred error messages to the debug log
 
+    // write out the queued debug log records if we crash (see OnFatalException)
+    wxHandleFatalExceptions();
+
 #if defined(__WINDOWS__)
     HRESULT hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
     Debug.Write(wxString::Format("CoInitializeEx returns %x\n", hr));
@@ -621,11 +633,15 @@ bool PhdApp::OnInit()
 
     Debug.RemoveOldFiles();
     GuideLog.RemoveOldFiles();
+    Trace.RemoveOldFiles();
 
     pConfig->InitializeProfile();
 
     PhdController::OnAppInit();
 
+    ImagePool::Init();
+    ParallelForInit();
+    Debug.Write(wxString::Format("Image kernels: %s\n", GetImageKernels().name));
     ImageLogger::Init();
 
     wxImage::AddHandler(new wxJPEGHandler);
@@ -645,6 +661,15 @@ bool PhdApp::OnInit()
     return true;
 }
 
+// Called on a crash (access violation, abort, ...). The debug log is written
+// by a background thread, so get the last records into the file before the
+// process goes away. Nothing else is logged here: Debug.Write allocates and
+// can block on the log lock, neither of which is safe in a crash handler.
+void PhdApp::OnFatalException()
+{
+    Debug.FlushOnCrash();
+}
+
 int PhdApp::OnExit()
 {
     assert(!pMount);
@@ -652,6 +677,8 @@ int PhdApp::OnExit()
     assert(!pCamera);
 
     ImageLogger::Destroy();
+    ParallelForDestroy();
+    ImagePool::Destroy();
 
     PhdController::OnAppExit();
 
@@ -663,6 +690,8 @@ int PhdApp::OnExit()
     delete m_instanceChecker;
     m_instanceChecker = nullptr;
 
+    Debug.Shutdown();
+
     return wxApp::OnExit();
 }
 
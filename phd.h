@@ -135,7 +135,7 @@ WX_DEFINE_ARRAY_DOUBLE(double, ArrayOfDbl);
 #define THROW_INFO_BASE(intro, file, line) intro " " file ":" TOSTRING(line)
 #define LOG_INFO(s) (Debug.AddLine(wxString(THROW_INFO_BASE("At", __FILE__, __LINE__) "->" s)))
 #define THROW_INFO(s) (Debug.AddLine(wxString(THROW_INFO_BASE("Throw from", __FILE__, __LINE__) "->" s)))
-#define ERROR_INFO(s) (Debug.AddLine(wxString(THROW_INFO_BASE("Error thrown from", __FILE__, __LINE__) "->" s)))
+#define ERROR_INFO(s) (Debug.AddErrorLine(wxString(THROW_INFO_BASE("Error thrown from", __FILE__, __LINE__) "->" s)))
 
 #if defined (__WINDOWS__)
 #define PHD_MESSAGES_CATALOG "messages"
@@ -154,10 +154,13 @@ WX_DEFINE_ARRAY_DOUBLE(double, ArrayOfDbl);
 #include "phdconfig.h"
 #include "configdialog.h"
 #include "optionsbutton.h"
+#include "image_pool.h"
 #include "usImage.h"
+#include "display_renderer.h"
 #include "point.h"
 #include "star.h"
 #include "circbuf.h"
+#include "spsc_ring.h"
 #include "guidinglog.h"
 #include "graph.h"
 #include "statswindow.h"
@@ -182,8 +185,11 @@ WX_DEFINE_ARRAY_DOUBLE(double, ArrayOfDbl);
 #include "gear_dialog.h"
 #include "myframe.h"
 #include "debuglog.h"
+#include "trace_log.h"
 #include "worker_thread.h"
+#include "status_block.h"
 #include "event_server.h"
+#include "frame_stream.h"
 #include "confirm_dialog.h"
 #include "phdcontrol.h"
 #include "runinbg.h"
@@ -228,6 +234,7 @@ public:
     PhdApp();
     bool OnInit();
     int OnExit();
+    void OnFatalException() override;
     void OnInitCmdLine(wxCmdLineParser& parser);
     bool OnCmdLineParsed(wxCmdLineParser & parser);
     void TerminateApp();
@@ -765,6 +765,7 @@ Mount::MOVE_RESULT Scope::MoveAxis(GUIDE_DIRECTION direction, int duration, unsi
             {
                 throw ERROR_INFO("guide failed");
             }
+            Trace.Pulse(direction, duration);
         }
     }
     catch (const wxString& Msg)
@@ -120,6 +120,10 @@ bool MyFrame::StartServer(bool state)
             return true;
         }
 
+        // the frame stream is opt-in and optional; the server runs without it
+        if (pConfig->Global.GetBoolean("/server/frame_stream", false))
+            FrameStream.Start(instanceNumber);
+
         Debug.AddLine(wxString::Format("Server started, listening on port %u", port));
         StatusMsg(_("Server started"));
     }
@@ -134,6 +138,7 @@ bool MyFrame::StartServer(bool state)
         std::for_each(s_clients.begin(), s_clients.end(), std::mem_fn(&wxSocketBase::Destroy));
         s_clients.empty();
         EvtServer.EventServerStop();
+        FrameStream.Stop();
         delete SocketServer;
         SocketServer = nullptr;
         StatusMsg(_("Server stopped"));
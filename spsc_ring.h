@@ -0,0 +1,81 @@
+/*
+ *  spsc_ring.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef SPSC_RING_INCLUDED
+#define SPSC_RING_INCLUDED
+
+#include <atomic>
+
+// Fixed-capacity ring buffer for handing items from exactly one producer thread
+// to exactly one consumer thread without locking. push() may only be called by
+// the producer and pop() only by the consumer; size() may be called by either.
+template<typename T, unsigned int N>
+class spsc_ring
+{
+    T m_ary[N];
+    std::atomic<unsigned int> m_head;   // next slot to write, advanced by the producer
+    std::atomic<unsigned int> m_tail;   // next slot to read, advanced by the consumer
+    static_assert(N != 0 && (N & (N - 1)) == 0, "capacity must be a power of 2 so the indexes wrap cleanly");
+public:
+    spsc_ring() : m_head(0), m_tail(0) { }
+    bool push(const T& t);
+    bool pop(T *t);
+    unsigned int size() const { return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire); }
+    unsigned int capacity() const { return N; }
+};
+
+// returns false if the ring is full
+template<typename T, unsigned int N>
+bool spsc_ring<T, N>::push(const T& t)
+{
+    unsigned int const head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) == N)
+        return false;
+    m_ary[head % N] = t;
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+// returns false if the ring is empty
+template<typename T, unsigned int N>
+bool spsc_ring<T, N>::pop(T *t)
+{
+    unsigned int const tail = m_tail.load(std::memory_order_relaxed);
+    if (m_head.load(std::memory_order_acquire) == tail)
+        return false;
+    *t = m_ary[tail % N];
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+#endif
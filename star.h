@@ -85,6 +85,13 @@ public:
 
 private:
     FindResult m_lastFindResult;
+
+    // background estimate from the previous Find, used to warm-start the sigma
+    // clipping of the background annulus on the next frame: the clipped mean
+    // and the unclipped sigma, which sets the clip window like a cold start
+    double m_bgMean;
+    double m_bgRawSigma;
+    bool m_bgValid;
 };
 
 inline Star::FindResult Star::GetError(void) const
@@ -92,6 +99,19 @@ inline Star::FindResult Star::GetError(void) const
     return m_lastFindResult;
 }
 
+// Settings used by GuideStar::AutoFind. They are read once on the GUI thread
+// (Guider::GetAutoFindParams) so that a search running on a background thread
+// touches nothing but its own copy of the frame.
+struct AutoFindParams
+{
+    unsigned int downsample;        // 0 = auto, chosen from the pixel scale
+    double pixelScale;
+    double minHFD;
+    double minSNR;
+    bool saturationByADU;
+    unsigned short saturationADU;
+};
+
 class GuideStar : public Star
 {
 public:
@@ -103,8 +123,8 @@ public:
     GuideStar();
     GuideStar(const Star* star);
 
-    bool AutoFind(const usImage& image, int extraEdgeAllowance, int searchRegion, const wxRect& roi,
-        std::vector<GuideStar>& foundStars, int maxStars);
+    bool AutoFind(const usImage& image, const AutoFindParams& params, int extraEdgeAllowance, int searchRegion,
+        const wxRect& roi, std::vector<GuideStar>& foundStars, int maxStars);
 };
 
 #endif /* STAR_H_INCLUDED */
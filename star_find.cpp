@@ -0,0 +1,567 @@
+/*
+ *  star_find.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "star_find.h"
+
+#include <algorithm>
+#include <functional>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+// background is measured in the annulus with inner radius STAR_APERTURE and outer
+// radius STAR_ANNULUS around the peak; the star itself is measured in the aperture
+enum
+{
+    STAR_APERTURE = 7,
+    STAR_ANNULUS = 12,
+};
+
+// Row extents of the background annulus: for row offset dy from the peak, the
+// annulus pixels are those with inner < |dx| <= outer. inner is -1 for the rows
+// that do not intersect the aperture.
+struct AnnulusTable
+{
+    struct Row
+    {
+        int inner;
+        int outer;
+    } rows[2 * STAR_ANNULUS + 1];
+
+    AnnulusTable()
+    {
+        int const A2 = STAR_APERTURE * STAR_APERTURE;
+        int const B2 = STAR_ANNULUS * STAR_ANNULUS;
+
+        for (int dy = -STAR_ANNULUS; dy <= STAR_ANNULUS; dy++)
+        {
+            Row& row = rows[dy + STAR_ANNULUS];
+            int const dy2 = dy * dy;
+            row.outer = 0;
+            while ((row.outer + 1) * (row.outer + 1) + dy2 <= B2)
+                ++row.outer;
+            row.inner = -1;
+            if (dy2 <= A2)
+            {
+                row.inner = 0;
+                while ((row.inner + 1) * (row.inner + 1) + dy2 <= A2)
+                    ++row.inner;
+            }
+        }
+    }
+};
+
+static const AnnulusTable& GetAnnulusTable()
+{
+    static const AnnulusTable s_table;
+    return s_table;
+}
+
+// helper struct for HFR calculation
+struct R2M
+{
+    double r2;
+    int x;
+    int y;
+    double m;
+    R2M() { }
+    R2M(int x_, int y_, double m_) : x(x_), y(y_), m(m_) { }
+    bool operator<(const R2M& rhs) const { return r2 < rhs.r2; }
+    bool operator>(const R2M& rhs) const { return r2 > rhs.r2; }
+};
+
+// upper bound on the number of pixels in the aperture
+enum { MAX_APERTURE_PIXELS = (2 * STAR_APERTURE + 1) * (2 * STAR_APERTURE + 1) };
+
+static double hfr(R2M *vec, unsigned int n, double cx, double cy, double mass)
+{
+    if (n == 1) // hot pixel?
+        return 0.25;
+
+    // compute Half Flux Radius (HFR)
+    for (unsigned int i = 0; i < n; i++)
+    {
+        double dx = (double) vec[i].x - cx;
+        double dy = (double) vec[i].y - cy;
+        vec[i].r2 = dx * dx + dy * dy;
+    }
+
+    // Only the pixels inside the half-flux radius need to be visited in order of
+    // ascending radius^2, so rather than sorting the whole aperture, build a
+    // min-heap and pop pixels off it until half the mass is accounted for
+    std::greater<R2M> cmp;
+    std::make_heap(vec, vec + n, cmp);
+
+    // find radius of half-mass
+    double r20, r21, m0, m1;
+    r20 = r21 = m0 = m1 = 0.0;
+    double halfm = 0.5 * mass;
+    for (R2M *end = vec + n; end != vec; --end)
+    {
+        std::pop_heap(vec, end, cmp);
+        const R2M& rm = *(end - 1);
+        r20 = r21;
+        m0 = m1;
+        r21 = rm.r2;
+        m1 += rm.m;
+        if (m1 > halfm)
+            break;
+    }
+
+    // interpolate
+    double hfr;
+    if (m1 > m0)
+    {
+        double r0 = sqrt(r20), r1 = sqrt(r21);
+        double s = (r1 - r0) / (m1 - m0);
+        hfr = r0 + s * (halfm - m0);
+    }
+    else
+        hfr = 0.25;
+
+    return hfr;
+}
+
+// formats a diagnostic message for the caller's log
+static void Log(StarFindLog log, const char *fmt, ...)
+{
+    if (!log)
+        return;
+
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+
+    log(buf);
+}
+
+bool MeasureStar(StarMeasurement *m, StarBackground *bg, const StarFindImage& img, int searchRegion,
+                 int base_x, int base_y, bool findPeak, double minHFD, unsigned short maxADU, StarFindLog log)
+{
+    int const minx = img.minx;
+    int const miny = img.miny;
+    int const maxx = img.maxx;
+    int const maxy = img.maxy;
+
+    // search region bounds
+    int start_x = std::max(base_x - searchRegion, minx);
+    int end_x   = std::min(base_x + searchRegion, maxx);
+    int start_y = std::max(base_y - searchRegion, miny);
+    int end_y   = std::min(base_y + searchRegion, maxy);
+
+    if (end_x <= start_x || end_y <= start_y)
+        return false;
+
+    m->result = STAR_FIND_OK;
+    m->x = base_x;
+    m->y = base_y;
+    m->hfd = 0.;
+
+    const unsigned short *imgdata = img.pixels;
+    int rowsize = img.rowsize;
+
+    int peak_x = 0, peak_y = 0;
+    unsigned int peak_val = 0;
+    unsigned short max3[3] = { 0, 0, 0 };
+
+    if (findPeak)
+    {
+        for (int y = start_y; y <= end_y; y++)
+        {
+            for (int x = start_x; x <= end_x; x++)
+            {
+                unsigned short val = imgdata[y * rowsize + x];
+
+                if (val > peak_val)
+                {
+                    peak_val = val;
+                    peak_x = x;
+                    peak_y = y;
+                }
+            }
+        }
+
+        m->peakVal = peak_val;
+    }
+    else
+    {
+        // find the peak value within the search region using a smoothing function
+        // also check for saturation
+
+        for (int y = start_y + 1; y <= end_y - 1; y++)
+        {
+            for (int x = start_x + 1; x <= end_x - 1; x++)
+            {
+                unsigned short p = imgdata[y * rowsize + x];
+                unsigned int val =
+                    4 * (unsigned int) p +
+                    imgdata[(y - 1) * rowsize + (x - 1)] +
+                    imgdata[(y - 1) * rowsize + (x + 1)] +
+                    imgdata[(y + 1) * rowsize + (x - 1)] +
+                    imgdata[(y + 1) * rowsize + (x + 1)] +
+                    2 * imgdata[(y - 1) * rowsize + (x + 0)] +
+                    2 * imgdata[(y + 0) * rowsize + (x - 1)] +
+                    2 * imgdata[(y + 0) * rowsize + (x + 1)] +
+                    2 * imgdata[(y + 1) * rowsize + (x + 0)];
+
+                if (val > peak_val)
+                {
+                    peak_val = val;
+                    peak_x = x;
+                    peak_y = y;
+                }
+
+                if (p > max3[0])
+                    std::swap(p, max3[0]);
+                if (p > max3[1])
+                    std::swap(p, max3[1]);
+                if (p > max3[2])
+                    std::swap(p, max3[2]);
+            }
+        }
+
+        m->peakVal = max3[0];   // raw peak val
+        peak_val /= 16; // smoothed peak value
+    }
+
+    // meaure noise in the annulus with inner radius A and outer radius B
+    int const A = STAR_APERTURE;   // inner radius
+    int const B = STAR_ANNULUS;    // outer radius
+    int const A2 = A * A;
+
+    // collect the annulus pixels, in raster order, using the precomputed row
+    // extents of the annulus
+    unsigned short bgpx[(2 * B + 1) * (2 * B + 1)];
+    unsigned int nann = 0;
+
+    const AnnulusTable& annulus = GetAnnulusTable();
+
+    start_y = std::max(peak_y - B, miny);
+    end_y = std::min(peak_y + B, maxy);
+
+    const unsigned short *bgrow = imgdata + rowsize * start_y;
+    for (int y = start_y; y <= end_y; y++, bgrow += rowsize)
+    {
+        const AnnulusTable::Row& ar = annulus.rows[y - peak_y + B];
+        int const x0 = std::max(peak_x - ar.outer, minx);
+        int const x1 = std::min(peak_x + ar.outer, maxx);
+        for (int x = x0; x <= x1; x++)
+        {
+            int const dx = x - peak_x;
+
+            // skip over the aperture
+            if (dx >= -ar.inner && dx <= ar.inner)
+            {
+                x = peak_x + ar.inner;
+                continue;
+            }
+
+            bgpx[nann++] = bgrow[x];
+        }
+    }
+
+    // find the mean and stdev of the background
+
+    unsigned int nbg;
+    double mean_bg = 0., prev_mean_bg;
+    double sigma2_bg = 0.;
+    double sigma_bg = 0.;
+
+    // The clipping normally converges to within a fraction of an ADU of the
+    // previous frame's background, so the first pass clips around the
+    // previous mean, with a window set by the previous unclipped sigma just
+    // as a cold start's first clipped pass would be. The same pass measures
+    // the unclipped background; unless the mean and that sigma both agree
+    // with the previous frame, carry on exactly as a cold start from the
+    // unclipped estimate. If the window rejects nearly everything (the star
+    // moved onto a very different background), start over unclipped.
+    bool warm = bg->valid;
+    bool clip = warm;
+    if (warm)
+    {
+        mean_bg = bg->mean;
+        sigma_bg = bg->rawSigma;
+    }
+
+    double raw_mean_bg = 0.;
+    double raw_sigma_bg = 0.;
+    bool have_bg = false;
+
+    for (int iter = 0; iter < 9; iter++)
+    {
+        double sum = 0.0;
+        double a = 0.0;
+        double q = 0.0;
+        nbg = 0;
+
+        double const lo = mean_bg - 2.0 * sigma_bg;
+        double const hi = mean_bg + 2.0 * sigma_bg;
+
+        // unclipped statistics, accumulated alongside the clipped ones on the
+        // first pass of a warm start
+        double ra = 0.0;
+        double rq = 0.0;
+
+        for (unsigned int i = 0; i < nann; i++)
+        {
+            double const val = (double) bgpx[i];
+
+            if (warm)
+            {
+                double const k = (double) (i + 1);
+                double const ra0 = ra;
+                ra += (val - ra) / k;
+                rq += (val - ra0) * (val - ra);
+            }
+
+            if (clip && (val < lo || val > hi))
+                continue;
+
+            sum += val;
+            ++nbg;
+            double const k = (double) nbg;
+            double const a0 = a;
+            a += (val - a) / k;
+            q += (val - a0) * (val - a);
+        }
+
+        if (iter == 0 && nann > 1)
+        {
+            if (warm)
+            {
+                raw_mean_bg = ra;
+                raw_sigma_bg = sqrt(rq / (double) (nann - 1));
+            }
+            else
+            {
+                raw_mean_bg = a;
+                raw_sigma_bg = sqrt(q / (double) (nann - 1));
+            }
+        }
+
+        if (nbg < 10 && warm)
+        {
+            Log(log, "Star::Find: background changed, restart estimate. nbg=%u mean=%.1f sigma=%.1f\n",
+                nbg, mean_bg, sigma_bg);
+            warm = clip = false;
+            mean_bg = sigma_bg = 0.;
+            iter = -1;
+            continue;
+        }
+
+        if (nbg < 10) // only possible after the first iteration
+        {
+            Log(log, "Star::Find: too few background points! nbg=%u mean=%.1f sigma=%.1f\n",
+                nbg, mean_bg, sigma_bg);
+            break;
+        }
+
+        have_bg = true;
+
+        prev_mean_bg = mean_bg;
+        double const window_bg = sigma_bg;
+        mean_bg = sum / (double) nbg;
+        sigma2_bg = q / (double) (nbg - 1);
+        sigma_bg = sqrt(sigma2_bg);
+
+        if (warm)
+        {
+            warm = false;
+
+            if (fabs(mean_bg - prev_mean_bg) < 0.5 && fabs(raw_sigma_bg - window_bg) < 0.1 * window_bg)
+                break;
+
+            // the background changed: continue from the unclipped estimate,
+            // as a cold start does after its first pass
+            mean_bg = raw_mean_bg;
+            sigma_bg = raw_sigma_bg;
+            sigma2_bg = sigma_bg * sigma_bg;
+            continue;
+        }
+
+        if (clip && fabs(mean_bg - prev_mean_bg) < 0.5)
+            break;
+
+        clip = true;
+    }
+
+    if (have_bg)
+    {
+        bg->mean = mean_bg;
+        bg->rawSigma = raw_sigma_bg;
+        bg->valid = true;
+    }
+
+    unsigned short thresh;
+
+    double cx = 0.0;
+    double cy = 0.0;
+    double mass = 0.0;
+    unsigned int n;
+
+    R2M hfrvec[MAX_APERTURE_PIXELS];
+    unsigned int nhfr = 0;
+
+    if (findPeak)
+    {
+        mass = peak_val;
+        n = 1;
+        thresh = 0;
+    }
+    else
+    {
+        thresh = (unsigned short)(mean_bg + 3.0 * sigma_bg + 0.5);
+
+        // find pixels over threshold within aperture; compute mass and centroid
+
+        start_x = std::max(peak_x - A, minx);
+        end_x = std::min(peak_x + A, maxx);
+        start_y = std::max(peak_y - A, miny);
+        end_y = std::min(peak_y + A, maxy);
+
+        n = 0;
+
+        const unsigned short *row = imgdata + rowsize * start_y;
+        for (int y = start_y; y <= end_y; y++, row += rowsize)
+        {
+            int dy = y - peak_y;
+            int dy2 = dy * dy;
+            if (dy2 > A2)
+                continue;
+
+            for (int x = start_x; x <= end_x; x++)
+            {
+                int dx = x - peak_x;
+
+                // exclude points outside aperture
+                if (dx * dx + dy2 > A2)
+                    continue;
+
+                // exclude points below threshold
+                unsigned short val = row[x];
+                if (val < thresh)
+                    continue;
+
+                double const d = (double) val - mean_bg;
+
+                cx += dx * d;
+                cy += dy * d;
+                mass += d;
+                ++n;
+
+                hfrvec[nhfr++] = R2M(x, y, d);
+            }
+        }
+    }
+
+    m->mass = mass;
+
+    // SNR estimate from: Measuring the Signal-to-Noise Ratio S/N of the CCD Image of a Star or Nebula, J.H.Simonetti, 2004 January 8
+    //     http://www.phys.vt.edu/~jhs/phys3154/snr20040108.pdf
+    double const gain = .5; // electrons per ADU, nominal
+    m->snr = n > 0 ? mass / sqrt(mass / gain + sigma2_bg * (double) n * (1.0 + 1.0 / (double) nbg)) : 0.0;
+
+    double const LOW_SNR = 3.0;
+
+    // a few scattered pixels over threshold can give a false positive
+    // avoid this by requiring the smoothed peak value to be above the threshold
+    if (peak_val <= thresh && m->snr >= LOW_SNR)
+    {
+        Log(log, "Star::Find false star n=%u nbg=%u bg=%.1f sigma=%.1f thresh=%u peak=%u\n", n, nbg, mean_bg, sigma_bg, thresh, peak_val);
+        m->snr = LOW_SNR - 0.1;
+    }
+
+    if (mass < 10.0)
+    {
+        m->result = STAR_FIND_LOWMASS;
+        return true;
+    }
+
+    if (m->snr < LOW_SNR)
+    {
+        m->result = STAR_FIND_LOWSNR;
+        return true;
+    }
+
+    m->x = peak_x + cx / mass;
+    m->y = peak_y + cy / mass;
+
+    m->hfd = 2.0 * hfr(hfrvec, nhfr, m->x, m->y, mass);
+
+    if (m->hfd < minHFD && !findPeak)
+    {
+        m->result = STAR_FIND_LOWHFD;
+        return true;
+    }
+
+    // check for saturation
+
+    unsigned int mx = (unsigned int) max3[0];
+
+    // remove pedestal
+    if (mx >= img.pedestal)
+        mx -= img.pedestal;
+    else
+        mx = 0; // unlikely
+
+    if (maxADU > 0)
+    {
+        // maxADU is known
+        if (mx >= maxADU)
+            m->result = STAR_FIND_SATURATED;
+        return true;
+    }
+
+    // maxADU not known, use the "flat-top" hueristic
+    //
+    // even at saturation, the max values may vary a bit due to noise
+    // Call it saturated if the the top three values are within 32 parts per 65535 of max for 16-bit cameras,
+    // or within 1 part per 191 for 8-bit cameras
+    unsigned int d = (unsigned int) (max3[0] - max3[2]);
+
+    if (img.bitsPerPixel < 12)
+    {
+        if (d * 191U < 1U * mx)
+            m->result = STAR_FIND_SATURATED;
+    }
+    else
+    {
+        if (d * 65535U < 32U * mx)
+            m->result = STAR_FIND_SATURATED;
+    }
+
+    return true;
+}
@@ -0,0 +1,98 @@
+/*
+ *  star_find.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef STAR_FIND_INCLUDED
+#define STAR_FIND_INCLUDED
+
+//
+// The measurement behind Star::Find: find the peak in the search region, estimate
+// the background in an annulus around it, and take the centroid, mass, SNR and
+// HFD of the pixels over threshold in the aperture. There are no wxWidgets types
+// here so it can be benchmarked on its own; Star::Find keeps the Star state and
+// the error handling.
+//
+
+// the pixels Star::Find may look at
+struct StarFindImage
+{
+    const unsigned short *pixels;
+    int rowsize;                // width of the frame
+    int minx;                   // the subframe, or the whole frame (inclusive)
+    int miny;
+    int maxx;
+    int maxy;
+    unsigned short pedestal;
+    int bitsPerPixel;
+};
+
+// background from the previous frame, used to warm-start the sigma clipping of the
+// background annulus on the next: the clipped mean and the unclipped sigma, which
+// sets the clip window like a cold start
+struct StarBackground
+{
+    double mean;
+    double rawSigma;
+    bool valid;
+};
+
+// the same outcomes as the matching Star::FindResult values
+enum StarFindResult
+{
+    STAR_FIND_OK,
+    STAR_FIND_SATURATED,
+    STAR_FIND_LOWSNR,
+    STAR_FIND_LOWMASS,
+    STAR_FIND_LOWHFD,
+};
+
+struct StarMeasurement
+{
+    StarFindResult result;
+    double x;                   // the centroid, or the search position if no star was found
+    double y;
+    double mass;
+    double snr;
+    double hfd;
+    unsigned short peakVal;     // raw peak value
+};
+
+// receives the diagnostic messages, one line each
+typedef void (*StarFindLog)(const char *msg);
+
+// Returns false if the search region does not overlap the usable area; bg is
+// updated for the next frame. log may be null.
+extern bool MeasureStar(StarMeasurement *m, StarBackground *bg, const StarFindImage& img, int searchRegion,
+                        int base_x, int base_y, bool findPeak, double minHFD, unsigned short maxADU, StarFindLog log);
+
+#endif // STAR_FIND_INCLUDED
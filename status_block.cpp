@@ -0,0 +1,217 @@
+/*
+ *  status_block.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+
+#include <atomic>
+#include <stddef.h>
+
+#ifndef __WINDOWS__
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
+static_assert(sizeof(STATUS_BLOCK) == 160, "status block layout must not be padded");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "seq must be usable as an atomic");
+
+StatusBlock::StatusBlock()
+    : m_blk(nullptr)
+#ifdef __WINDOWS__
+    , m_mapping(nullptr)
+#endif
+{
+    memset(&m_staged, 0, sizeof(m_staged));
+}
+
+StatusBlock::~StatusBlock()
+{
+    Close();
+}
+
+bool StatusBlock::Open(unsigned int instanceId)
+{
+    if (m_blk)
+        return false;
+
+    void *p;
+
+#ifdef __WINDOWS__
+    wxString name = wxString::Format("Local\\PHD2Status%u", instanceId);
+    m_mapping = CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(STATUS_BLOCK),
+        name.wc_str());
+    if (!m_mapping)
+    {
+        Debug.Write(wxString::Format("status block: CreateFileMapping failed, err %lu\n", GetLastError()));
+        return true;
+    }
+    p = MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, sizeof(STATUS_BLOCK));
+    if (!p)
+    {
+        Debug.Write(wxString::Format("status block: MapViewOfFile failed, err %lu\n", GetLastError()));
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+        return true;
+    }
+#else
+    wxString name = wxString::Format("/phd2-status-%u", instanceId);
+    // a segment left behind by a crashed run may have a different size or
+    // owner, so never attach to it; readers still mapping it keep their copy
+    shm_unlink(name.c_str());
+    // writable by us, read-only for everyone else
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd == -1)
+    {
+        Debug.Write(wxString::Format("status block: shm_open %s failed, errno %d\n", name, errno));
+        return true;
+    }
+    if (ftruncate(fd, sizeof(STATUS_BLOCK)) == -1)
+    {
+        Debug.Write(wxString::Format("status block: ftruncate failed, errno %d\n", errno));
+        close(fd);
+        shm_unlink(name.c_str());
+        return true;
+    }
+    p = mmap(nullptr, sizeof(STATUS_BLOCK), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+    {
+        Debug.Write(wxString::Format("status block: mmap failed, errno %d\n", errno));
+        shm_unlink(name.c_str());
+        return true;
+    }
+    m_name = name;
+#endif
+
+    m_blk = static_cast<STATUS_BLOCK *>(p);
+
+    memset(&m_staged, 0, sizeof(m_staged));
+    m_staged.magic = STATUS_BLOCK_MAGIC;
+    m_staged.version = STATUS_BLOCK_VERSION;
+    m_staged.size = sizeof(STATUS_BLOCK);
+    m_staged.pid = (uint32_t) wxGetProcessId();
+    m_staged.raDirection = m_staged.decDirection = -1;
+
+#ifdef __WINDOWS__
+    // the mapping outlives us while a client has it open; keep its sequence
+    // count so that client sees the change
+    m_staged.seq = m_blk->seq & ~1u;
+#endif
+
+    Publish();
+
+    Debug.Write(wxString::Format("status block %s opened\n", name));
+
+    return false;
+}
+
+void StatusBlock::Close()
+{
+    if (!m_blk)
+        return;
+
+#ifdef __WINDOWS__
+    UnmapViewOfFile(m_blk);
+    CloseHandle(m_mapping);
+    m_mapping = nullptr;
+#else
+    munmap(m_blk, sizeof(STATUS_BLOCK));
+    shm_unlink(m_name.c_str());
+#endif
+
+    m_blk = nullptr;
+}
+
+void StatusBlock::SetGuideStep(const GuideStepInfo& step)
+{
+    if (!m_blk)
+        return;
+
+    m_staged.stepFrame = step.frameNumber;
+    m_staged.stepTime = step.time;
+    m_staged.dx = step.cameraOffset.X;
+    m_staged.dy = step.cameraOffset.Y;
+    m_staged.raDistance = step.mountOffset.X;
+    m_staged.decDistance = step.mountOffset.Y;
+    m_staged.raDuration = step.durationRA;
+    m_staged.decDuration = step.durationDec;
+    m_staged.raDirection = step.durationRA > 0 ? (int8_t) step.directionRA : -1;
+    m_staged.decDirection = step.durationDec > 0 ? (int8_t) step.directionDec : -1;
+}
+
+void StatusBlock::Publish()
+{
+    if (!m_blk)
+        return;
+
+    STATUS_BLOCK& s = m_staged;
+
+    s.updateTime = ::wxGetUTCTimeMillis().GetValue();
+    s.appState = Guider::GetExposedState();
+
+    Guider *guider = pFrame ? pFrame->pGuider : nullptr;
+    if (guider)
+    {
+        const usImage *img = guider->CurrentImage();
+        if (img)
+            s.frameNumber = img->FrameNum;
+
+        const PHD_Point& lock = guider->LockPosition();
+        s.lockValid = lock.IsValid();
+        s.lockX = s.lockValid ? lock.X : 0.0;
+        s.lockY = s.lockValid ? lock.Y : 0.0;
+
+        const PHD_Point& star = guider->CurrentPosition();
+        s.starValid = star.IsValid();
+        s.starX = s.starValid ? star.X : 0.0;
+        s.starY = s.starValid ? star.Y : 0.0;
+        s.snr = guider->SNR();
+        s.hfd = guider->HFD();
+        s.starMass = guider->StarMass();
+        s.starError = guider->StarError();
+    }
+
+    // seqlock write: make seq odd, update, make it even again. Readers retry if
+    // they see an odd count or the count changes while they copy.
+    std::atomic<uint32_t> *seq = reinterpret_cast<std::atomic<uint32_t> *>(&m_blk->seq);
+    uint32_t const n = s.seq;
+    seq->store(n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    memcpy(m_blk, &s, offsetof(STATUS_BLOCK, seq));
+    memcpy(&m_blk->pid, &s.pid, sizeof(STATUS_BLOCK) - offsetof(STATUS_BLOCK, pid));
+
+    seq->store(n + 2, std::memory_order_release);
+    s.seq = n + 2;
+}
@@ -0,0 +1,69 @@
+/*
+ *  status_block.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef STATUS_BLOCK_H_INCLUDED
+#define STATUS_BLOCK_H_INCLUDED
+
+#include "status_block_format.h"
+
+struct GuideStepInfo;
+
+/*
+ * Writer side of the shared-memory status block (see status_block_format.h).
+ * The whole block is published under the seqlock once per frame and again as
+ * soon as a guide step is recorded.
+ */
+class StatusBlock
+{
+    STATUS_BLOCK *m_blk;
+    STATUS_BLOCK m_staged;
+#ifdef __WINDOWS__
+    HANDLE m_mapping;
+#else
+    wxString m_name;
+#endif
+
+public:
+    StatusBlock();
+    ~StatusBlock();
+
+    bool Open(unsigned int instanceId);
+    void Close();
+    bool IsOpen() const { return m_blk != nullptr; }
+
+    void SetGuideStep(const GuideStepInfo& step);
+    void Publish();
+};
+
+#endif
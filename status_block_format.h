@@ -0,0 +1,123 @@
+/*
+ *  status_block_format.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef STATUS_BLOCK_FORMAT_H_INCLUDED
+#define STATUS_BLOCK_FORMAT_H_INCLUDED
+
+// Layout of the shared-memory status block published by the event server
+// (server setting /server/status_block). Local clients map it read-only to
+// poll guiding state without an RPC round trip. This header must not depend on
+// wxWidgets so clients can include it.
+//
+// The block is named "/phd2-status-<instance>" (POSIX shm_open) or
+// "Local\PHD2Status<instance>" (Windows file mapping), native byte order.
+//
+// Readers must follow the seqlock protocol: read seq, retry while it is odd,
+// copy the block, then read seq again and retry if it changed. Use acquire
+// ordering on the seq reads (status_block_read below does this).
+
+#include <stdint.h>
+#include <string.h>
+
+#define STATUS_BLOCK_MAGIC 0x53444850u // "PHDS"
+
+enum
+{
+    STATUS_BLOCK_VERSION = 1,
+};
+
+struct STATUS_BLOCK
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;              // sizeof(STATUS_BLOCK)
+    uint32_t seq;               // odd while an update is in progress
+    uint32_t pid;               // PHD2 process id
+
+    int64_t updateTime;         // milliseconds since 1970-01-01 UTC
+    int32_t appState;           // 0 Stopped, 1 Selected, 2 Calibrating, 3 Guiding,
+                                // 4 LostLock, 5 Paused, 6 Looping
+    uint32_t frameNumber;
+
+    // lock position and current star position, camera pixels
+    uint8_t lockValid;
+    uint8_t starValid;
+    uint8_t reserved1[6];
+    double lockX;
+    double lockY;
+    double starX;
+    double starY;
+    double snr;
+    double hfd;
+    double starMass;
+    int32_t starError;          // 0 if the star was found in the last frame
+
+    // last guide step
+    uint32_t stepFrame;         // 0 if there has been no guide step
+    double stepTime;            // seconds since guiding started
+    double dx;                  // camera offset, pixels
+    double dy;
+    double raDistance;          // mount offset, pixels
+    double decDistance;
+    int32_t raDuration;         // ms
+    int32_t decDuration;
+    int8_t raDirection;         // GUIDE_DIRECTION, -1 if none
+    int8_t decDirection;
+    uint8_t reserved2[6];
+};
+
+#ifdef __cplusplus
+#include <atomic>
+
+// Take a consistent snapshot of a mapped status block. Returns false if the
+// writer was mid-update on every try.
+inline static bool status_block_read(const STATUS_BLOCK *blk, STATUS_BLOCK *out, int tries = 100)
+{
+    const volatile uint32_t *seq = &blk->seq;
+    while (tries-- > 0)
+    {
+        uint32_t const s1 = *seq;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s1 & 1)
+            continue;
+        memcpy(out, (const void *) blk, sizeof(*out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (*seq == s1)
+            return true;
+    }
+    return false;
+}
+#endif
+
+#endif
@@ -0,0 +1,491 @@
+/*
+ *  autofind_test.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+// Checks that the striped, parallel AutoFind image pipeline picks the same guide
+// star candidates as the serial scan it replaced, on the test frames in the tree
+// and on a crowded synthetic field. The candidates are everything AutoFind takes
+// from the image before it measures them with Star::Find, so equal candidate
+// lists mean equal star lists.
+
+#include <gtest/gtest.h>
+#include "autofind_peaks.h"
+#include "median3.h"
+#include "parallel_for.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ParallelFor for the test: the range is split into s_threads chunks (fewer if
+// that would make them smaller than minChunk), each run on its own thread, so the
+// stripe boundaries move with the thread count
+static int s_threads = 1;
+
+void ParallelFor(int count, int minChunk, const std::function<void(int begin, int end)>& func)
+{
+    int nchunks = std::min(s_threads, count / std::max(minChunk, 1));
+    if (nchunks < 2)
+    {
+        func(0, count);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < nchunks; i++)
+        threads.emplace_back(func, (int)((long long) count * i / nchunks), (int)((long long) count * (i + 1) / nchunks));
+    func(0, (int)((long long) count / nchunks));
+    for (std::thread& t : threads)
+        t.join();
+}
+
+struct Frame
+{
+    int width;
+    int height;
+    std::vector<unsigned short> px;
+};
+
+// reads the 16 bit images PHD2 saves: a primary HDU with BITPIX 16 and BZERO 32768
+static bool ReadFits(Frame *frame, const std::string& path)
+{
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (!fp)
+        return false;
+
+    int bitpix = 0, naxis = 0, bzero = 0;
+    frame->width = frame->height = 0;
+
+    char card[81];
+    card[80] = 0;
+    long hdrlen = 0;
+    bool end = false;
+    while (!end && fread(card, 80, 1, fp) == 1)
+    {
+        hdrlen += 80;
+        if (strncmp(card, "END ", 4) == 0)
+            end = true;
+        else if (strncmp(card, "BITPIX  =", 9) == 0)
+            bitpix = atoi(card + 10);
+        else if (strncmp(card, "NAXIS   =", 9) == 0)
+            naxis = atoi(card + 10);
+        else if (strncmp(card, "NAXIS1  =", 9) == 0)
+            frame->width = atoi(card + 10);
+        else if (strncmp(card, "NAXIS2  =", 9) == 0)
+            frame->height = atoi(card + 10);
+        else if (strncmp(card, "BZERO   =", 9) == 0)
+            bzero = atoi(card + 10);
+    }
+
+    bool ok = end && bitpix == 16 && naxis == 2 && bzero == 32768 && frame->width > 0 && frame->height > 0;
+    if (ok)
+    {
+        // the data starts at the next 2880 byte block
+        fseek(fp, (hdrlen + 2879) / 2880 * 2880, SEEK_SET);
+        std::vector<unsigned char> raw(2 * frame->width * frame->height);
+        ok = fread(&raw[0], raw.size(), 1, fp) == 1;
+        frame->px.resize(frame->width * frame->height);
+        for (size_t i = 0; ok && i < frame->px.size(); i++)
+            frame->px[i] = (unsigned short)(((raw[2 * i] << 8) | raw[2 * i + 1]) ^ 0x8000);
+    }
+
+    fclose(fp);
+    return ok;
+}
+
+// the serial pipeline as it was before the rows were split into stripes
+
+static void OldPsfConv(FloatImg& dst, const FloatImg& src)
+{
+    dst.Init(src.width, src.height);
+
+    //                       A      B1     B2    C1     C2    C3     D1     D2     D3
+    const double PSF[] = { 0.906, 0.584, 0.365, .117, .049, -0.05, -.064, -.074, -.094 };
+
+    int const width = src.width;
+    int const height = src.height;
+
+    memset(dst.px, 0, src.NPixels * sizeof(float));
+
+    /* PSF Grid is:
+    D3 D3 D3 D3 D3 D3 D3 D3 D3
+    D3 D3 D3 D2 D1 D2 D3 D3 D3
+    D3 D3 C3 C2 C1 C2 C3 D3 D3
+    D3 D2 C2 B2 B1 B2 C2 D2 D3
+    D3 D1 C1 B1 A  B1 C1 D1 D3
+    D3 D2 C2 B2 B1 B2 C2 D2 D3
+    D3 D3 C3 C2 C1 C2 C3 D3 D3
+    D3 D3 D3 D2 D1 D2 D3 D3 D3
+    D3 D3 D3 D3 D3 D3 D3 D3 D3
+
+    1@A
+    4@B1, B2, C1, C3, D1
+    8@C2, D2
+    44 * D3
+    */
+
+    int psf_size = 4;
+
+    for (int y = psf_size; y < height - psf_size; y++)
+    {
+        for (int x = psf_size; x < width - psf_size; x++)
+        {
+            float A, B1, B2, C1, C2, C3, D1, D2, D3;
+
+#define PX(dx, dy) *(src.px + width * (y + (dy)) + x + (dx))
+            A =  PX(+0, +0);
+            B1 = PX(+0, -1) + PX(+0, +1) + PX(+1, +0) + PX(-1, +0);
+            B2 = PX(-1, -1) + PX(+1, -1) + PX(-1, +1) + PX(+1, +1);
+            C1 = PX(+0, -2) + PX(-2, +0) + PX(+2, +0) + PX(+0, +2);
+            C2 = PX(-1, -2) + PX(+1, -2) + PX(-2, -1) + PX(+2, -1) + PX(-2, +1) + PX(+2, +1) + PX(-1, +2) + PX(+1, +2);
+            C3 = PX(-2, -2) + PX(+2, -2) + PX(-2, +2) + PX(+2, +2);
+            D1 = PX(+0, -3) + PX(-3, +0) + PX(+3, +0) + PX(+0, +3);
+            D2 = PX(-1, -3) + PX(+1, -3) + PX(-3, -1) + PX(+3, -1) + PX(-3, +1) + PX(+3, +1) + PX(-1, +3) + PX(+1, +3);
+            D3 = PX(-4, -2) + PX(-3, -2) + PX(+3, -2) + PX(+4, -2) + PX(-4, -1) + PX(+4, -1) + PX(-4, +0) + PX(+4, +0) + PX(-4, +1) + PX(+4, +1) + PX(-4, +2) + PX(-3, +2) + PX(+3, +2) + PX(+4, +2);
+#undef PX
+            int i;
+            const float *uptr;
+
+            uptr = src.px + width * (y - 4) + (x - 4);
+            for (i = 0; i < 9; i++)
+                D3 += *uptr++;
+
+            uptr = src.px + width * (y - 3) + (x - 4);
+            for (i = 0; i < 3; i++)
+                D3 += *uptr++;
+            uptr += 3;
+            for (i = 0; i < 3; i++)
+                D3 += *uptr++;
+
+            uptr = src.px + width * (y + 3) + (x - 4);
+            for (i = 0; i < 3; i++)
+                D3 += *uptr++;
+            uptr += 3;
+            for (i = 0; i < 3; i++)
+                D3 += *uptr++;
+
+            uptr = src.px + width * (y + 4) + (x - 4);
+            for (i = 0; i < 9; i++)
+                D3 += *uptr++;
+
+            double mean = (A + B1 + B2 + C1 + C2 + C3 + D1 + D2 + D3) / 81.0;
+            double PSF_fit = PSF[0] * (A - mean) + PSF[1] * (B1 - 4.0 * mean) + PSF[2] * (B2 - 4.0 * mean) +
+                PSF[3] * (C1 - 4.0 * mean) + PSF[4] * (C2 - 8.0 * mean) + PSF[5] * (C3 - 4.0 * mean) +
+                PSF[6] * (D1 - 4.0 * mean) + PSF[7] * (D2 - 8.0 * mean) + PSF[8] * (D3 - 44.0 * mean);
+
+            dst.px[width * y + x] = (float) PSF_fit;
+        }
+    }
+}
+
+static void OldDownsample(FloatImg& dst, const FloatImg& src, int downsample)
+{
+    int width = src.width;
+    int dw = src.width / downsample;
+    int dh = src.height / downsample;
+
+    dst.Init(dw, dh);
+
+    float const d2 = downsample * downsample;
+
+    for (int yy = 0; yy < dh; yy++)
+    {
+        for (int xx = 0; xx < dw; xx++)
+        {
+            float sum = 0.0;
+            for (int j = 0; j < downsample; j++)
+                for (int i = 0; i < downsample; i++)
+                    sum += src.px[(yy * downsample + j) * width + xx * downsample + i];
+            float val = sum / d2;
+            dst.px[yy * dw + xx] = val;
+        }
+    }
+}
+
+static void OldGetStats(double *mean, double *stdev, const FloatImg& img, int left, int top, int w, int h)
+{
+    double sum = 0.0;
+    double a = 0.0;
+    double q = 0.0;
+    double k = 1.0;
+    double km1 = 0.0;
+
+    for (int y = top; y < top + h; y++)
+    {
+        for (int x = left; x < left + w; x++)
+        {
+            double const v = (double) img.px[y * img.width + x];
+            sum += v;
+            double const a0 = a;
+            a += (v - a) / k;
+            q += (v - a0) * (v - a);
+            km1 = k;
+            k += 1.0;
+        }
+    }
+
+    *mean = sum / km1;
+    *stdev = sqrt(q / km1);
+}
+
+static void OldAutoFindPeaks(std::set<AutoFindPeak>& stars, const unsigned short *image, int width, int height,
+                             int downsample, int searchRegion, int edgeDist)
+{
+    FloatImg conv(width, height);
+    for (unsigned int i = 0; i < conv.NPixels; i++)
+        conv.px[i] = (float) image[i];
+
+    if (downsample > 1)
+    {
+        FloatImg tmp;
+        OldDownsample(tmp, conv, downsample);
+        conv.Swap(tmp);
+    }
+
+    {
+        FloatImg tmp;
+        OldPsfConv(tmp, conv);
+        conv.Swap(tmp);
+    }
+
+    int const dw = conv.width;
+    int const cl = 4, ct = 4, cw = conv.width - 8, ch = conv.height - 8;
+    int const cr = cl + cw - 1, cb = ct + ch - 1;
+
+    stars.clear();
+
+    double global_mean, global_stdev;
+    OldGetStats(&global_mean, &global_stdev, conv, cl, ct, cw, ch);
+
+    const double threshold = 0.1;
+
+    // brute force 9x9 local maximum test, in raster order
+    int srch = 4;
+    for (int y = ct + srch; y <= cb - srch; y++)
+    {
+        for (int x = cl + srch; x <= cr - srch; x++)
+        {
+            float val = conv.px[dw * y + x];
+            bool ismax = false;
+            if (val > 0.0)
+            {
+                ismax = true;
+                for (int j = -srch; j <= srch; j++)
+                {
+                    for (int i = -srch; i <= srch; i++)
+                    {
+                        if (i == 0 && j == 0)
+                            continue;
+                        if (conv.px[dw * (y + j) + (x + i)] > val)
+                        {
+                            ismax = false;
+                            break;
+                        }
+                    }
+                }
+            }
+            if (!ismax)
+                continue;
+
+            const int local = 7;
+            double local_mean, local_stdev;
+            int const lx0 = std::max(x - local, cl), ly0 = std::max(y - local, ct);
+            int const lx1 = std::min(x + local, cr), ly1 = std::min(y + local, cb);
+            OldGetStats(&local_mean, &local_stdev, conv, lx0, ly0, lx1 - lx0 + 1, ly1 - ly0 + 1);
+
+            double h = (val - local_mean) / global_stdev;
+            if (h < threshold)
+                continue;
+
+            int imgx = x * downsample + downsample / 2;
+            int imgy = y * downsample + downsample / 2;
+
+            stars.insert(AutoFindPeak(imgx, imgy, h));
+            if (stars.size() > 100)
+                stars.erase(stars.begin());
+        }
+    }
+
+    // merge stars that are very close into a single star
+repeat:
+    for (std::set<AutoFindPeak>::const_iterator a = stars.begin(); a != stars.end(); ++a)
+    {
+        std::set<AutoFindPeak>::const_iterator b = a;
+        for (++b; b != stars.end(); ++b)
+        {
+            int dx = a->x - b->x;
+            int dy = a->y - b->y;
+            if (dx * dx + dy * dy < 5 * 5)
+            {
+                stars.erase(a);
+                goto repeat;
+            }
+        }
+    }
+
+    // exclude stars that would fit within a single searchRegion box
+    std::set<int> to_erase;
+    int const fullw = searchRegion + 5;
+    for (std::set<AutoFindPeak>::const_iterator a = stars.begin(); a != stars.end(); ++a)
+    {
+        std::set<AutoFindPeak>::const_iterator b = a;
+        for (++b; b != stars.end(); ++b)
+        {
+            if (abs(a->x - b->x) <= fullw && abs(a->y - b->y) <= fullw && b->val / a->val < 5.0)
+            {
+                to_erase.insert(std::distance(stars.begin(), a));
+                to_erase.insert(std::distance(stars.begin(), b));
+            }
+        }
+    }
+    std::vector<AutoFindPeak> keep;
+    int n = 0;
+    for (const AutoFindPeak& p : stars)
+        if (to_erase.find(n++) == to_erase.end())
+            keep.push_back(p);
+
+    // exclude stars too close to the edge
+    stars.clear();
+    for (const AutoFindPeak& p : keep)
+        if (!(p.x <= edgeDist || p.x >= width - edgeDist || p.y <= edgeDist || p.y >= height - edgeDist))
+            stars.insert(p);
+}
+
+static void ExpectSameStars(const std::set<AutoFindPeak>& want, const std::set<AutoFindPeak>& got)
+{
+    ASSERT_EQ(want.size(), got.size());
+    std::set<AutoFindPeak>::const_iterator a = want.begin(), b = got.begin();
+    for (; a != want.end(); ++a, ++b)
+    {
+        EXPECT_EQ(a->x, b->x);
+        EXPECT_EQ(a->y, b->y);
+        EXPECT_EQ(a->val, b->val);
+    }
+}
+
+static void CheckFrame(const Frame& f, bool expectStars)
+{
+    // AutoFind runs on the 3x3 median filtered frame
+    std::vector<unsigned short> smoothed(f.px.size());
+    FrameRect const whole = { 0, 0, f.width, f.height };
+    Median3Rows(&smoothed[0], &f.px[0], f.width, whole, 0, f.height);
+
+    static const int threads[] = { 1, 3, 8 };
+
+    for (int downsample = 1; downsample <= 3; downsample++)
+    {
+        for (int searchRegion : { 10, 15 })
+        {
+            int const edgeDist = searchRegion + 10;
+
+            std::set<AutoFindPeak> want;
+            OldAutoFindPeaks(want, &smoothed[0], f.width, f.height, downsample, searchRegion, edgeDist);
+            if (expectStars)
+                EXPECT_FALSE(want.empty());
+
+            for (int nthreads : threads)
+            {
+                SCOPED_TRACE(testing::Message() << "downsample " << downsample << " searchRegion " << searchRegion << " threads " << nthreads);
+
+                s_threads = nthreads;
+
+                FloatImg conv;
+                AutoFindConvolve(conv, &smoothed[0], f.width, f.height, downsample);
+
+                std::set<AutoFindPeak> got;
+                AutoFindPeaks(got, conv, downsample, f.width, f.height, searchRegion, edgeDist, nullptr);
+
+                ExpectSameStars(want, got);
+            }
+        }
+    }
+
+    s_threads = 1;
+}
+
+TEST(AutoFindTest, SaveTest)
+{
+    Frame f;
+    ASSERT_TRUE(ReadFits(&f, PHD_SRC_DIR "/savetest.fit"));
+    CheckFrame(f, true);
+}
+
+TEST(AutoFindTest, SaveTest2)
+{
+    Frame f;
+    ASSERT_TRUE(ReadFits(&f, PHD_SRC_DIR "/savetest2.fit"));
+    CheckFrame(f, true);
+}
+
+// far more local maxima than the 100 that are kept, spread over every stripe, and
+// enough close pairs to exercise the merge and exclusion passes
+TEST(AutoFindTest, CrowdedField)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> u(0., 1.);
+    std::normal_distribution<double> n(0., 1.);
+
+    Frame f;
+    f.width = 800;
+    f.height = 600;
+    std::vector<double> img(f.width * f.height, 1000.);
+
+    for (int s = 0; s < 400; s++)
+    {
+        double const cx = u(rng) * f.width, cy = u(rng) * f.height;
+        double const amp = 200. + 3000. * u(rng) * u(rng), sigma = 1. + u(rng);
+        int const x0 = std::max(0, (int) cx - 8), x1 = std::min(f.width - 1, (int) cx + 8);
+        int const y0 = std::max(0, (int) cy - 8), y1 = std::min(f.height - 1, (int) cy + 8);
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++)
+                img[y * f.width + x] += amp * exp(-((x - cx) * (x - cx) + (y - cy) * (y - cy)) / (2. * sigma * sigma));
+    }
+
+    f.px.resize(img.size());
+    for (size_t i = 0; i < img.size(); i++)
+        f.px[i] = (unsigned short) std::min(65535., std::max(0., img[i] + 10. * n(rng)));
+
+    CheckFrame(f, true);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,316 @@
+/*
+ *  defect_removal_test.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+// Checks the row-indexed defect correction behind RemoveDefects: defects that
+// are not next to each other must get the median of their bordering pixels in
+// the original frame, whatever the frame size, subframe and defect order, and
+// defects that are next to each other are corrected in the order documented at
+// RemoveDefectRow.
+
+#include <gtest/gtest.h>
+#include "image_preprocess.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+struct Rect
+{
+    int x, y, width, height;
+};
+
+// the median of the bordering pixels by sorting them: the mean of the middle
+// two of 8, or the middle one of 5 or 3
+static unsigned short NeighborMedian(const std::vector<unsigned short>& img, int w, int h, int x, int y)
+{
+    std::vector<unsigned short> nb;
+    for (int dy = -1; dy <= 1; dy++)
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            int const nx = x + dx, ny = y + dy;
+            if ((dx || dy) && nx >= 0 && nx < w && ny >= 0 && ny < h)
+                nb.push_back(img[ny * w + nx]);
+        }
+    std::sort(nb.begin(), nb.end());
+    size_t const n = nb.size();
+    if (n % 2 == 0)
+        return (unsigned short)(((unsigned int) nb[n / 2 - 1] + nb[n / 2]) / 2);
+    return nb[n / 2];
+}
+
+// what RemoveDefects does with a usImage: every row of the rect, top to bottom
+static void Correct(std::vector<unsigned short>& img, int w, int h, const DefectRowIndex& defects, const Rect& r)
+{
+    for (int y = r.y; y < r.y + r.height; y++)
+        RemoveDefectRow(img.data(), w, h, defects, y, r.x, r.x + r.width - 1);
+}
+
+// the order of correction documented at RemoveDefectRow, written out one pixel
+// at a time
+static void ReferenceCorrect(std::vector<unsigned short>& img, int w, int h, const std::set<std::pair<int, int>>& defects, const Rect& r)
+{
+    for (int y = r.y; y < r.y + r.height; y++)
+    {
+        std::vector<int> xs;
+        for (int x = r.x; x < r.x + r.width; x++)
+            if (defects.count(std::make_pair(x, y)))
+                xs.push_back(x);
+
+        if (y == 0 || y == h - 1)
+        {
+            for (int x : xs)
+                img[y * w + x] = NeighborMedian(img, w, h, x, y);
+            continue;
+        }
+
+        if (!xs.empty() && xs.front() == 0)
+            img[y * w] = NeighborMedian(img, w, h, 0, y);
+
+        std::vector<unsigned short> const snapshot(img);
+        for (int x : xs)
+            if (x > 0 && x < w - 1)
+                img[y * w + x] = NeighborMedian(snapshot, w, h, x, y);
+
+        if (!xs.empty() && xs.back() == w - 1)
+            img[y * w + w - 1] = NeighborMedian(img, w, h, w - 1, y);
+    }
+}
+
+static std::vector<unsigned short> MakeFrame(int w, int h, std::mt19937& rng)
+{
+    std::uniform_int_distribution<int> val(0, 65535);
+    std::vector<unsigned short> f(w * h);
+    for (unsigned short& v : f)
+        v = (unsigned short) val(rng);
+    return f;
+}
+
+static Rect RandomRect(int w, int h, std::mt19937& rng)
+{
+    if (std::uniform_int_distribution<int>(0, 2)(rng) == 0)
+        return Rect{ 0, 0, w, h };
+
+    std::uniform_int_distribution<int> rx(0, w - 1), ry(0, h - 1);
+    int x0 = rx(rng), x1 = rx(rng), y0 = ry(rng), y1 = ry(rng);
+    if (x0 > x1) std::swap(x0, x1);
+    if (y0 > y1) std::swap(y0, y1);
+    return Rect{ x0, y0, x1 - x0 + 1, y1 - y0 + 1 };
+}
+
+static bool Inside(const Rect& r, int x, int y)
+{
+    return x >= r.x && x < r.x + r.width && y >= r.y && y < r.y + r.height;
+}
+
+// defects at least 2 pixels apart, so that none of them borders another, with
+// the corners and some edge pixels always tried first
+static std::vector<std::pair<int, int>> IsolatedDefects(int w, int h, std::mt19937& rng)
+{
+    std::vector<std::pair<int, int>> cand = {
+        { 0, 0 }, { w - 1, 0 }, { 0, h - 1 }, { w - 1, h - 1 },
+        { w / 2, 0 }, { w / 2, h - 1 }, { 0, h / 2 }, { w - 1, h / 2 },
+    };
+    std::uniform_int_distribution<int> rx(0, w - 1), ry(0, h - 1);
+    for (int i = 0; i < w * h / 4; i++)
+        cand.push_back(std::make_pair(rx(rng), ry(rng)));
+
+    std::vector<std::pair<int, int>> defects;
+    for (const auto& c : cand)
+    {
+        bool const clear = std::none_of(defects.begin(), defects.end(), [&](const std::pair<int, int>& d) {
+            return abs(d.first - c.first) <= 1 && abs(d.second - c.second) <= 1;
+        });
+        if (clear)
+            defects.push_back(c);
+    }
+    return defects;
+}
+
+TEST(DefectRemovalTest, MedianBorderingPixels)
+{
+    std::mt19937 rng(1);
+    for (int w = 3; w <= 6; w++)
+        for (int h = 3; h <= 6; h++)
+        {
+            std::vector<unsigned short> const img = MakeFrame(w, h, rng);
+            for (int y = 0; y < h; y++)
+                for (int x = 0; x < w; x++)
+                    ASSERT_EQ(NeighborMedian(img, w, h, x, y), MedianBorderingPixels(img.data(), w, h, x, y))
+                        << w << "x" << h << " at " << x << "," << y;
+        }
+}
+
+TEST(DefectRemovalTest, RowIndex)
+{
+    DefectRowIndex index;
+    EXPECT_TRUE(index.Add(5, 2));
+    EXPECT_TRUE(index.Add(1, 2));
+    EXPECT_TRUE(index.Add(5, 2));       // duplicate
+    EXPECT_TRUE(index.Add(3, 0));
+    EXPECT_FALSE(index.Add(3, -1));
+    EXPECT_FALSE(index.Add(3, DefectRowIndex::MAX_ROWS));
+
+    ASSERT_EQ(3, index.RowCount());
+    EXPECT_EQ(std::vector<int>({ 3 }), index.Row(0));
+    EXPECT_TRUE(index.Row(1).empty());
+    EXPECT_EQ(std::vector<int>({ 1, 5 }), index.Row(2));
+
+    EXPECT_TRUE(index.Find(5, 2));
+    EXPECT_FALSE(index.Find(4, 2));
+    EXPECT_FALSE(index.Find(3, 7));
+
+    index.Clear();
+    EXPECT_EQ(0, index.RowCount());
+}
+
+// isolated defects in random order, with every defect added twice, on frames
+// from 3x3 up, with and without a subframe
+TEST(DefectRemovalTest, IsolatedDefects)
+{
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<int> size(3, 40);
+
+    for (int iter = 0; iter < 500; iter++)
+    {
+        int const w = size(rng), h = size(rng);
+        std::vector<unsigned short> const orig = MakeFrame(w, h, rng);
+        std::vector<std::pair<int, int>> defects = IsolatedDefects(w, h, rng);
+        std::shuffle(defects.begin(), defects.end(), rng);
+
+        DefectRowIndex index;
+        for (const auto& d : defects)
+            index.Add(d.first, d.second);
+        for (const auto& d : defects)
+            index.Add(d.first, d.second);
+
+        Rect const r = RandomRect(w, h, rng);
+
+        std::vector<unsigned short> want(orig);
+        for (const auto& d : defects)
+            if (Inside(r, d.first, d.second))
+                want[d.second * w + d.first] = MedianBorderingPixels(orig.data(), w, h, d.first, d.second);
+
+        std::vector<unsigned short> got(orig);
+        Correct(got, w, h, index, r);
+
+        ASSERT_EQ(want, got) << "iteration " << iter << " frame " << w << "x" << h
+            << " rect " << r.width << "x" << r.height << "@" << r.x << "," << r.y;
+    }
+}
+
+// Adjacent defects in one row are corrected from the row as it was before any
+// of them were written: here each of the pair sees the other's raw 900. (Taking
+// them one at a time from left to right would give 27 and 32.)
+TEST(DefectRemovalTest, AdjacentInRow)
+{
+    int const w = 5, h = 3;
+    std::vector<unsigned short> img = {
+        10,  20,  30, 40, 50,
+        60, 900, 900, 70, 80,
+        15,  25,  35, 45, 55,
+    };
+    DefectRowIndex index;
+    index.Add(1, 1);
+    index.Add(2, 1);
+
+    Correct(img, w, h, index, Rect{ 0, 0, w, h });
+
+    EXPECT_EQ(27, img[1 * w + 1]);
+    EXPECT_EQ(37, img[1 * w + 2]);
+}
+
+// Rows are corrected top to bottom, so the lower of two stacked defects sees the
+// corrected value of the upper one, and the upper one sees the raw lower one.
+TEST(DefectRemovalTest, AdjacentInColumn)
+{
+    int const w = 3, h = 4;
+    std::vector<unsigned short> img = {
+        10,  20,  30,
+        40, 900,  50,
+        60, 900,  70,
+        80,  90, 100,
+    };
+    DefectRowIndex index;
+    index.Add(1, 2);
+    index.Add(1, 1);
+
+    Correct(img, w, h, index, Rect{ 0, 0, w, h });
+
+    EXPECT_EQ(45, img[1 * w + 1]);
+    EXPECT_EQ(65, img[2 * w + 1]);
+}
+
+// dense random maps, where most defects border others, follow the documented order
+TEST(DefectRemovalTest, DenseDefects)
+{
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> size(3, 24);
+
+    for (int iter = 0; iter < 500; iter++)
+    {
+        int const w = size(rng), h = size(rng);
+        std::vector<unsigned short> const orig = MakeFrame(w, h, rng);
+
+        std::set<std::pair<int, int>> defects;
+        DefectRowIndex index;
+        std::uniform_int_distribution<int> rx(0, w - 1), ry(0, h - 1);
+        for (int i = 0; i < w * h / 3; i++)
+        {
+            int const x = rx(rng), y = ry(rng);
+            defects.insert(std::make_pair(x, y));
+            index.Add(x, y);
+        }
+
+        Rect const r = RandomRect(w, h, rng);
+
+        std::vector<unsigned short> want(orig);
+        ReferenceCorrect(want, w, h, defects, r);
+
+        std::vector<unsigned short> got(orig);
+        Correct(got, w, h, index, r);
+
+        ASSERT_EQ(want, got) << "iteration " << iter << " frame " << w << "x" << h
+            << " rect " << r.width << "x" << r.height << "@" << r.x << "," << r.y;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,224 @@
+/*
+ *  frame_stats_test.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+// Checks CalcFrameStats against the way usImage::CalcStats used to compute the
+// frame statistics (copy the pixels, median filter the copy, then nth_element
+// for the median) and reports how long each takes per frame.
+
+#include <gtest/gtest.h>
+#include "median3.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// the statistics as usImage::CalcStats computed them before the single pass
+static void OldCalcStats(FrameStats *stats, const unsigned short *image, int frameWidth, const FrameRect& rect)
+{
+    unsigned int const pixcnt = rect.width * rect.height;
+    std::vector<unsigned short> tmpdata(pixcnt);
+
+    stats->minADU = 65535;
+    stats->maxADU = 0;
+    unsigned short *dst = &tmpdata[0];
+    for (int y = 0; y < rect.height; y++)
+    {
+        const unsigned short *src = image + rect.x + (rect.y + y) * frameWidth;
+        for (int x = 0; x < rect.width; x++)
+        {
+            unsigned short d = *src;
+            if (d < stats->minADU) stats->minADU = d;
+            if (d > stats->maxADU) stats->maxADU = d;
+            *dst++ = *src++;
+        }
+    }
+
+    std::vector<unsigned short> filtered(pixcnt);
+    FrameRect const whole = { 0, 0, rect.width, rect.height };
+    Median3Rows(&filtered[0], &tmpdata[0], rect.width, whole, 0, rect.height);
+
+    stats->filtMin = 65535;
+    stats->filtMax = 0;
+    for (unsigned short d : filtered)
+    {
+        if (d < stats->filtMin) stats->filtMin = d;
+        if (d > stats->filtMax) stats->filtMax = d;
+    }
+
+    std::nth_element(tmpdata.begin(), tmpdata.begin() + pixcnt / 2, tmpdata.end());
+    stats->medianADU = tmpdata[pixcnt / 2];
+}
+
+// sky background with read noise, a few stars and some hot pixels
+static std::vector<unsigned short> MakeFrame(int w, int h, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(1200., 35.);
+    std::uniform_int_distribution<int> px(0, w * h - 1);
+
+    std::vector<unsigned short> f(w * h);
+    for (unsigned short& v : f)
+        v = (unsigned short) std::max(0., std::min(65535., noise(rng)));
+
+    for (int i = 0; i < 20; i++)
+    {
+        int const c = px(rng);
+        int const cx = c % w, cy = c / w;
+        for (int y = std::max(0, cy - 6); y < std::min(h, cy + 7); y++)
+            for (int x = std::max(0, cx - 6); x < std::min(w, cx + 7); x++)
+            {
+                double const r2 = (x - cx) * (x - cx) + (y - cy) * (y - cy);
+                f[y * w + x] = (unsigned short) std::min(65535., f[y * w + x] + 30000. * exp(-r2 / 4.5));
+            }
+    }
+
+    for (int i = 0; i < w * h / 2000 + 1; i++)
+        f[px(rng)] = 65535;
+
+    return f;
+}
+
+static void ExpectSameStats(const FrameStats& want, const FrameStats& got)
+{
+    EXPECT_EQ(want.minADU, got.minADU);
+    EXPECT_EQ(want.maxADU, got.maxADU);
+    EXPECT_EQ(want.medianADU, got.medianADU);
+    EXPECT_EQ(want.filtMin, got.filtMin);
+    EXPECT_EQ(want.filtMax, got.filtMax);
+}
+
+TEST(FrameStatsTest, MatchesOldCalcStats)
+{
+    static const int sizes[][2] = { { 2, 2 }, { 3, 3 }, { 7, 5 }, { 64, 48 }, { 333, 257 }, { 1280, 960 } };
+
+    for (const auto& sz : sizes)
+    {
+        int const w = sz[0], h = sz[1];
+        std::vector<unsigned short> const f = MakeFrame(w, h, w * 31 + h);
+
+        FrameStats want, got;
+        FrameRect const whole = { 0, 0, w, h };
+        OldCalcStats(&want, &f[0], w, whole);
+        CalcFrameStats(&got, &f[0], w, whole);
+        SCOPED_TRACE(testing::Message() << w << "x" << h);
+        ExpectSameStats(want, got);
+    }
+}
+
+TEST(FrameStatsTest, SubframesMatchOldCalcStats)
+{
+    int const w = 640, h = 480;
+    std::vector<unsigned short> const f = MakeFrame(w, h, 2);
+
+    static const FrameRect rects[] = {
+        { 0, 0, 2, 2 }, { 100, 100, 2, 3 }, { 300, 200, 40, 40 }, { 601, 441, 39, 39 },
+        { 0, 240, 640, 3 }, { 17, 0, 3, 480 }, { 1, 1, 638, 478 },
+    };
+
+    // repeated, so the histogram is reused after frames of other sizes
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (const FrameRect& r : rects)
+        {
+            FrameStats want, got;
+            OldCalcStats(&want, &f[0], w, r);
+            CalcFrameStats(&got, &f[0], w, r);
+            SCOPED_TRACE(testing::Message() << r.x << "," << r.y << " " << r.width << "x" << r.height);
+            ExpectSameStats(want, got);
+        }
+    }
+}
+
+// interior pixels of the filter are the median of their 3x3 neighborhood
+TEST(FrameStatsTest, Median3Interior)
+{
+    int const w = 300, h = 40;
+    std::vector<unsigned short> const f = MakeFrame(w, h, 3);
+    std::vector<unsigned short> out(w * h);
+    FrameRect const whole = { 0, 0, w, h };
+    Median3Rows(&out[0], &f[0], w, whole, 0, h / 2);
+    Median3Rows(&out[0], &f[0], w, whole, h / 2, h);
+
+    for (int y = 1; y < h - 1; y++)
+        for (int x = 1; x < w - 1; x++)
+        {
+            unsigned short a[9];
+            int n = 0;
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++)
+                    a[n++] = f[(y + dy) * w + x + dx];
+            std::nth_element(a, a + 4, a + 9);
+            ASSERT_EQ(a[4], out[y * w + x]) << x << "," << y;
+        }
+}
+
+// not a pass/fail test: reports the time per frame of the old and the new stats
+TEST(FrameStatsTest, Benchmark)
+{
+    struct Case { const char *name; int w; int h; FrameRect rect; int reps; };
+    static const Case cases[] = {
+        { "1280x960 full frame", 1280, 960, { 0, 0, 1280, 960 }, 20 },
+        { "4656x3520 full frame", 4656, 3520, { 0, 0, 4656, 3520 }, 3 },
+        { "100x100 subframe", 1280, 960, { 500, 400, 100, 100 }, 2000 },
+    };
+
+    typedef std::chrono::steady_clock clock;
+
+    for (const Case& c : cases)
+    {
+        std::vector<unsigned short> const f = MakeFrame(c.w, c.h, 4);
+        FrameStats old, cur;
+
+        clock::time_point t0 = clock::now();
+        for (int i = 0; i < c.reps; i++)
+            OldCalcStats(&old, &f[0], c.w, c.rect);
+        double const oldMs = std::chrono::duration<double, std::milli>(clock::now() - t0).count() / c.reps;
+
+        t0 = clock::now();
+        for (int i = 0; i < c.reps; i++)
+            CalcFrameStats(&cur, &f[0], c.w, c.rect);
+        double const newMs = std::chrono::duration<double, std::milli>(clock::now() - t0).count() / c.reps;
+
+        ExpectSameStats(old, cur);
+        printf("%-22s old %8.3f ms  new %8.3f ms\n", c.name, oldMs, newMs);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
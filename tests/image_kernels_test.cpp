@@ -0,0 +1,180 @@
+/*
+ *  image_kernels_test.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+// Checks that every SIMD variant of the image kernels the CPU supports gives the
+// same result as the scalar kernels, bit for bit, and that the scalar kernels
+// compute what image_kernels.h says they do.
+
+#include <gtest/gtest.h>
+#include "image_kernels.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// row widths covering the vector bodies and every tail length
+static const int MAX_WIDTH = 200;
+
+struct Rows
+{
+    std::vector<unsigned short> r0, r1, r2;
+
+    Rows(int n, std::mt19937& rng, int mode)
+    {
+        // mode 0: uniform, 1: extremes only, 2: narrow range with many ties
+        std::uniform_int_distribution<int> any(0, 65535);
+        std::uniform_int_distribution<int> coin(0, 1);
+        std::uniform_int_distribution<int> narrow(1000, 1003);
+        for (std::vector<unsigned short> *r : { &r0, &r1, &r2 })
+        {
+            r->resize(n + 2);
+            for (unsigned short& v : *r)
+                v = (unsigned short) (mode == 0 ? any(rng) : mode == 1 ? (coin(rng) ? 65535 : 0) : narrow(rng));
+        }
+    }
+};
+
+static std::vector<ImageKernels> SimdKernels()
+{
+    std::vector<ImageKernels> v = GetSupportedImageKernels();
+    v.pop_back(); // scalar
+    return v;
+}
+
+TEST(ImageKernelsTest, ScalarIsLast)
+{
+    std::vector<ImageKernels> v = GetSupportedImageKernels();
+    ASSERT_FALSE(v.empty());
+    EXPECT_EQ(v.back().median9Row, GetScalarImageKernels().median9Row);
+    EXPECT_STREQ(v.front().name, GetImageKernels().name);
+}
+
+TEST(ImageKernelsTest, ScalarMedian9)
+{
+    std::mt19937 rng(1);
+    for (int mode = 0; mode < 3; mode++)
+    {
+        Rows rows(MAX_WIDTH, rng, mode);
+        std::vector<unsigned short> dst(MAX_WIDTH);
+        GetScalarImageKernels().median9Row(&dst[0], &rows.r0[0], &rows.r1[0], &rows.r2[0], MAX_WIDTH);
+
+        for (int i = 0; i < MAX_WIDTH; i++)
+        {
+            unsigned short p[9] = { rows.r0[i], rows.r0[i + 1], rows.r0[i + 2],
+                                    rows.r1[i], rows.r1[i + 1], rows.r1[i + 2],
+                                    rows.r2[i], rows.r2[i + 1], rows.r2[i + 2] };
+            std::nth_element(p, p + 4, p + 9);
+            ASSERT_EQ(p[4], dst[i]) << "mode " << mode << " i " << i;
+        }
+    }
+}
+
+TEST(ImageKernelsTest, ScalarMean2x2)
+{
+    std::mt19937 rng(2);
+    for (int mode = 0; mode < 3; mode++)
+    {
+        Rows rows(MAX_WIDTH, rng, mode);
+        std::vector<unsigned short> dst(MAX_WIDTH);
+        GetScalarImageKernels().mean2x2Row(&dst[0], &rows.r0[0], &rows.r1[0], MAX_WIDTH);
+
+        for (int i = 0; i < MAX_WIDTH; i++)
+        {
+            unsigned int sum = (unsigned int) rows.r0[i] + rows.r0[i + 1] + rows.r1[i] + rows.r1[i + 1];
+            ASSERT_EQ(sum / 4, dst[i]) << "mode " << mode << " i " << i;
+        }
+    }
+}
+
+TEST(ImageKernelsTest, SimdMatchesScalar)
+{
+    const ImageKernels& ref = GetScalarImageKernels();
+    std::mt19937 rng(3);
+
+    for (const ImageKernels& k : SimdKernels())
+    {
+        for (int mode = 0; mode < 3; mode++)
+        {
+            for (int n = 0; n <= MAX_WIDTH; n++)
+            {
+                Rows rows(n, rng, mode);
+
+                // a guard element past the end catches writes beyond n
+                std::vector<unsigned short> want(n + 1, 0xBEEF), got(n + 1, 0xBEEF);
+
+                ref.median9Row(&want[0], &rows.r0[0], &rows.r1[0], &rows.r2[0], n);
+                k.median9Row(&got[0], &rows.r0[0], &rows.r1[0], &rows.r2[0], n);
+                ASSERT_EQ(want, got) << k.name << " median9Row mode " << mode << " n " << n;
+
+                std::fill(want.begin(), want.end(), 0xBEEF);
+                std::fill(got.begin(), got.end(), 0xBEEF);
+                ref.mean2x2Row(&want[0], &rows.r0[0], &rows.r1[0], n);
+                k.mean2x2Row(&got[0], &rows.r0[0], &rows.r1[0], n);
+                ASSERT_EQ(want, got) << k.name << " mean2x2Row mode " << mode << " n " << n;
+            }
+        }
+    }
+}
+
+TEST(ImageKernelsTest, GrayToRgbMatchesScalar)
+{
+    const ImageKernels& ref = GetScalarImageKernels();
+    std::mt19937 rng(4);
+    std::uniform_int_distribution<int> any(0, 255);
+
+    std::vector<ImageKernels> all = GetSupportedImageKernels();
+    for (const ImageKernels& k : all)
+    {
+        for (int n = 0; n <= MAX_WIDTH; n++)
+        {
+            std::vector<unsigned char> src(n + 1);
+            for (unsigned char& v : src)
+                v = (unsigned char) any(rng);
+
+            std::vector<unsigned char> want(3 * n + 1, 0xA5), got(3 * n + 1, 0xA5);
+            ref.grayToRgbRow(&want[0], &src[0], n);
+            k.grayToRgbRow(&got[0], &src[0], n);
+            ASSERT_EQ(want, got) << k.name << " grayToRgbRow n " << n;
+
+            for (int i = 0; i < n; i++)
+                ASSERT_TRUE(got[3 * i] == src[i] && got[3 * i + 1] == src[i] && got[3 * i + 2] == src[i]) << k.name << " i " << i;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,205 @@
+/*
+ *  image_rotate_test.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+// Checks that rotating and mirroring a frame moves a star to where the rotation
+// says it should be: exactly for quarter turns, and within a small fraction of a
+// pixel for the interpolated angles.
+
+#include <gtest/gtest.h>
+#include "image_rotate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static const double PI = 3.14159265358979323846;
+static const double BACKGROUND = 1000.;
+
+struct Frame
+{
+    int w;
+    int h;
+    std::vector<unsigned short> px;
+
+    Frame(int w_, int h_) : w(w_), h(h_), px(w_ * h_) { }
+    unsigned short at(int x, int y) const { return px[y * w + x]; }
+};
+
+// a frame with a Gaussian star on a flat background
+static Frame MakeStar(int w, int h, double sx, double sy, double sigma, double peak)
+{
+    Frame f(w, h);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+        {
+            double const r2 = (x - sx) * (x - sx) + (y - sy) * (y - sy);
+            f.px[y * w + x] = (unsigned short) (BACKGROUND + peak * exp(-r2 / (2. * sigma * sigma)) + 0.5);
+        }
+    return f;
+}
+
+// the steps of usImage::Rotate
+static Frame Rotate(const Frame& src, double theta, bool mirror)
+{
+    Frame f(src);
+    if (mirror)
+        MirrorRows(&f.px[0], f.w, f.h);
+
+    RotateGeometry g;
+    GetRotateGeometry(&g, f.w, f.h, theta);
+    if (g.quarter == 0)
+        return f;
+    if (g.quarter == 2)
+    {
+        std::reverse(f.px.begin(), f.px.end());
+        return f;
+    }
+
+    Frame dst(g.width, g.height);
+    // in two pieces, as ParallelFor would split it
+    RotateRows(&dst.px[0], &f.px[0], f.w, f.h, g, 0, g.height / 3);
+    RotateRows(&dst.px[0], &f.px[0], f.w, f.h, g, g.height / 3, g.height);
+    return dst;
+}
+
+// where the source point (x, y) ends up
+static void Predict(double *px, double *py, int w, int h, double theta, bool mirror, double x, double y)
+{
+    RotateGeometry g;
+    GetRotateGeometry(&g, w, h, theta);
+    if (mirror)
+        y = h - 1 - y;
+    *px = x * g.c - y * g.s - g.x0;
+    *py = y * g.c + x * g.s - g.y0;
+}
+
+// background-subtracted centroid within radius r of (cx, cy)
+static void Centroid(double *px, double *py, const Frame& f, double cx, double cy, double r)
+{
+    double sum = 0., sx = 0., sy = 0.;
+    for (int y = std::max(0, (int) (cy - r)); y <= std::min(f.h - 1, (int) (cy + r) + 1); y++)
+        for (int x = std::max(0, (int) (cx - r)); x <= std::min(f.w - 1, (int) (cx + r) + 1); x++)
+        {
+            if ((x - cx) * (x - cx) + (y - cy) * (y - cy) > r * r)
+                continue;
+            double const v = f.at(x, y) - BACKGROUND;
+            sum += v;
+            sx += v * x;
+            sy += v * y;
+        }
+    *px = sx / sum;
+    *py = sy / sum;
+}
+
+static const double STAR_X = 41.3;
+static const double STAR_Y = 27.6;
+
+TEST(ImageRotateTest, QuarterTurnsAreExact)
+{
+    Frame const src = MakeStar(80, 56, STAR_X, STAR_Y, 2.0, 20000.);
+
+    for (int mirror = 0; mirror < 2; mirror++)
+    {
+        for (int q = -2; q <= 5; q++)
+        {
+            double const theta = q * PI / 2.;
+            Frame const dst = Rotate(src, theta, mirror != 0);
+            ASSERT_EQ(q & 1 ? src.h : src.w, dst.w);
+            ASSERT_EQ(q & 1 ? src.w : src.h, dst.h);
+
+            // every pixel center maps onto a pixel center
+            for (int y = 0; y < src.h; y++)
+                for (int x = 0; x < src.w; x++)
+                {
+                    double dx, dy;
+                    Predict(&dx, &dy, src.w, src.h, theta, mirror != 0, x, y);
+                    int const ix = (int) floor(dx + 0.5);
+                    int const iy = (int) floor(dy + 0.5);
+                    ASSERT_NEAR(dx, ix, 1e-9);
+                    ASSERT_NEAR(dy, iy, 1e-9);
+                    ASSERT_EQ(src.at(x, y), dst.at(ix, iy)) << "q " << q << " mirror " << mirror;
+                }
+        }
+    }
+}
+
+TEST(ImageRotateTest, StarCentroid)
+{
+    static const double degrees[] = { 1., 10., 33.3, 45., 89., 91., 137., 200., 271.5, -71., -120. };
+
+    Frame const src = MakeStar(80, 56, STAR_X, STAR_Y, 2.0, 20000.);
+    double sx, sy;
+    Centroid(&sx, &sy, src, STAR_X, STAR_Y, 10.);
+
+    for (int mirror = 0; mirror < 2; mirror++)
+    {
+        for (double deg : degrees)
+        {
+            double const theta = deg * PI / 180.;
+            Frame const dst = Rotate(src, theta, mirror != 0);
+
+            double want_x, want_y;
+            Predict(&want_x, &want_y, src.w, src.h, theta, mirror != 0, sx, sy);
+
+            double got_x, got_y;
+            Centroid(&got_x, &got_y, dst, want_x, want_y, 10.);
+
+            EXPECT_NEAR(want_x, got_x, 0.02) << deg << " degrees, mirror " << mirror;
+            EXPECT_NEAR(want_y, got_y, 0.02) << deg << " degrees, mirror " << mirror;
+        }
+    }
+}
+
+// an angle a hair off a quarter turn goes through the interpolating path and must
+// agree with the exact quarter turn
+TEST(ImageRotateTest, NearQuarterTurnMatchesQuarterTurn)
+{
+    Frame const src = MakeStar(80, 56, STAR_X, STAR_Y, 2.0, 20000.);
+
+    for (int q = 1; q <= 3; q += 2)
+    {
+        Frame const exact = Rotate(src, q * PI / 2., false);
+        Frame const near = Rotate(src, q * PI / 2. + 1e-8, false);
+        ASSERT_EQ(exact.w, near.w);
+        ASSERT_EQ(exact.h, near.h);
+        for (size_t i = 0; i < exact.px.size(); i++)
+            ASSERT_LE(abs((int) exact.px[i] - (int) near.px[i]), 1) << "q " << q << " pixel " << i;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,257 @@
+/*
+ *  json_parser_test.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+// Fuzz test and throughput benchmark for JsonParser, the parser the event server
+// uses for client requests. The requests below are the kind of traffic the common
+// client applications send while guiding.
+
+#include <gtest/gtest.h>
+#include "json_parser.h"
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+static const char *s_traffic[] = {
+    R"({"method":"get_app_state","id":1})",
+    R"({"method": "get_connected", "id": 2})",
+    R"({"method":"get_exposure","id":3})",
+    R"({"method":"get_pixel_scale","id":4})",
+    R"({"method":"set_exposure","params":[2000],"id":5})",
+    R"({"method":"get_star_image","params":[15],"id":6})",
+    R"({"method": "guide", "params": {"settle": {"pixels": 1.5, "time": 8, "timeout": 40}, "recalibrate": false}, "id": 7})",
+    R"({"method":"guide","params":[{"pixels":0.5,"time":6,"timeout":30},false],"id":8})",
+    R"({"method": "dither", "params": {"amount": 10, "raOnly": false, "settle": {"pixels": 1.5, "time": 8, "timeout": 30}}, "id": 9})",
+    R"({"method":"dither","params":[3.5,true,{"pixels":1.5,"time":8,"timeout":30}],"id":10})",
+    R"({"method":"set_lock_position","params":[512.25,384.75,true],"id":11})",
+    R"({"method":"find_star","params":{"roi":[100,100,400,300]},"id":12})",
+    R"({"method":"set_paused","params":[true,"full"],"id":13})",
+    R"({"method":"set_profile","params":[3],"id":14})",
+    R"({"method":"capture_single_frame","params":{"exposure":2000,"subframe":[0,0,640,480]},"id":15})",
+    R"({"method":"get_calibration_data","params":["Mount"],"id":16})",
+    R"({"method":"set_algo_param","params":["ra","MinMove",0.15],"id":17})",
+    R"({"method":"get_variable_delay_settings","id":"abc-18"})",
+    R"({"method":"set_connected","params":[true],"id":null})",
+    R"({"method":"shutdown","id":-1e3})",
+    R"({"method":"save_image","params":{},"id":20, "jsonrpc": "2.0", "name": "\"quoted\" \\ \/ \b\f\n\r\t é"})",
+};
+
+static const int NR_TRAFFIC = sizeof(s_traffic) / sizeof(s_traffic[0]);
+
+// a canonical dump of the tree, for comparing parses
+static void dump(std::string& s, const json_value *j)
+{
+    if (j->name)
+        s += std::string("\"") + j->name + "\":";
+    switch (j->type)
+    {
+    case JSON_NULL: s += "null"; break;
+    case JSON_STRING: s += std::string("\"") + j->string_value + "\""; break;
+    case JSON_INT: s += std::to_string(j->int_value); break;
+    case JSON_FLOAT: s += std::to_string(j->float_value); break;
+    case JSON_BOOL: s += j->int_value ? "true" : "false"; break;
+    case JSON_OBJECT:
+    case JSON_ARRAY:
+        s += j->type == JSON_OBJECT ? '{' : '[';
+        json_for_each(c, j)
+        {
+            dump(s, c);
+            s += ',';
+        }
+        s += j->type == JSON_OBJECT ? '}' : ']';
+        break;
+    }
+}
+
+static std::string dump(JsonParser& parser)
+{
+    std::string s;
+    dump(s, parser.Root());
+    return s;
+}
+
+TEST(JsonParserTest, Traffic)
+{
+    JsonParser parser;
+    for (int i = 0; i < NR_TRAFFIC; i++)
+    {
+        ASSERT_TRUE(parser.Parse(std::string(s_traffic[i]))) << s_traffic[i] << ": " << parser.ErrorDesc();
+        const json_value *root = parser.Root();
+        ASSERT_NE(nullptr, root);
+        ASSERT_EQ(JSON_OBJECT, root->type);
+        ASSERT_STREQ("method", root->first_child->name);
+    }
+
+    ASSERT_TRUE(parser.Parse(std::string(R"({"method":"set_lock_position","params":[512.25,384.75,true],"id":11})")));
+    EXPECT_EQ(R"({"method":"set_lock_position","params":[512.250000,384.750000,true,],"id":11,})", dump(parser));
+}
+
+// every proper prefix of a request is incomplete and must be rejected without
+// reading past the end of the input
+TEST(JsonParserTest, Truncated)
+{
+    JsonParser parser;
+    for (int i = 0; i < NR_TRAFFIC; i++)
+    {
+        std::string const line(s_traffic[i]);
+        for (size_t len = 0; len < line.size(); len++)
+        {
+            // a heap copy of exactly len bytes plus the NUL, so overreads are caught by ASan
+            std::vector<char> buf(line.begin(), line.begin() + len);
+            buf.push_back('\0');
+            EXPECT_FALSE(parser.Parse(&buf[0])) << line.substr(0, len);
+        }
+    }
+}
+
+// a parser reused across requests gives the same trees as a fresh one, whatever
+// it parsed (or failed to parse) before
+TEST(JsonParserTest, Reuse)
+{
+    std::vector<std::string> want;
+    for (int i = 0; i < NR_TRAFFIC; i++)
+    {
+        JsonParser fresh;
+        ASSERT_TRUE(fresh.Parse(std::string(s_traffic[i])));
+        want.push_back(dump(fresh));
+    }
+
+    JsonParser parser;
+    std::string big = "[";
+    for (int i = 0; i < 2000; i++)
+        big += std::string(s_traffic[i % NR_TRAFFIC]) + ",";
+    big += "1]";
+
+    for (int pass = 0; pass < 3; pass++)
+    {
+        for (int i = 0; i < NR_TRAFFIC; i++)
+        {
+            ASSERT_TRUE(parser.Parse(std::string(s_traffic[i])));
+            EXPECT_EQ(want[i], dump(parser));
+        }
+        ASSERT_TRUE(parser.Parse(big));
+        EXPECT_FALSE(parser.Parse(std::string("{\"method\":")));
+        EXPECT_FALSE(parser.Parse(std::string("")));
+    }
+}
+
+// random mutations of the recorded traffic must never crash the parser or leave
+// it unable to parse the next good request
+TEST(JsonParserTest, Fuzz)
+{
+    static const char tokens[] = "{}[]\":,\\ -+.0123456789eEtrufalsn\x01\xff";
+    std::mt19937 rng(19);
+    std::uniform_int_distribution<int> pick_line(0, NR_TRAFFIC - 1);
+    std::uniform_int_distribution<int> pick_op(0, 4);
+    std::uniform_int_distribution<int> pick_token(0, sizeof(tokens) - 2);
+    std::uniform_int_distribution<int> pick_count(1, 4);
+
+    JsonParser parser;
+    JsonParser fresh;
+    ASSERT_TRUE(fresh.Parse(std::string(s_traffic[0])));
+    std::string const good = dump(fresh);
+
+    for (int iter = 0; iter < 50000; iter++)
+    {
+        std::string s(s_traffic[pick_line(rng)]);
+
+        for (int n = pick_count(rng); n > 0 && !s.empty(); n--)
+        {
+            std::uniform_int_distribution<size_t> pick_pos(0, s.size() - 1);
+            size_t const pos = pick_pos(rng);
+            switch (pick_op(rng))
+            {
+            case 0: s.resize(pos); break;                                   // truncate
+            case 1: s[pos] = tokens[pick_token(rng)]; break;                // replace
+            case 2: s.insert(pos, 1, tokens[pick_token(rng)]); break;       // insert
+            case 3: s.erase(pos, std::min<size_t>(s.size() - pos, 5)); break; // delete
+            case 4: s.insert(pos, s.substr(pos, 8)); break;                 // duplicate
+            }
+        }
+
+        if (parser.Parse(s))
+            ASSERT_NE(nullptr, parser.Root()) << s;
+        else
+            ASSERT_NE(nullptr, parser.ErrorDesc()) << s;
+
+        if (iter % 100 == 0)
+        {
+            ASSERT_TRUE(parser.Parse(std::string(s_traffic[0])));
+            ASSERT_EQ(good, dump(parser));
+        }
+    }
+}
+
+// not a pass/fail test: reports the parse rate for the recorded traffic with one
+// parser reused for every request, as the event server does, and with a new
+// parser per request
+TEST(JsonParserTest, Throughput)
+{
+    std::vector<std::string> lines;
+    size_t bytes = 0;
+    for (int i = 0; i < 200000; i++)
+    {
+        lines.push_back(s_traffic[i % NR_TRAFFIC]);
+        bytes += lines.back().size();
+    }
+
+    typedef std::chrono::steady_clock clock;
+
+    clock::time_point t0 = clock::now();
+    {
+        JsonParser parser;
+        for (const std::string& line : lines)
+            ASSERT_TRUE(parser.Parse(line));
+    }
+    double const reused = std::chrono::duration<double>(clock::now() - t0).count();
+
+    t0 = clock::now();
+    for (const std::string& line : lines)
+    {
+        JsonParser parser;
+        ASSERT_TRUE(parser.Parse(line));
+    }
+    double const perRequest = std::chrono::duration<double>(clock::now() - t0).count();
+
+    printf("%u requests, %.1f MB\n", (unsigned int) lines.size(), bytes / 1e6);
+    printf("reused parser:       %8.0f requests/s %6.1f MB/s\n", lines.size() / reused, bytes / 1e6 / reused);
+    printf("parser per request:  %8.0f requests/s %6.1f MB/s\n", lines.size() / perRequest, bytes / 1e6 / perRequest);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,356 @@
+/*
+ *  json_writer_test.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+// Checks that the event server's JSON writer produces exactly the bytes the
+// writer it replaced did, and reports how fast each one builds events.
+//
+// The replaced writer built every field as a temporary wxString from
+// wxString::Format, escaped strings with wxString::Replace, and converted the
+// finished message to UTF-8. OldWriter below follows the same steps with
+// std::string and snprintf, which is what wxString::Format ends up calling.
+
+#include <gtest/gtest.h>
+#include "json_writer.h"
+
+#include <chrono>
+#include <climits>
+#include <stdarg.h>
+#include <stdio.h>
+
+namespace OldWriter
+{
+    static std::string Format(const char *fmt, ...)
+    {
+        char buf[512];
+        va_list ap;
+        va_start(ap, fmt);
+        vsnprintf(buf, sizeof(buf), fmt, ap);
+        va_end(ap);
+        return buf;
+    }
+
+    static void Replace(std::string& s, const std::string& from, const std::string& to)
+    {
+        for (size_t pos = 0; (pos = s.find(from, pos)) != std::string::npos; pos += to.size())
+            s.replace(pos, from.size(), to);
+    }
+
+    static std::string json_escape(const std::string& s)
+    {
+        std::string t(s);
+        Replace(t, "\\", "\\\\");
+        Replace(t, "\"", "\\\"");
+        Replace(t, "\r", "\\r");
+        Replace(t, "\n", "\\n");
+        return t;
+    }
+
+    template<char LDELIM, char RDELIM>
+    struct JSeq
+    {
+        std::string m_s;
+        bool m_first;
+        bool m_closed;
+        JSeq() : m_first(true), m_closed(false) { m_s += LDELIM; }
+        void close() { m_s += RDELIM; m_closed = true; }
+        std::string str() { if (!m_closed) close(); return m_s; }
+    };
+
+    typedef JSeq<'[', ']'> JAry;
+    typedef JSeq<'{', '}'> JObj;
+
+    static JAry& operator<<(JAry& a, const std::string& str)
+    {
+        if (a.m_first)
+            a.m_first = false;
+        else
+            a.m_s += ',';
+        a.m_s += str;
+        return a;
+    }
+
+    static JAry& operator<<(JAry& a, double d) { return a << Format("%.2f", d); }
+    static JAry& operator<<(JAry& a, int i) { return a << Format("%d", i); }
+
+    static std::string json_format(const json_value *j)
+    {
+        if (!j)
+            return "null";
+
+        switch (j->type) {
+        default:
+        case JSON_NULL: return "null";
+        case JSON_OBJECT:
+        case JSON_ARRAY: {
+            std::string ret(j->type == JSON_OBJECT ? "{" : "[");
+            bool first = true;
+            json_for_each (jj, j)
+            {
+                if (first)
+                    first = false;
+                else
+                    ret += ",";
+                if (j->type == JSON_OBJECT)
+                    ret += std::string("\"") + jj->name + "\":";
+                ret += json_format(jj);
+            }
+            ret += j->type == JSON_OBJECT ? "}" : "]";
+            return ret;
+        }
+        case JSON_STRING: return '"' + json_escape(j->string_value) + '"';
+        case JSON_INT:    return Format("%d", j->int_value);
+        case JSON_FLOAT:  return Format("%g", (double) j->float_value);
+        case JSON_BOOL:   return j->int_value ? "true" : "false";
+        }
+    }
+
+    struct NV
+    {
+        std::string n;
+        std::string v;
+        NV(const std::string& n_, const std::string& v_) : n(n_), v('"' + json_escape(v_) + '"') { }
+        NV(const std::string& n_, const char *v_) : n(n_), v('"' + json_escape(v_) + '"') { }
+        NV(const std::string& n_, int v_) : n(n_), v(Format("%d", v_)) { }
+        NV(const std::string& n_, double v_) : n(n_), v(Format("%g", v_)) { }
+        NV(const std::string& n_, double v_, int prec) : n(n_), v(Format("%.*f", prec, v_)) { }
+        NV(const std::string& n_, bool v_) : n(n_), v(v_ ? "true" : "false") { }
+        NV(const std::string& n_, JAry& ary) : n(n_), v(ary.str()) { }
+        NV(const std::string& n_, JObj& obj) : n(n_), v(obj.str()) { }
+        NV(const std::string& n_, const json_value *v_) : n(n_), v(json_format(v_)) { }
+        NV(const std::string& n_, const NULL_TYPE&) : n(n_), v("null") { }
+    };
+
+    static JObj& operator<<(JObj& j, const NV& nv)
+    {
+        if (j.m_first)
+            j.m_first = false;
+        else
+            j.m_s += ',';
+        j.m_s += '"' + nv.n + "\":" + nv.v;
+        return j;
+    }
+
+    // the message as it went on the wire
+    static std::string Line(JObj& j)
+    {
+        std::string s(j.str());
+        s += "\r\n";
+        return s;
+    }
+}
+
+// one guide step's worth of values, varied by n
+struct Step
+{
+    int frame;
+    double time;
+    double dx, dy, ra, dec, raGuide, decGuide;
+    int raDuration, decDuration;
+    double mass, snr, hfd, avgDist;
+    bool limited;
+
+    explicit Step(int n)
+        : frame(n), time(n * 2.137), dx(0.013 * (n % 97) - 0.6), dy(-0.021 * (n % 53) + 0.5),
+        ra(dx * 0.9 - dy * 0.1), dec(dy * 0.9 + dx * 0.1), raGuide(ra * 0.7), decGuide(dec * 0.7),
+        raDuration(n % 3 ? 120 + n % 400 : 0), decDuration(n % 5 ? 80 + n % 300 : 0),
+        mass(15000. + n % 1000 * 13.7), snr(40. + n % 50 * 0.37), hfd(2.1 + n % 10 * 0.11),
+        avgDist(0.2 + n % 20 * 0.03), limited(n % 11 == 0)
+    {
+    }
+};
+
+// the GuideStep event, as EventServer::NotifyGuideStep builds it
+template<typename JObjT, typename NVT>
+static void GuideStep(JObjT& ev, const Step& s)
+{
+    ev << NVT("Event", "GuideStep") << NVT("Timestamp", 1760000000.123 + s.time, 3)
+       << NVT("Host", "observatory-pc") << NVT("Inst", 1)
+       << NVT("Frame", s.frame) << NVT("Time", s.time, 3) << NVT("Mount", "Mount")
+       << NVT("dx", s.dx, 3) << NVT("dy", s.dy, 3)
+       << NVT("RADistanceRaw", s.ra, 3) << NVT("DECDistanceRaw", s.dec, 3)
+       << NVT("RADistanceGuide", s.raGuide, 3) << NVT("DECDistanceGuide", s.decGuide, 3);
+    if (s.raDuration > 0)
+        ev << NVT("RADuration", s.raDuration) << NVT("RADirection", s.ra > 0 ? "West" : "East");
+    if (s.decDuration > 0)
+        ev << NVT("DECDuration", s.decDuration) << NVT("DECDirection", s.dec > 0 ? "North" : "South");
+    ev << NVT("StarMass", s.mass, 0) << NVT("SNR", s.snr, 2) << NVT("HFD", s.hfd, 2) << NVT("AvgDist", s.avgDist, 2);
+    if (s.limited)
+        ev << NVT("RALimited", true);
+}
+
+TEST(JsonWriterTest, GuideStepMatchesOldWriter)
+{
+    for (int n = 0; n < 2000; n++)
+    {
+        Step const s(n);
+        OldWriter::JObj old;
+        GuideStep<OldWriter::JObj, OldWriter::NV>(old, s);
+        JObj ev;
+        GuideStep<JObj, NV>(ev, s);
+        ASSERT_EQ(OldWriter::Line(old), ev.line()) << "step " << n;
+    }
+}
+
+TEST(JsonWriterTest, ValuesMatchOldWriter)
+{
+    static const int ints[] = { 0, 1, -1, 9, 10, -10, 12345, INT_MAX, INT_MIN, INT_MIN + 1 };
+    static const double doubles[] = { 0., -0., 0.1, -2.5, 1e-300, 3.3e300, 123456789., 1e15, -7.25e-5, 0.0005, 2.5, 3.5 };
+    static const char *strings[] = { "", "plain", "quote \" here", "back\\slash", "cr\rlf\n", "\\\"\r\n\\",
+                                     "Star lost - low SNR", "tab\tstays" };
+
+    for (int i : ints)
+    {
+        OldWriter::JObj old;
+        old << OldWriter::NV("i", i);
+        JObj j;
+        j << NV("i", i);
+        EXPECT_EQ(old.str(), j.str());
+
+        OldWriter::JAry olda;
+        olda << i;
+        JAry a;
+        a << i;
+        EXPECT_EQ(olda.str(), a.str());
+    }
+
+    for (double d : doubles)
+    {
+        for (int prec = 0; prec <= 3; prec++)
+        {
+            OldWriter::JObj old;
+            old << OldWriter::NV("g", d) << OldWriter::NV("f", d, prec);
+            JObj j;
+            j << NV("g", d) << NV("f", d, prec);
+            EXPECT_EQ(old.str(), j.str());
+        }
+
+        OldWriter::JAry olda;
+        olda << d;
+        JAry a;
+        a << d;
+        EXPECT_EQ(olda.str(), a.str());
+    }
+
+    for (const char *str : strings)
+    {
+        OldWriter::JObj old;
+        old << OldWriter::NV("s", str) << OldWriter::NV("b", true) << OldWriter::NV("n", NULL_VALUE);
+        JObj j;
+        j << NV("s", str) << NV("b", true) << NV("n", NULL_VALUE);
+        EXPECT_EQ(old.str(), j.str());
+    }
+}
+
+// wide text comes out as the UTF-8 the old writer got from wxString::ToUTF8
+TEST(JsonWriterTest, WideText)
+{
+    JObj j;
+    j << NV("s", L"Ångström ☃ \U0001D11E \"q\"\r\n");
+    EXPECT_EQ("{\"s\":\"\xc3\x85ngstr\xc3\xb6m \xe2\x98\x83 \xf0\x9d\x84\x9e \\\"q\\\"\\r\\n\"}", j.str());
+}
+
+// an RPC response echoes parsed values back; both writers must render them the same
+TEST(JsonWriterTest, ParsedValuesMatchOldWriter)
+{
+    static const char *requests[] = {
+        R"({"method":"guide","params":{"settle":{"pixels":1.5,"time":8,"timeout":40},"recalibrate":false},"id":7})",
+        R"({"method":"set_lock_position","params":[512.25,384.75,true],"id":"a \"b\" \\ c"})",
+        R"({"method":"get_app_state","id":null,"extra":[[],{},[1,[2,[3e-5]]]]})",
+    };
+
+    JsonParser parser;
+    for (const char *req : requests)
+    {
+        ASSERT_TRUE(parser.Parse(std::string(req)));
+        const json_value *root = parser.Root();
+
+        OldWriter::JObj old;
+        old << OldWriter::NV("jsonrpc", "2.0") << OldWriter::NV("result", root) << OldWriter::NV("id", root->last_child);
+        JObj j;
+        j << NV("jsonrpc", "2.0") << NV("result", root) << NV("id", root->last_child);
+        EXPECT_EQ(OldWriter::Line(old), j.line()) << req;
+    }
+}
+
+// a sequence copied after line() was taken must not carry the terminator
+TEST(JsonWriterTest, CopyAfterLine)
+{
+    JObj j;
+    j << NV("a", 1);
+    EXPECT_EQ("{\"a\":1}\r\n", j.line());
+    JObj copy(j);
+    EXPECT_EQ("{\"a\":1}", copy.str());
+    EXPECT_EQ("{\"a\":1}", j.str());
+}
+
+// not a pass/fail test: reports how fast each writer builds GuideStep events
+TEST(JsonWriterTest, Throughput)
+{
+    enum { EVENTS = 200000 };
+    std::vector<Step> steps;
+    for (int n = 0; n < EVENTS; n++)
+        steps.push_back(Step(n));
+
+    typedef std::chrono::steady_clock clock;
+    size_t oldBytes = 0, newBytes = 0;
+
+    clock::time_point t0 = clock::now();
+    for (const Step& s : steps)
+    {
+        OldWriter::JObj ev;
+        GuideStep<OldWriter::JObj, OldWriter::NV>(ev, s);
+        oldBytes += OldWriter::Line(ev).size();
+    }
+    double const oldSecs = std::chrono::duration<double>(clock::now() - t0).count();
+
+    t0 = clock::now();
+    for (const Step& s : steps)
+    {
+        JObj ev;
+        GuideStep<JObj, NV>(ev, s);
+        newBytes += ev.line().size();
+    }
+    double const newSecs = std::chrono::duration<double>(clock::now() - t0).count();
+
+    EXPECT_EQ(oldBytes, newBytes);
+    printf("%d GuideStep events, %.1f MB\n", (int) EVENTS, newBytes / 1e6);
+    printf("old writer: %8.0f events/s\n", EVENTS / oldSecs);
+    printf("new writer: %8.0f events/s\n", EVENTS / newSecs);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,212 @@
+/*
+ *  preprocess_test.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+// PreprocessFrame must give the same frame and statistics as the separate
+// passes it replaces: Subtract or RemoveDefects, then QuickLRecon or Median3,
+// then usImage::CalcStats, for each noise reduction method, with and without
+// a subframe.
+
+#include <gtest/gtest.h>
+#include "image_preprocess.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+enum Correction
+{
+    NO_CORRECTION,
+    DARK,
+    DEFECTS,
+};
+
+struct Frame
+{
+    int width;
+    int height;
+    std::vector<unsigned short> light;
+    std::vector<unsigned short> dark;
+    DefectRowIndex defects;
+};
+
+static Frame MakeFrame(int w, int h, std::mt19937& rng)
+{
+    Frame f;
+    f.width = w;
+    f.height = h;
+
+    std::normal_distribution<double> sky(1200., 40.), bias(1000., 20.);
+    std::uniform_int_distribution<int> px(0, w * h - 1);
+
+    f.light.resize(w * h);
+    f.dark.resize(w * h);
+    for (int i = 0; i < w * h; i++)
+    {
+        f.light[i] = (unsigned short) std::max(0., std::min(65535., sky(rng)));
+        f.dark[i] = (unsigned short) std::max(0., std::min(65535., bias(rng)));
+    }
+
+    // hot pixels in both, some saturated so the subtraction clips
+    for (int i = 0; i < w * h / 50 + 1; i++)
+    {
+        int const p = px(rng);
+        f.light[p] = 65535;
+        f.dark[p] = 30000;
+        f.defects.Add(p % w, p / w);
+    }
+    for (int i = 0; i < w * h / 200 + 1; i++)
+        f.dark[px(rng)] = 65535;
+
+    return f;
+}
+
+// at least 2x2, like the frame: the 3x3 median needs a neighbor on each axis
+static FrameRect RandomRect(int w, int h, std::mt19937& rng)
+{
+    std::uniform_int_distribution<int> rw(2, w), rh(2, h);
+    int const width = rw(rng), height = rh(rng);
+    std::uniform_int_distribution<int> rx(0, w - width), ry(0, h - height);
+    FrameRect const r = { rx(rng), ry(rng), width, height };
+    return r;
+}
+
+// the separate passes, the way Subtract, RemoveDefects, QuickLRecon, Median3 and
+// usImage::CalcStats run them one after the other
+static void Separate(std::vector<unsigned short>& img, std::vector<unsigned short>& filtered, const Frame& f,
+    const FrameRect& r, Correction corr, int pedestal, PreprocessNoiseReduction nr, FrameStats *stats)
+{
+    int const w = f.width;
+
+    for (int y = r.y; y < r.y + r.height; y++)
+    {
+        if (corr == DARK)
+            SubtractDarkRow(&img[y * w + r.x], &f.dark[y * w + r.x], r.width, pedestal);
+        else if (corr == DEFECTS)
+            RemoveDefectRow(img.data(), w, f.height, f.defects, y, r.x, r.x + r.width - 1);
+    }
+
+    switch (nr)
+    {
+    case PREPROCESS_NR_NONE:
+        filtered = img;
+        break;
+    case PREPROCESS_NR_2x2MEAN:
+        Mean2x2Rows(filtered.data(), img.data(), w, r, 0, r.height);
+        break;
+    case PREPROCESS_NR_3x3MEDIAN:
+        Median3Rows(filtered.data(), img.data(), w, r, 0, r.height);
+        break;
+    }
+
+    CalcFrameStats(stats, filtered.data(), w, r);
+}
+
+static void Check(const Frame& f, const FrameRect& r, Correction corr, int pedestal, PreprocessNoiseReduction nr)
+{
+    std::vector<unsigned short> img1(f.light), filt1(f.light.size());
+    FrameStats want;
+    Separate(img1, filt1, f, r, corr, pedestal, nr, &want);
+
+    std::vector<unsigned short> img2(f.light), filt2(f.light.size());
+    unsigned short *const filtered = nr == PREPROCESS_NR_NONE ? img2.data() : filt2.data();
+    FrameStats got;
+    PreprocessFrame(img2.data(), filtered, f.width, f.height, r,
+        corr == DARK ? f.dark.data() : nullptr, pedestal, corr == DEFECTS ? &f.defects : nullptr, nr, &got);
+    if (nr == PREPROCESS_NR_NONE)
+        filt2 = img2;
+
+    ASSERT_EQ(img1, img2);
+    ASSERT_EQ(filt1, filt2);
+    EXPECT_EQ(want.minADU, got.minADU);
+    EXPECT_EQ(want.maxADU, got.maxADU);
+    EXPECT_EQ(want.medianADU, got.medianADU);
+    EXPECT_EQ(want.filtMin, got.filtMin);
+    EXPECT_EQ(want.filtMax, got.filtMax);
+}
+
+static const char *Name(Correction corr)
+{
+    return corr == DARK ? "dark" : corr == DEFECTS ? "defects" : "none";
+}
+
+static void CheckAll(const Frame& f, const FrameRect& r, int pedestal)
+{
+    for (Correction corr : { NO_CORRECTION, DARK, DEFECTS })
+        for (PreprocessNoiseReduction nr : { PREPROCESS_NR_NONE, PREPROCESS_NR_2x2MEAN, PREPROCESS_NR_3x3MEDIAN })
+        {
+            SCOPED_TRACE(testing::Message() << f.width << "x" << f.height << " rect " << r.width << "x" << r.height
+                << "@" << r.x << "," << r.y << " correction " << Name(corr) << " nr " << nr);
+            Check(f, r, corr, pedestal, nr);
+        }
+}
+
+TEST(PreprocessTest, FullFrame)
+{
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> size(2, 48), ped(0, 300);
+
+    for (int iter = 0; iter < 200; iter++)
+    {
+        Frame const f = MakeFrame(size(rng), size(rng), rng);
+        FrameRect const r = { 0, 0, f.width, f.height };
+        CheckAll(f, r, ped(rng));
+    }
+
+    Frame const big = MakeFrame(640, 480, rng);
+    FrameRect const r = { 0, 0, big.width, big.height };
+    CheckAll(big, r, 150);
+}
+
+TEST(PreprocessTest, Subframe)
+{
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<int> size(2, 48), ped(0, 300);
+
+    for (int iter = 0; iter < 200; iter++)
+    {
+        Frame const f = MakeFrame(size(rng), size(rng), rng);
+        CheckAll(f, RandomRect(f.width, f.height, rng), ped(rng));
+    }
+
+    Frame const big = MakeFrame(640, 480, rng);
+    FrameRect const r = { 100, 60, 200, 150 };
+    CheckAll(big, r, 150);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,283 @@
+/*
+ *  star_find_test.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+
+// Checks the star measurement behind Star::Find on synthetic frames and reports
+// how long a find takes with a cold and a warm started background estimate.
+
+#include <gtest/gtest.h>
+#include "star_find.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+enum { FRAME_W = 320, FRAME_H = 240 };
+
+// a gaussian star of the given sigma on a noisy background
+struct Frame
+{
+    std::vector<unsigned short> px;
+    StarFindImage img;
+
+    Frame() : px(FRAME_W * FRAME_H)
+    {
+        img.pixels = &px[0];
+        img.rowsize = FRAME_W;
+        img.minx = img.miny = 0;
+        img.maxx = FRAME_W - 1;
+        img.maxy = FRAME_H - 1;
+        img.pedestal = 0;
+        img.bitsPerPixel = 16;
+    }
+
+    void Draw(std::mt19937& rng, double bg, double noise, double cx, double cy, double amp, double sigma)
+    {
+        std::normal_distribution<double> n(0., noise > 0. ? noise : 1.);
+        for (int y = 0; y < FRAME_H; y++)
+        {
+            for (int x = 0; x < FRAME_W; x++)
+            {
+                double const r2 = (x - cx) * (x - cx) + (y - cy) * (y - cy);
+                double v = bg + amp * exp(-r2 / (2. * sigma * sigma));
+                if (noise > 0.)
+                    v += n(rng);
+                px[y * FRAME_W + x] = (unsigned short) std::min(65535., std::max(0., v + 0.5));
+            }
+        }
+    }
+};
+
+static StarMeasurement Measure(const Frame& f, StarBackground *bg, int x, int y, bool findPeak = false,
+                               double minHFD = 0., unsigned short maxADU = 0)
+{
+    StarMeasurement m;
+    bool const ok = MeasureStar(&m, bg, f.img, 15, x, y, findPeak, minHFD, maxADU, nullptr);
+    EXPECT_TRUE(ok);
+    return m;
+}
+
+TEST(StarFindTest, Centroid)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> u(-0.5, 0.5);
+    Frame f;
+
+    for (int i = 0; i < 50; i++)
+    {
+        double const cx = 160. + u(rng), cy = 120. + u(rng);
+        f.Draw(rng, 1000., 5., cx, cy, 3000., 1.5);
+
+        StarBackground bg = { 0., 0., false };
+        StarMeasurement m = Measure(f, &bg, 158, 122);
+
+        EXPECT_EQ(STAR_FIND_OK, m.result);
+        EXPECT_NEAR(cx, m.x, 0.05);
+        EXPECT_NEAR(cy, m.y, 0.05);
+        EXPECT_TRUE(bg.valid);
+        EXPECT_NEAR(1000., bg.mean, 2.);
+    }
+}
+
+TEST(StarFindTest, HFDFollowsStarSize)
+{
+    std::mt19937 rng(2);
+    Frame f;
+    double prev = 0.;
+
+    for (double sigma = 1.; sigma <= 3.; sigma += 0.5)
+    {
+        f.Draw(rng, 1000., 5., 100.3, 80.6, 5000., sigma);
+        StarBackground bg = { 0., 0., false };
+        StarMeasurement m = Measure(f, &bg, 100, 80);
+
+        EXPECT_EQ(STAR_FIND_OK, m.result);
+        // the half flux diameter of a gaussian is 2.355 sigma; the pixel grid, the
+        // threshold and the aperture all trim it a little
+        EXPECT_NEAR(2.355 * sigma, m.hfd, 0.2 * sigma + 0.25);
+        EXPECT_GT(m.hfd, prev);
+        prev = m.hfd;
+
+        StarBackground bg2 = { 0., 0., false };
+        EXPECT_EQ(STAR_FIND_LOWHFD, Measure(f, &bg2, 100, 80, false, m.hfd + 0.5).result);
+    }
+}
+
+TEST(StarFindTest, NoStar)
+{
+    std::mt19937 rng(3);
+    Frame f;
+    f.Draw(rng, 1000., 10., 0., 0., 0., 1.);
+
+    StarBackground bg = { 0., 0., false };
+    StarMeasurement m = Measure(f, &bg, 160, 120);
+
+    EXPECT_TRUE(m.result == STAR_FIND_LOWSNR || m.result == STAR_FIND_LOWMASS);
+    EXPECT_EQ(160., m.x);
+    EXPECT_EQ(120., m.y);
+    EXPECT_EQ(0., m.hfd);
+}
+
+TEST(StarFindTest, Saturation)
+{
+    std::mt19937 rng(4);
+    Frame f;
+    f.Draw(rng, 1000., 5., 160.2, 120.4, 200000., 2.);
+
+    StarBackground bg = { 0., 0., false };
+    // flat top
+    EXPECT_EQ(STAR_FIND_SATURATED, Measure(f, &bg, 160, 120).result);
+    // known saturation level
+    EXPECT_EQ(STAR_FIND_SATURATED, Measure(f, &bg, 160, 120, false, 0., 60000).result);
+
+    f.Draw(rng, 1000., 5., 160.2, 120.4, 20000., 2.);
+    EXPECT_EQ(STAR_FIND_OK, Measure(f, &bg, 160, 120).result);
+    EXPECT_EQ(STAR_FIND_OK, Measure(f, &bg, 160, 120, false, 0., 60000).result);
+    EXPECT_EQ(STAR_FIND_SATURATED, Measure(f, &bg, 160, 120, false, 0., 15000).result);
+}
+
+TEST(StarFindTest, FindPeak)
+{
+    std::mt19937 rng(5);
+    Frame f;
+    f.Draw(rng, 1000., 0., 100., 60., 3000., 1.5);
+
+    StarBackground bg = { 0., 0., false };
+    StarMeasurement m = Measure(f, &bg, 105, 55, true);
+
+    EXPECT_EQ(STAR_FIND_OK, m.result);
+    EXPECT_EQ(100., m.x);
+    EXPECT_EQ(60., m.y);
+    EXPECT_EQ(4000, m.peakVal);
+}
+
+TEST(StarFindTest, OutsideImage)
+{
+    Frame f;
+    StarBackground bg = { 0., 0., false };
+    StarMeasurement m;
+
+    EXPECT_FALSE(MeasureStar(&m, &bg, f.img, 15, -100, 120, false, 0., 0, nullptr));
+    EXPECT_FALSE(MeasureStar(&m, &bg, f.img, 15, 160, FRAME_H + 100, false, 0., 0, nullptr));
+
+    // the search region is limited to the subframe
+    f.img.minx = 200;
+    f.img.maxx = 299;
+    EXPECT_FALSE(MeasureStar(&m, &bg, f.img, 15, 160, 120, false, 0., 0, nullptr));
+    EXPECT_FALSE(bg.valid);
+}
+
+// the warm started background estimate must agree with the cold start on a
+// steady background, and recover when the background jumps
+TEST(StarFindTest, WarmStartMatchesColdStart)
+{
+    std::mt19937 rng(6);
+    Frame f;
+    StarBackground warm = { 0., 0., false };
+
+    for (int i = 0; i < 40; i++)
+    {
+        double const level = i < 20 ? 1000. : 2500.;
+        f.Draw(rng, level, 8., 160.3, 119.8, 2000., 1.8);
+
+        StarBackground cold = { 0., 0., false };
+        StarMeasurement const c = Measure(f, &cold, 160, 120);
+        StarMeasurement const w = Measure(f, &warm, 160, 120);
+
+        EXPECT_EQ(c.result, w.result);
+        EXPECT_NEAR(cold.mean, warm.mean, 0.5);
+        EXPECT_NEAR(c.x, w.x, 0.01);
+        EXPECT_NEAR(c.y, w.y, 0.01);
+        EXPECT_NEAR(c.snr, w.snr, 0.02 * c.snr);
+        EXPECT_NEAR(level, warm.mean, 2.);
+    }
+}
+
+// not a pass/fail test: reports the time per find with a cold and a warm started
+// background estimate
+TEST(StarFindTest, Benchmark)
+{
+    struct Case { const char *name; double noise; double amp; double sigma; bool findPeak; };
+    static const Case cases[] = {
+        { "bright star", 5., 10000., 1.5, false },
+        { "faint star", 20., 300., 2.5, false },
+        { "find peak", 5., 10000., 1.5, true },
+    };
+
+    enum { FRAMES = 16, REPS = 20000 };
+
+    typedef std::chrono::steady_clock clock;
+
+    for (const Case& c : cases)
+    {
+        // a few frames with the star moving about, as when guiding
+        std::mt19937 rng(7);
+        std::normal_distribution<double> jitter(0., 0.5);
+        std::vector<Frame> frames(FRAMES);
+        for (Frame& f : frames)
+            f.Draw(rng, 1000., c.noise, 160. + jitter(rng), 120. + jitter(rng), c.amp, c.sigma);
+
+        StarMeasurement m;
+        double sum = 0.;
+
+        clock::time_point t0 = clock::now();
+        for (int i = 0; i < REPS; i++)
+        {
+            StarBackground cold = { 0., 0., false };
+            MeasureStar(&m, &cold, frames[i % FRAMES].img, 15, 160, 120, c.findPeak, 0., 0, nullptr);
+            sum += m.x;
+        }
+        double const coldUs = std::chrono::duration<double, std::micro>(clock::now() - t0).count() / REPS;
+
+        StarBackground warm = { 0., 0., false };
+        t0 = clock::now();
+        for (int i = 0; i < REPS; i++)
+        {
+            MeasureStar(&m, &warm, frames[i % FRAMES].img, 15, 160, 120, c.findPeak, 0., 0, nullptr);
+            sum += m.x;
+        }
+        double const warmUs = std::chrono::duration<double, std::micro>(clock::now() - t0).count() / REPS;
+
+        EXPECT_GT(sum, 0.);
+        printf("%-12s cold %7.2f us  warm %7.2f us per find\n", c.name, coldUs, warmUs);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
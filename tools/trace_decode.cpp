@@ -0,0 +1,186 @@
+/*
+ *  trace_decode.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Converts a PHD2 binary trace log (PHD2_TraceLog_*.bin) to text or CSV.
+//
+//   phd2_trace_decode [--csv] PHD2_TraceLog_YYYY-mm-dd_HHMMSS.bin
+
+#include "trace_format.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static const char *DirectionName(unsigned int dir)
+{
+    // matches GUIDE_DIRECTION in PHD2
+    static const char *const names[] = { "N", "S", "E", "W" };
+    return dir < sizeof(names) / sizeof(names[0]) ? names[dir] : "?";
+}
+
+static void FormatWallClock(char *buf, size_t size, int64_t ms)
+{
+    time_t secs = (time_t) (ms / 1000);
+    struct tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &secs);
+#else
+    localtime_r(&secs, &tm);
+#endif
+    size_t n = strftime(buf, size, "%Y-%m-%d %H:%M:%S", &tm);
+    snprintf(buf + n, size - n, ".%03d", (int) (ms % 1000));
+}
+
+static int Usage()
+{
+    fprintf(stderr, "usage: phd2_trace_decode [--csv] TRACEFILE\n");
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    bool csv = false;
+    const char *path = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--csv") == 0)
+            csv = true;
+        else if (!path)
+            path = argv[i];
+        else
+            return Usage();
+    }
+
+    if (!path)
+        return Usage();
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+    {
+        perror(path);
+        return 1;
+    }
+
+    TRACE_FILE_HEADER hdr;
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1 || memcmp(hdr.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0)
+    {
+        fprintf(stderr, "%s: not a PHD2 trace log\n", path);
+        fclose(fp);
+        return 1;
+    }
+
+    if (hdr.version != TRACE_VERSION || hdr.recordSize != sizeof(TRACE_RECORD))
+    {
+        fprintf(stderr, "%s: unsupported trace log version %u, record size %u\n", path, hdr.version, hdr.recordSize);
+        fclose(fp);
+        return 1;
+    }
+
+    if (csv)
+        printf("Time,Type,Frame,Arg,V1,V2,V3,V4\n");
+    else
+    {
+        printf("Summary: calcnt:%u gcnt:%u gdur:%.f gacnt:%u%s\n",
+            hdr.summary.cal_cnt, hdr.summary.guide_cnt, hdr.summary.guide_dur, hdr.summary.ga_cnt,
+            (hdr.flags & TRACE_FLAG_COVERS_GUIDELOG) ? "" : " (partial)");
+    }
+
+    int64_t openMs = 0;
+    TRACE_RECORD rec;
+    char ts[64];
+
+    while (fread(&rec, sizeof(rec), 1, fp) == 1)
+    {
+        if (rec.type == TR_OPEN)
+            openMs = rec.i64[0];
+
+        FormatWallClock(ts, sizeof(ts), openMs + (int64_t) (rec.t / 1000));
+
+        const char *type;
+        switch (rec.type)
+        {
+        case TR_OPEN:            type = "Open"; break;
+        case TR_FRAME:           type = "Frame"; break;
+        case TR_STAR:            type = "Star"; break;
+        case TR_GUIDE_STEP:      type = "GuideStep"; break;
+        case TR_PULSE:           type = "Pulse"; break;
+        case TR_GUIDING_BEGIN:   type = "GuidingBegins"; break;
+        case TR_GUIDING_END:     type = "GuidingEnds"; break;
+        case TR_CALIBRATION_END: type = "CalibrationComplete"; break;
+        case TR_GA_RESULT:       type = "GAResult"; break;
+        default:                 type = "Unknown"; break;
+        }
+
+        if (csv)
+        {
+            if (rec.type == TR_OPEN)
+                printf("%s,%s,,,,,,\n", ts, type);
+            else
+                printf("%s,%s,%u,%u,%g,%g,%g,%g\n", ts, type, rec.frame, rec.arg, rec.f[0], rec.f[1], rec.f[2], rec.f[3]);
+            continue;
+        }
+
+        printf("%s %s", ts, type);
+
+        switch (rec.type)
+        {
+        case TR_FRAME:
+            printf(" frame=%u exp=%.f ms size=%.fx%.f", rec.frame, rec.f[0], rec.f[1], rec.f[2]);
+            break;
+        case TR_STAR:
+            printf(" frame=%u pos=(%.2f,%.2f) snr=%.1f hfd=%.2f", rec.frame, rec.f[0], rec.f[1], rec.f[2], rec.f[3]);
+            break;
+        case TR_GUIDE_STEP:
+            printf(" frame=%u %s dx=%.3f dy=%.3f ra=%.3f dec=%.3f", rec.frame, rec.arg ? "AO" : "Mount",
+                rec.f[0], rec.f[1], rec.f[2], rec.f[3]);
+            break;
+        case TR_PULSE:
+            printf(" frame=%u dir=%s dur=%.f ms", rec.frame, DirectionName(rec.arg), rec.f[0]);
+            break;
+        case TR_GUIDING_END:
+            printf(" frame=%u dur=%.f s", rec.frame, rec.f[0]);
+            break;
+        case TR_OPEN:
+            break;
+        default:
+            printf(" frame=%u", rec.frame);
+            break;
+        }
+
+        printf("\n");
+    }
+
+    fclose(fp);
+    return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ *  trace_format.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef TRACE_FORMAT_H_INCLUDED
+#define TRACE_FORMAT_H_INCLUDED
+
+// On-disk layout of the binary trace log (PHD2_TraceLog_*.bin). This header is
+// shared with the offline decoder (tools/trace_decode.cpp) so it must not depend
+// on wxWidgets.
+//
+// The file is a TRACE_FILE_HEADER followed by TRACE_RECORDs, native byte order.
+// Record timestamps are microseconds on a monotonic clock since the preceding
+// TR_OPEN record, which carries the wall-clock time.
+
+#include <stdint.h>
+
+#define TRACE_MAGIC "PHD2TRC"
+
+enum
+{
+    TRACE_VERSION = 1,
+};
+
+enum TraceFileFlags
+{
+    // The header summary covers every guide log event in the guide log of the
+    // same name, up to guideLogSize bytes of it
+    TRACE_FLAG_COVERS_GUIDELOG = (1 << 0),
+};
+
+struct TRACE_SUMMARY
+{
+    uint32_t cal_cnt;
+    uint32_t guide_cnt;
+    uint32_t ga_cnt;
+    uint32_t reserved;
+    double guide_dur;       // seconds
+};
+
+struct TRACE_FILE_HEADER
+{
+    char magic[8];
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t flags;
+    uint64_t guideLogSize;  // guide log size when the summary was last updated
+    TRACE_SUMMARY summary;
+    uint8_t reserved[16];
+};
+
+enum TraceRecordType
+{
+    TR_OPEN = 1,            // i64[0] = wall clock, ms since 1970 UTC
+    TR_FRAME = 2,           // frame captured: f[0] = exposure ms, f[1],f[2] = width, height
+    TR_STAR = 3,            // star found: f[0],f[1] = x,y  f[2] = SNR  f[3] = HFD
+    TR_GUIDE_STEP = 4,      // arg = 1 for AO; f[0],f[1] = camera dx,dy  f[2],f[3] = RA,Dec guide distance
+    TR_PULSE = 5,           // arg = GUIDE_DIRECTION; f[0] = duration ms
+    TR_GUIDING_BEGIN = 6,
+    TR_GUIDING_END = 7,     // f[0] = guiding duration, seconds
+    TR_CALIBRATION_END = 8,
+    TR_GA_RESULT = 9,
+};
+
+struct TRACE_RECORD
+{
+    uint64_t t;             // microseconds since TR_OPEN
+    uint16_t type;
+    uint16_t arg;
+    uint32_t frame;
+    union
+    {
+        float f[4];
+        int64_t i64[2];
+    };
+};
+
+static_assert(sizeof(TRACE_FILE_HEADER) == 64, "trace file header layout");
+static_assert(sizeof(TRACE_RECORD) == 32, "trace record layout");
+
+#endif
@@ -0,0 +1,395 @@
+/*
+ *  trace_log.cpp
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "phd.h"
+
+#include <chrono>
+#include <fstream>
+
+const int RetentionPeriod = 30;
+
+enum
+{
+    // records are written to the file in batches of this many
+    BUFFERED_RECORDS = 128,
+    // and at least this often, milliseconds
+    FLUSH_INTERVAL = 1000,
+};
+
+static int64_t MonotonicMicros()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static void InitHeader(TRACE_FILE_HEADER *hdr)
+{
+    memset(hdr, 0, sizeof(*hdr));
+    memcpy(hdr->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    hdr->version = TRACE_VERSION;
+    hdr->recordSize = sizeof(TRACE_RECORD);
+}
+
+static bool HeaderOk(const TRACE_FILE_HEADER& hdr)
+{
+    return memcmp(hdr.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) == 0 &&
+        hdr.version == TRACE_VERSION && hdr.recordSize == sizeof(TRACE_RECORD);
+}
+
+static uint64_t FileSize(const wxString& path)
+{
+    wxULongLong size = wxFileName::GetSize(path);
+    return size == wxInvalidSize ? 0 : size.GetValue();
+}
+
+TraceLog::TraceLog()
+    :
+    m_enabled(false),
+    m_t0(0),
+    m_flushTimer(nullptr)
+{
+    InitHeader(&m_header);
+    m_buf.reserve(BUFFERED_RECORDS);
+}
+
+TraceLog::~TraceLog()
+{
+    CloseFile();
+}
+
+uint64_t TraceLog::GuideLogSize() const
+{
+    return FileSize(m_guideLogPath);
+}
+
+void TraceLog::Open(const wxDateTime& logFileTime)
+{
+    StopFlushTimer();
+
+    wxCriticalSectionLocker lock(m_lock);
+
+    CloseFile();
+
+    if (!pConfig->Global.GetBoolean("/TraceLog/Enabled", false))
+        return;
+
+    m_guideLogPath = GetLogDir() + PATHSEPSTR + logFileTime.Format(_T("PHD2_GuideLog_%Y-%m-%d_%H%M%S.txt"));
+    wxString path = GetLogDir() + PATHSEPSTR + logFileTime.Format(_T("PHD2_TraceLog_%Y-%m-%d_%H%M%S.bin"));
+
+    uint64_t guideLogSize = GuideLogSize();
+    bool append = false;
+
+    if (wxFileExists(path) && m_file.Open(path, "r+b"))
+    {
+        wxFileOffset len = m_file.Length();
+        if (m_file.Read(&m_header, sizeof(m_header)) == sizeof(m_header) && HeaderOk(m_header))
+        {
+            // a run without tracing may have added to the guide log since the
+            // summary was last updated
+            if (m_header.guideLogSize != guideLogSize)
+                m_header.flags &= ~TRACE_FLAG_COVERS_GUIDELOG;
+
+            // drop a partial record left behind by a crash
+            wxFileOffset nrec = (len - (wxFileOffset) sizeof(m_header)) / (wxFileOffset) sizeof(TRACE_RECORD);
+            m_file.Seek(sizeof(m_header) + nrec * sizeof(TRACE_RECORD));
+            append = true;
+        }
+        else
+            m_file.Close();
+    }
+
+    if (!append)
+    {
+        if (!m_file.Open(path, "w+b"))
+        {
+            Debug.Write(wxString::Format("TraceLog: unable to open %s\n", path));
+            return;
+        }
+
+        InitHeader(&m_header);
+        // the summary can only stand in for the guide log if it saw all of it
+        if (guideLogSize == 0)
+            m_header.flags |= TRACE_FLAG_COVERS_GUIDELOG;
+        m_file.Write(&m_header, sizeof(m_header));
+    }
+
+    m_enabled = true;
+    m_t0 = MonotonicMicros();
+
+    TRACE_RECORD rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.type = TR_OPEN;
+    rec.i64[0] = wxGetUTCTimeMillis().GetValue();
+    Append(rec);
+
+    UpdateHeader();
+
+    m_flushTimer = new LogFlushTimer([this]() { Flush(); });
+    m_flushTimer->Start(FLUSH_INTERVAL);
+
+    Debug.Write(wxString::Format("TraceLog: opened %s flags=%u\n", path, m_header.flags));
+}
+
+void TraceLog::Close()
+{
+    StopFlushTimer();
+
+    wxCriticalSectionLocker lock(m_lock);
+    CloseFile();
+}
+
+// the timer lives on the GUI thread, so Open and Close are only called from there
+void TraceLog::StopFlushTimer()
+{
+    delete m_flushTimer;
+    m_flushTimer = nullptr;
+}
+
+void TraceLog::CloseFile()
+{
+    if (!m_file.IsOpened())
+        return;
+
+    UpdateHeader();
+    m_file.Close();
+    m_enabled = false;
+}
+
+void TraceLog::Flush()
+{
+    if (!m_enabled)
+        return;
+
+    wxCriticalSectionLocker lock(m_lock);
+
+    if (m_file.IsOpened())
+    {
+        WriteBuffered();
+        m_file.Flush();
+    }
+}
+
+void TraceLog::RemoveOldFiles()
+{
+    Logger::RemoveMatchingFiles("PHD2_TraceLog*.bin", RetentionPeriod);
+}
+
+// m_lock must be held
+void TraceLog::WriteBuffered()
+{
+    if (!m_buf.empty() && m_file.IsOpened())
+        m_file.Write(m_buf.data(), m_buf.size() * sizeof(TRACE_RECORD));
+    m_buf.clear();
+}
+
+// m_lock must be held
+void TraceLog::UpdateHeader()
+{
+    if (!m_file.IsOpened())
+        return;
+
+    WriteBuffered();
+
+    m_header.guideLogSize = GuideLogSize();
+
+    wxFileOffset pos = m_file.Tell();
+    m_file.Seek(0);
+    m_file.Write(&m_header, sizeof(m_header));
+    m_file.Seek(pos);
+    m_file.Flush();
+}
+
+// m_lock must be held
+void TraceLog::Append(TRACE_RECORD& rec)
+{
+    rec.t = MonotonicMicros() - m_t0;
+    m_buf.push_back(rec);
+    if (m_buf.size() >= BUFFERED_RECORDS)
+        WriteBuffered();
+}
+
+void TraceLog::FrameCaptured(const usImage *img)
+{
+    if (!m_enabled)
+        return;
+
+    TRACE_RECORD rec;
+    rec.type = TR_FRAME;
+    rec.arg = 0;
+    rec.frame = img->FrameNum;
+    rec.f[0] = (float) img->ImgExpDur;
+    rec.f[1] = (float) img->Size.GetWidth();
+    rec.f[2] = (float) img->Size.GetHeight();
+    rec.f[3] = 0.f;
+
+    wxCriticalSectionLocker lock(m_lock);
+    Append(rec);
+}
+
+void TraceLog::StarFound(unsigned int frameNumber, const PHD_Point& pos, double snr, double hfd)
+{
+    if (!m_enabled)
+        return;
+
+    TRACE_RECORD rec;
+    rec.type = TR_STAR;
+    rec.arg = 0;
+    rec.frame = frameNumber;
+    rec.f[0] = (float) pos.X;
+    rec.f[1] = (float) pos.Y;
+    rec.f[2] = (float) snr;
+    rec.f[3] = (float) hfd;
+
+    wxCriticalSectionLocker lock(m_lock);
+    Append(rec);
+}
+
+void TraceLog::GuideStep(const GuideStepInfo& step)
+{
+    if (!m_enabled)
+        return;
+
+    TRACE_RECORD rec;
+    rec.type = TR_GUIDE_STEP;
+    rec.arg = step.mount->IsStepGuider() ? 1 : 0;
+    rec.frame = step.frameNumber;
+    rec.f[0] = (float) step.cameraOffset.X;
+    rec.f[1] = (float) step.cameraOffset.Y;
+    rec.f[2] = (float) step.guideDistanceRA;
+    rec.f[3] = (float) step.guideDistanceDec;
+
+    wxCriticalSectionLocker lock(m_lock);
+    Append(rec);
+}
+
+void TraceLog::Pulse(int direction, int duration)
+{
+    if (!m_enabled)
+        return;
+
+    TRACE_RECORD rec;
+    rec.type = TR_PULSE;
+    rec.arg = (uint16_t) direction;
+    rec.frame = pFrame ? pFrame->m_frameCounter : 0;
+    rec.f[0] = (float) duration;
+    rec.f[1] = rec.f[2] = rec.f[3] = 0.f;
+
+    wxCriticalSectionLocker lock(m_lock);
+    Append(rec);
+}
+
+void TraceLog::GuidingStarted()
+{
+    if (!m_enabled)
+        return;
+
+    TRACE_RECORD rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.type = TR_GUIDING_BEGIN;
+    rec.frame = pFrame->m_frameCounter;
+
+    wxCriticalSectionLocker lock(m_lock);
+    Append(rec);
+    UpdateHeader();
+}
+
+void TraceLog::GuidingStopped(double duration)
+{
+    if (!m_enabled)
+        return;
+
+    TRACE_RECORD rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.type = TR_GUIDING_END;
+    rec.frame = pFrame->m_frameCounter;
+    rec.f[0] = (float) duration;
+
+    wxCriticalSectionLocker lock(m_lock);
+    ++m_header.summary.guide_cnt;
+    m_header.summary.guide_dur += duration;
+    Append(rec);
+    UpdateHeader();
+}
+
+void TraceLog::CalibrationComplete()
+{
+    if (!m_enabled)
+        return;
+
+    TRACE_RECORD rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.type = TR_CALIBRATION_END;
+    rec.frame = pFrame->m_frameCounter;
+
+    wxCriticalSectionLocker lock(m_lock);
+    ++m_header.summary.cal_cnt;
+    Append(rec);
+    UpdateHeader();
+}
+
+void TraceLog::GAResult()
+{
+    if (!m_enabled)
+        return;
+
+    TRACE_RECORD rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.type = TR_GA_RESULT;
+    rec.frame = pFrame->m_frameCounter;
+
+    wxCriticalSectionLocker lock(m_lock);
+    ++m_header.summary.ga_cnt;
+    Append(rec);
+    UpdateHeader();
+}
+
+/*
+ * Read the session summary from a trace file header. Returns false unless the
+ * trace saw every session event in the guide log as it is now.
+ */
+bool TraceLog::LoadSummary(const wxString& tracePath, const wxString& guideLogPath, TRACE_SUMMARY *summary)
+{
+    std::ifstream ifs(tracePath.fn_str(), std::ios::binary);
+    if (!ifs)
+        return false;
+
+    TRACE_FILE_HEADER hdr;
+    if (!ifs.read(reinterpret_cast<char *>(&hdr), sizeof(hdr)) || !HeaderOk(hdr))
+        return false;
+
+    if ((hdr.flags & TRACE_FLAG_COVERS_GUIDELOG) == 0 || hdr.guideLogSize != FileSize(guideLogPath))
+        return false;
+
+    *summary = hdr.summary;
+    return true;
+}
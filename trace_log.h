@@ -0,0 +1,99 @@
+/*
+ *  trace_log.h
+ *  PHD2 Guiding
+ *
+ *  Copyright (c) 2026 openphdguiding.org
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of OpenPHDGuiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef TRACE_LOG_H_INCLUDED
+#define TRACE_LOG_H_INCLUDED
+
+#include "logger.h"
+#include "trace_format.h"
+
+struct GuideStepInfo;
+
+/*
+ * Optional binary trace of per-frame guiding internals, written next to the
+ * debug log as fixed-size records (see trace_format.h). Enabled with the global
+ * setting /TraceLog/Enabled. Records are buffered and written once a second by
+ * a timer on the GUI thread, or sooner when the buffer fills; the session summary in the file header is rewritten on guide
+ * log session events so the log uploader can index a session by reading the
+ * header alone.
+ */
+class TraceLog : public Logger
+{
+    bool m_enabled;
+    wxCriticalSection m_lock;
+    wxFFile m_file;
+    wxString m_guideLogPath;
+    TRACE_FILE_HEADER m_header;
+    std::vector<TRACE_RECORD> m_buf;
+    int64_t m_t0;               // monotonic clock at TR_OPEN, microseconds
+    LogFlushTimer *m_flushTimer;
+
+    void Append(TRACE_RECORD& rec);
+    void WriteBuffered();
+    void UpdateHeader();
+    void CloseFile();
+    void StopFlushTimer();
+    uint64_t GuideLogSize() const;
+
+public:
+    TraceLog();
+    ~TraceLog();
+
+    static bool LoadSummary(const wxString& tracePath, const wxString& guideLogPath, TRACE_SUMMARY *summary);
+
+    void Open(const wxDateTime& logFileTime);
+    void Close();
+    bool IsEnabled() const;
+    void Flush();
+    void RemoveOldFiles();
+
+    void FrameCaptured(const usImage *img);
+    void StarFound(unsigned int frameNumber, const PHD_Point& pos, double snr, double hfd);
+    void GuideStep(const GuideStepInfo& step);
+    void Pulse(int direction, int duration);
+
+    // guide log session events, reported by GuidingLog
+    void GuidingStarted();
+    void GuidingStopped(double duration);
+    void CalibrationComplete();
+    void GAResult();
+};
+
+inline bool TraceLog::IsEnabled() const
+{
+    return m_enabled;
+}
+
+extern TraceLog Trace;
+
+#endif
@@ -34,8 +34,13 @@
 
 #include "phd.h"
 #include "image_math.h"
+#include "image_kernels.h"
+#include "image_rotate.h"
+#include "median3.h"
+#include "parallel_for.h"
 
 #include <algorithm>
+#include <memory>
 
 bool usImage::Init(const wxSize& size)
 {
@@ -50,11 +55,12 @@ bool usImage::Init(const wxSize& size)
 
     if (NPixels != prev)
     {
-        delete[] ImageData;
+        // buffers are recycled through the image pool rather than freed
+        ImagePool::Release(ImageData, prev);
 
         if (NPixels)
         {
-            ImageData = new unsigned short[NPixels];
+            ImageData = ImagePool::Acquire(NPixels);
             if (!ImageData)
             {
                 NPixels = 0;
@@ -80,81 +86,122 @@ void usImage::CalcStats()
     if (!ImageData || !NPixels)
         return;
 
-    MinADU = 65535; MaxADU = 0;
-    FiltMin = 65535; FiltMax = 0;
+    FrameStats stats;
+    CalcFrameStats(&stats, ImageData, Size, Subframe.IsEmpty() ? wxRect(Size) : Subframe);
 
-    if (Subframe.IsEmpty())
+    MinADU = stats.minADU;
+    MaxADU = stats.maxADU;
+    MedianADU = stats.medianADU;
+    FiltMin = stats.filtMin;
+    FiltMax = stats.filtMax;
+}
+
+// Display stretch lookup table: maps an ADU value to a display level. Computing
+// the stretch (and the gamma pow()) per pixel is by far the most expensive part
+// of the display copy, so the table is cached and only rebuilt when the levels or
+// gamma change. Levels at or above the saturation point all map to the same
+// value, so only the entries up to there need to be computed.
+struct DisplayStretch
+{
+    enum Mode
     {
-        // full frame, no subframe
+        STRETCH_FULL,       // CopyToImage
+        STRETCH_BINNED,     // BinnedCopyToImage, applied to the 2x2 mean
+    };
 
-        for (unsigned int i = 0; i < NPixels; i++)
-        {
-            unsigned short d = ImageData[i];
-            if (d < MinADU) MinADU = d;
-            if (d > MaxADU) MaxADU = d;
-        }
+    bool valid;
+    Mode mode;
+    int blevel;
+    int wlevel;
+    double power;
+    unsigned char lut[65536];
 
-        unsigned short *tmpdata = new unsigned short[NPixels];
+    DisplayStretch() : valid(false) { }
 
-        Median3(tmpdata, ImageData, Size, wxRect(Size));
+    const unsigned char *Get(Mode mode, int blevel, int wlevel, double power);
 
-        const unsigned short *src = tmpdata;
-        for (unsigned int i = 0; i < NPixels; i++)
+private:
+    static unsigned char Full(unsigned int v, int blevel, int wlevel, double power);
+    static unsigned char Binned(unsigned int v, int blevel, int wlevel, double power);
+};
+
+inline unsigned char DisplayStretch::Full(unsigned int v, int blevel, int wlevel, double power)
+{
+    float d;
+
+    if (power == 1.0 || blevel >= wlevel)
+    {
+        float range = (float) wxMax(1, wlevel);  // Go 0-max
+        if (v >= range)
+            d = 255.0;
+        else
+            d = ((float) v / range) * 255.0;
+    }
+    else
+    {
+        float range = (float) (wlevel - blevel);
+        if ((int) v <= blevel)
+            d = 0.0;
+        else if ((int) v >= wlevel)
+            d = 255.0;
+        else
         {
-            unsigned short d = *src++;
-            if (d < FiltMin) FiltMin = d;
-            if (d > FiltMax) FiltMax = d;
+            d = ((float) v - (float) blevel) / range;
+            d = pow(d, (float) power) * 255.0;
         }
+    }
+
+    return (unsigned char) d;
+}
 
-        memcpy(tmpdata, ImageData, NPixels * sizeof(unsigned short));
-        std::nth_element(tmpdata, tmpdata + NPixels / 2, tmpdata + NPixels);
-        MedianADU = tmpdata[NPixels / 2];
+inline unsigned char DisplayStretch::Binned(unsigned int v, int blevel, int wlevel, double power)
+{
+    float d = (float) v;
+    float range = (float) (wlevel - blevel);
 
-        delete[] tmpdata;
+    if ((power == 1.0) || (range == 0.0))
+    {
+        range = wlevel;  // Go 0-max
+        if (range == 0.0) range = 0.001;
+        d = (d / range) * 255.0;
+        if (d < 0.0) d = 0.0;
+        else if (d > 255.0) d = 255.0;
     }
     else
     {
-        // Subframe
-
-        unsigned int pixcnt = Subframe.width * Subframe.height;
-        unsigned short *tmpdata = new unsigned short[pixcnt];
+        d = (d - (float) blevel) / range;
+        if (d < 0.0) d = 0.0;
+        else if (d > 1.0) d = 1.0;
+        d = pow(d, (float) power) * 255.0;
+    }
 
-        unsigned short *dst;
+    return (unsigned char) d;
+}
 
-        dst = tmpdata;
-        for (int y = 0; y < Subframe.height; y++)
-        {
-            const unsigned short *src = ImageData + Subframe.x + (Subframe.y + y) * Size.GetWidth();
-            for (int x = 0; x < Subframe.width; x++)
-            {
-                unsigned short d = *src;
-                if (d < MinADU) MinADU = d;
-                if (d > MaxADU) MaxADU = d;
-                *dst++ = *src++;
-            }
-        }
+const unsigned char *DisplayStretch::Get(Mode mode_, int blevel_, int wlevel_, double power_)
+{
+    if (valid && mode == mode_ && blevel == blevel_ && wlevel == wlevel_ && power == power_)
+        return lut;
 
-        dst = new unsigned short[pixcnt];
+    mode = mode_;
+    blevel = blevel_;
+    wlevel = wlevel_;
+    power = power_;
+    valid = true;
 
-        Median3(dst, tmpdata, Subframe.GetSize(), wxRect(Subframe.GetSize()));
+    // every value above the larger of the two levels gives the same result
+    unsigned int const sat = (unsigned int) wxMin(65535, wxMax(1, wxMax(blevel, wlevel)));
 
-        const unsigned short *src = dst;
-        for (unsigned int i = 0; i < pixcnt; i++)
-        {
-            unsigned short d = *src++;
-            if (d < FiltMin) FiltMin = d;
-            if (d > FiltMax) FiltMax = d;
-        }
+    for (unsigned int v = 0; v <= sat; v++)
+        lut[v] = mode == STRETCH_FULL ? Full(v, blevel, wlevel, power) : Binned(v, blevel, wlevel, power);
 
-        memcpy(dst, tmpdata, pixcnt * sizeof(unsigned short));
-        std::nth_element(dst, dst + pixcnt / 2, dst + pixcnt);
-        MedianADU = dst[pixcnt / 2];
+    memset(&lut[sat + 1], lut[sat], 65535 - sat);
 
-        delete[] dst;
-        delete[] tmpdata;
-    }
+    return lut;
 }
 
+enum { DISPLAY_CHUNK = 256 };
+
 bool usImage::CopyToImage(wxImage **rawimg, int blevel, int wlevel, double power)
 {
     wxImage *img = *rawimg;
@@ -165,44 +212,26 @@ bool usImage::CopyToImage(wxImage **rawimg, int blevel, int wlevel, double power
         img = new wxImage(Size.GetWidth(), Size.GetHeight(), false);
     }
 
+    static thread_local std::unique_ptr<DisplayStretch> s_stretch;
+    if (!s_stretch)
+        s_stretch.reset(new DisplayStretch());
+
+    const unsigned char *lut = s_stretch->Get(DisplayStretch::STRETCH_FULL, blevel, wlevel, power);
+    GrayToRgbRowFn const grayToRgb = GetImageKernels().grayToRgbRow;
+
     unsigned char *ImgPtr = img->GetData();
-    unsigned short *RawPtr = ImageData;
+    const unsigned short *RawPtr = ImageData;
 
-    if (power == 1.0 || blevel >= wlevel)
-    {
-        float range = (float) wxMax(1, wlevel);  // Go 0-max
-        for (unsigned int i = 0; i < NPixels; i++, RawPtr++)
-        {
-            float d;
-            if (*RawPtr >= range)
-                d = 255.0;
-            else
-                d = ((float) (*RawPtr) / range) * 255.0;
-
-            *ImgPtr++ = (unsigned char) d;
-            *ImgPtr++ = (unsigned char) d;
-            *ImgPtr++ = (unsigned char) d;
-        }
-    }
-    else
+    // map a chunk of pixels through the table, then expand it to RGB
+    unsigned char gray[DISPLAY_CHUNK];
+    for (unsigned int i = 0; i < NPixels; i += DISPLAY_CHUNK)
     {
-        float range = (float) (wlevel - blevel);
-        for (unsigned int i = 0; i < NPixels; i++, RawPtr++ )
-        {
-            float d;
-            if (*RawPtr <= blevel)
-                d = 0.0;
-            else if (*RawPtr >= wlevel)
-                d = 255.0;
-            else
-            {
-                d = ((float) (*RawPtr) - (float) blevel) / range;
-                d = pow(d, (float) power) * 255.0;
-            }
-            *ImgPtr++ = (unsigned char) d;
-            *ImgPtr++ = (unsigned char) d;
-            *ImgPtr++ = (unsigned char) d;
-        }
+        unsigned int const n = wxMin((unsigned int) DISPLAY_CHUNK, NPixels - i);
+        for (unsigned int j = 0; j < n; j++)
+            gray[j] = lut[RawPtr[j]];
+        grayToRgb(ImgPtr, gray, n);
+        RawPtr += n;
+        ImgPtr += 3 * n;
     }
 
     *rawimg = img;
@@ -211,70 +240,47 @@ bool usImage::CopyToImage(wxImage **rawimg, int blevel, int wlevel, double power
 
 bool usImage::BinnedCopyToImage(wxImage **rawimg, int blevel, int wlevel, double power)
 {
-    wxImage *img;
-    unsigned char *ImgPtr;
-    unsigned short *RawPtr;
-    int x,y;
-    float d;
-    //, s_factor;
-    int full_xsize, full_ysize;
-    int use_xsize, use_ysize;
-
-    full_xsize = Size.GetWidth();
-    full_ysize = Size.GetHeight();
-    use_xsize = full_xsize;
-    use_ysize = full_ysize;
-    if (use_xsize % 2) use_xsize--;
-    if (use_ysize % 2) use_ysize--;
-//  Binsize = 2;
-
-    img = *rawimg;
-    if ((!img->Ok()) || (img->GetWidth() != (full_xsize/2)) || (img->GetHeight() != (full_ysize/2)) ) {  // can't reuse bitmap
+    int full_xsize = Size.GetWidth();
+    int full_ysize = Size.GetHeight();
+    int out_xsize = full_xsize / 2;
+    int out_ysize = full_ysize / 2;
+
+    wxImage *img = *rawimg;
+    if (!img || !img->Ok() || (img->GetWidth() != out_xsize) || (img->GetHeight() != out_ysize)) // can't reuse bitmap
+    {
         delete img;  // Clear out current image if it exists
-        img = new wxImage(full_xsize/2, full_ysize/2, false);
+        img = new wxImage(out_xsize, out_ysize, false);
     }
-    ImgPtr = img->GetData();
-    RawPtr = ImageData;
-//  s_factor = (((float) Max - (float) Min) / 255.0);
-    float range = (float) (wlevel - blevel);
 
-    if ((power == 1.0) || (range == 0.0)) {
-        range = wlevel;  // Go 0-max
-        if (range == 0.0) range = 0.001;
-        for (y=0; y<use_ysize; y+=2) {
-            for (x=0; x<use_xsize; x+=2) {
-                RawPtr = ImageData + x + y*full_xsize;
-                d = (float) (*RawPtr + *(RawPtr+1) + *(RawPtr+full_xsize) + *(RawPtr+1+full_xsize)) / 4.0;
-                d = (d / range) * 255.0;
-                if (d < 0.0) d = 0.0;
-                else if (d > 255.0) d = 255.0;
-                *ImgPtr = (unsigned char) d;
-                ImgPtr++;
-                *ImgPtr = (unsigned char) d;
-                ImgPtr++;
-                *ImgPtr = (unsigned char) d;
-                ImgPtr++;
-            }
-        }
-    }
-    else {
-        for (y=0; y<use_ysize; y+=2) {
-            for (x=0; x<use_xsize; x+=2) {
-                RawPtr = ImageData + x + y*full_xsize;
-                d = (float) (*RawPtr + *(RawPtr+1) + *(RawPtr+full_xsize) + *(RawPtr+1+full_xsize)) / 4.0;
-                d = (d - (float) blevel) / range ;
-                if (d < 0.0) d= 0.0;
-                else if (d > 1.0) d = 1.0;
-                d = pow(d, (float) power) * 255.0;
-                *ImgPtr = (unsigned char) d;
-                ImgPtr++;
-                *ImgPtr = (unsigned char) d;
-                ImgPtr++;
-                *ImgPtr = (unsigned char) d;
-                ImgPtr++;
+    static thread_local std::unique_ptr<DisplayStretch> s_stretch;
+    if (!s_stretch)
+        s_stretch.reset(new DisplayStretch());
+
+    // the table is indexed by the 2x2 mean truncated to an integer ADU
+    const unsigned char *lut = s_stretch->Get(DisplayStretch::STRETCH_BINNED, blevel, wlevel, power);
+    GrayToRgbRowFn const grayToRgb = GetImageKernels().grayToRgbRow;
+
+    unsigned char *ImgPtr = img->GetData();
+
+    unsigned char gray[DISPLAY_CHUNK];
+    for (int y = 0; y < out_ysize; y++)
+    {
+        const unsigned short *r0 = ImageData + 2 * y * full_xsize;
+        const unsigned short *r1 = r0 + full_xsize;
+
+        for (int x = 0; x < out_xsize; x += DISPLAY_CHUNK)
+        {
+            int const n = wxMin((int) DISPLAY_CHUNK, out_xsize - x);
+            for (int j = 0; j < n; j++)
+            {
+                int const k = 2 * (x + j);
+                gray[j] = lut[(r0[k] + r0[k + 1] + r1[k] + r1[k + 1]) >> 2];
             }
+            grayToRgb(ImgPtr, gray, n);
+            ImgPtr += 3 * n;
         }
     }
+
     *rawimg = img;
     return false;
 }
@@ -514,26 +520,52 @@ bool usImage::CopyFrom(const usImage& src)
     return false;
 }
 
+// Rotate the image by theta radians about its origin, after flipping it top to
+// bottom if mirror is set (the geometry of wxImage::Mirror(false) and
+// wxImage::Rotate). The result is the bounding box of the rotated frame. Quarter
+// turns move pixels exactly; other angles are interpolated. Unlike going through
+// an 8-bit wxImage, the full 16-bit range of the data is kept.
 bool usImage::Rotate(double theta, bool mirror)
 {
-    wxImage *pImg = 0;
+    int const w = Size.GetWidth();
+    int const h = Size.GetHeight();
 
-    CalcStats();
+    if (!ImageData || w < 2 || h < 2)
+        return false;
 
-    CopyToImage(&pImg, MinADU, MaxADU, 1.0);
+    if (mirror)
+    {
+        MirrorRows(ImageData, w, h);
+        Subframe = wxRect(0, 0, 0, 0);
+    }
 
-    wxImage mirrored = *pImg;
+    RotateGeometry g;
+    GetRotateGeometry(&g, w, h, theta);
 
-    if (mirror)
+    if (g.quarter == 0)
+        return false;
+
+    if (g.quarter == 2)
     {
-        mirrored = pImg->Mirror(false);
+        std::reverse(ImageData, ImageData + NPixels);
+        Subframe = wxRect(0, 0, 0, 0);
+        return false;
     }
 
-    wxImage rotated = mirrored.Rotate(theta, wxPoint(0,0));
+    usImage rotated;
+    if (rotated.Init(g.width, g.height))
+        return true;
 
-    CopyFromImage(rotated);
+    ParallelFor(g.height, 16, [&](int r0, int r1) {
+        RotateRows(rotated.ImageData, ImageData, w, h, g, r0, r1);
+    });
 
-    delete pImg;
+    // take over the rotated pixels; the old buffer goes back to the pool with rotated
+    SwapImageData(rotated);
+    std::swap(NPixels, rotated.NPixels);
+    Size = rotated.Size;
+    Subframe = wxRect(0, 0, 0, 0);
+    MinADU = MaxADU = MedianADU = 0;
 
     return false;
 }
@@ -70,7 +70,7 @@ public:
         FrameNum(0)
     {
     }
-    ~usImage() { delete[] ImageData; }
+    ~usImage() { ImagePool::Release(ImageData, NPixels); }
 
     bool                Init(const wxSize& size);
     bool                Init(int width, int height) { return Init(wxSize(width, height)); }
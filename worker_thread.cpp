@@ -39,7 +39,11 @@ WorkerThread::WorkerThread(MyFrame *pFrame)
     : wxThread(wxTHREAD_JOINABLE),
       m_interruptRequested(0),
       m_killable(true),
-      m_skipSendExposeComplete(false)
+      m_skipSendExposeComplete(false),
+      m_droppedFrames(0),
+      m_armed(false),
+      m_armedDuration(0),
+      m_armedOptions(0)
 {
     m_pFrame = pFrame;
     Debug.Write("WorkerThread constructor called\n");
@@ -48,6 +52,11 @@ WorkerThread::WorkerThread(MyFrame *pFrame)
 WorkerThread::~WorkerThread(void)
 {
     Debug.Write("WorkerThread destructor called\n");
+
+    // release any frames the GUI thread did not get to
+    EXPOSED_FRAME frame;
+    while (m_exposedFrames.pop(&frame))
+        delete frame.pImage;
 }
 
 void WorkerThread::EnqueueMessage(const WORKER_THREAD_REQUEST& message)
@@ -130,6 +139,88 @@ unsigned int WorkerThread::MilliSleep(int ms, unsigned int checkInterrupts)
     return 0;
 }
 
+/*
+ * Ask the worker to start another exposure with the given parameters as soon as
+ * the exposure in progress has been read out, rather than waiting for the GUI
+ * thread to process the frame and schedule the next one. The request is
+ * consumed by the next readout; the GUI thread re-arms after processing each
+ * frame. Frames for which the worker started the next exposure are flagged with
+ * EXPOSED_FRAME::nextArmed.
+ */
+void WorkerThread::ArmNextExposure(int exposureDuration, int exposureOptions, const wxRect& subframe)
+{
+    wxCriticalSectionLocker lock(m_armLock);
+    m_armed = true;
+    m_armedDuration = exposureDuration;
+    m_armedOptions = exposureOptions;
+    m_armedSubframe = subframe;
+}
+
+void WorkerThread::DisarmNextExposure()
+{
+    wxCriticalSectionLocker lock(m_armLock);
+    m_armed = false;
+}
+
+// called by the worker thread right after a successful readout; returns true if
+// the next exposure was queued
+bool WorkerThread::StartArmedExposure()
+{
+    wxCriticalSectionLocker lock(m_armLock);
+
+    if (!m_armed || m_interruptRequested)
+        return false;
+
+    // the frame just read out and the one being started must both fit in the ring
+    if (m_exposedFrames.size() + 2 > m_exposedFrames.capacity())
+    {
+        Debug.Write("worker thread not pre-arming exposure, frame ring full\n");
+        return false;
+    }
+
+    m_armed = false;
+
+    WORKER_THREAD_REQUEST message;
+    memset(&message, 0, sizeof(message));
+
+    Debug.Write("Enqueuing pre-armed Expose request\n");
+
+    message.request                      = REQUEST_EXPOSE;
+    message.args.expose.pImage           = new usImage();
+    message.args.expose.exposureDuration = m_armedDuration;
+    message.args.expose.options          = m_armedOptions;
+    message.args.expose.subframe         = m_armedSubframe;
+    message.args.expose.pSemaphore       = 0;
+
+    // unlike EnqueueWorkerThreadExposeRequest, leave INT_STOP alone so that a stop
+    // requested by the GUI thread interrupts the pre-armed exposure
+    EnqueueMessage(message);
+
+    return true;
+}
+
+bool WorkerThread::PopExposedFrame(EXPOSED_FRAME *frame)
+{
+    if (m_exposedFrames.pop(frame))
+        return true;
+
+    // the frames that made it into the ring come first, then an error for each
+    // frame that did not
+    unsigned int dropped = m_droppedFrames.load();
+    while (dropped > 0)
+    {
+        if (m_droppedFrames.compare_exchange_weak(dropped, dropped - 1))
+        {
+            frame->pImage = nullptr;
+            frame->error = true;
+            frame->nextArmed = false;
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void WorkerThread::SetSkipExposeComplete()
 {
     Debug.Write("worker thread setting skip send exposure complete\n");
@@ -180,6 +271,14 @@ bool WorkerThread::HandleExpose(EXPOSE_REQUEST *req)
             throw ERROR_INFO("Time lapse interrupted");
         }
 
+        // with fused preprocessing the dark is subtracted below, in the same pass
+        // as the noise reduction, rather than by the camera. Drivers that rework
+        // the frame after dark subtraction keep doing the subtraction themselves.
+        bool const fused = m_pFrame->GetFusedPreprocessing() && pCamera->CanPreprocessFrame();
+        bool const subtractDark = (req->options & CAPTURE_SUBTRACT_DARK) != 0;
+        if (fused)
+            req->options &= ~CAPTURE_SUBTRACT_DARK;
+
         if (pCamera->HasNonGuiCapture())
         {
             Debug.Write(wxString::Format("Handling exposure in thread, d=%d o=%x r=(%d,%d,%d,%d)\n", req->exposureDuration,
@@ -215,19 +314,26 @@ bool WorkerThread::HandleExpose(EXPOSE_REQUEST *req)
         {
             CameraROITest(req->pImage);
 
-            switch (m_pFrame->GetNoiseReductionMethod())
+            if (fused)
             {
-                case NR_NONE:
-                    break;
-                case NR_2x2MEAN:
-                    QuickLRecon(*req->pImage);
-                    break;
-                case NR_3x3MEDIAN:
-                    Median3(*req->pImage);
-                    break;
+                pCamera->PreprocessFrame(*req->pImage, subtractDark, m_pFrame->GetNoiseReductionMethod());
             }
+            else
+            {
+                switch (m_pFrame->GetNoiseReductionMethod())
+                {
+                    case NR_NONE:
+                        break;
+                    case NR_2x2MEAN:
+                        QuickLRecon(*req->pImage);
+                        break;
+                    case NR_3x3MEDIAN:
+                        Median3(*req->pImage);
+                        break;
+                }
 
-            req->pImage->CalcStats();
+                req->pImage->CalcStats();
+            }
         }
     }
     catch (const wxString& Msg)
@@ -239,12 +345,26 @@ bool WorkerThread::HandleExpose(EXPOSE_REQUEST *req)
     return  bError;
 }
 
-void WorkerThread::SendWorkerThreadExposeComplete(usImage *pImage, bool bError)
+void WorkerThread::SendWorkerThreadExposeComplete(usImage *pImage, bool bError, bool nextArmed)
 {
-    wxThreadEvent *event = new wxThreadEvent(wxEVT_THREAD, MYFRAME_WORKER_THREAD_EXPOSE_COMPLETE);
-    event->SetPayload<usImage *>(pImage);
-    event->SetInt(bError);
-    wxQueueEvent(m_pFrame, event);
+    EXPOSED_FRAME frame;
+    frame.pImage = pImage;
+    frame.error = bError;
+    frame.nextArmed = nextArmed;
+
+    // StartArmedExposure leaves room for this frame, and otherwise at most one
+    // exposure is outstanding, so the ring should never be full here. If it is,
+    // drop the frame and have the GUI thread see a capture error so that the
+    // capture loop stops cleanly instead of waiting for a frame that never comes.
+    if (!m_exposedFrames.push(frame))
+    {
+        Debug.Write(wxString::Format("worker thread: exposed frame ring full, dropping frame (error=%d)\n", bError));
+        delete pImage;
+        ++m_droppedFrames;
+    }
+
+    // the event just wakes up the GUI thread, the frame travels through the ring
+    wxQueueEvent(m_pFrame, new wxThreadEvent(wxEVT_THREAD, MYFRAME_WORKER_THREAD_EXPOSE_COMPLETE));
 }
 
 /*************      Move       **************************/
@@ -430,7 +550,10 @@ wxThread::ExitCode WorkerThread::Entry()
                     m_skipSendExposeComplete = false;
                 }
                 else
-                    SendWorkerThreadExposeComplete(message.args.expose.pImage, bError);
+                {
+                    bool nextArmed = !bError && StartArmedExposure();
+                    SendWorkerThreadExposeComplete(message.args.expose.pImage, bError, nextArmed);
+                }
                 break;
 
             case REQUEST_MOVE: {
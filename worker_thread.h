@@ -66,6 +66,19 @@ struct EXPOSE_REQUEST
     wxSemaphore     *pSemaphore;
 };
 
+/*
+ * A completed exposure, handed from the primary worker thread to the GUI thread
+ * through a lock-free ring. nextArmed is set when the worker started the next
+ * exposure as soon as this one was read out (see WorkerThread::ArmNextExposure),
+ * in which case an exposure is still pending.
+ */
+struct EXPOSED_FRAME
+{
+    usImage         *pImage;
+    bool             error;
+    bool             nextArmed;
+};
+
 struct MOVE_REQUEST
 {
     Mount             *mount;
@@ -120,6 +133,20 @@ class WorkerThread : public wxThread
     wxMessageQueue<WORKER_THREAD_REQUEST> m_lowPriorityQueue;
     bool m_skipSendExposeComplete;
 
+    // completed exposures waiting for the GUI thread
+    spsc_ring<EXPOSED_FRAME, 4> m_exposedFrames;
+    // frames discarded because the ring was full; each is reported to the GUI
+    // thread as a capture error once the ring has drained
+    std::atomic<unsigned int> m_droppedFrames;
+
+    // parameters of the exposure to start right after the current one is read
+    // out, set by the GUI thread; protected by m_armLock
+    wxCriticalSection m_armLock;
+    bool m_armed;
+    int m_armedDuration;
+    int m_armedOptions;
+    wxRect m_armedSubframe;
+
 public:
 
     enum InterruptBits {
@@ -182,9 +209,13 @@ protected:
 public:
     void EnqueueWorkerThreadExposeRequest(usImage *pImage, int exposureDuration, int exposureOptions, const wxRect& subframe);
     void SetSkipExposeComplete();
+    void ArmNextExposure(int exposureDuration, int exposureOptions, const wxRect& subframe);
+    void DisarmNextExposure();
+    bool PopExposedFrame(EXPOSED_FRAME *frame);
 protected:
     bool HandleExpose(EXPOSE_REQUEST *args);
-    void SendWorkerThreadExposeComplete(usImage *pImage, bool bError);
+    bool StartArmedExposure();
+    void SendWorkerThreadExposeComplete(usImage *pImage, bool bError, bool nextArmed);
     // in the frame class: void MyFrame::OnWorkerThreadExposeComplete(wxThreadEvent& event);
 
     /*************      Guide       **************************/